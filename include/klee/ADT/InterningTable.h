@@ -0,0 +1,144 @@
+//===-- InterningTable.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_INTERNINGTABLE_H
+#define KLEE_INTERNINGTABLE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace klee {
+
+/// InterningTable - An open-addressing (linear probing) hash set of
+/// pointers to interned objects.
+///
+/// Unlike std::unordered_set, entries are stored inline together with their
+/// hash, so probing compares hashes before calling the (deep) equality
+/// predicate and growing the table never recomputes hashes. Removal leaves a
+/// tombstone, which is reused by later insertions and dropped on rehash.
+template <typename T, typename HASH, typename PRED> class InterningTable {
+private:
+  struct Slot {
+    T *value = nullptr;
+    unsigned hash = 0;
+  };
+
+  static T *tombstone() { return reinterpret_cast<T *>(uintptr_t(1)); }
+
+  static bool isLive(const Slot &slot) {
+    return slot.value != nullptr && slot.value != tombstone();
+  }
+
+  std::vector<Slot> slots;
+  size_t live = 0;
+  size_t used = 0; // live entries and tombstones
+  HASH hasher;
+  PRED equals;
+
+  void rehash(size_t capacity) {
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    used = live;
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : old) {
+      if (!isLive(slot))
+        continue;
+      size_t i = slot.hash & mask;
+      while (slots[i].value)
+        i = (i + 1) & mask;
+      slots[i] = slot;
+    }
+  }
+
+  /// Keep at most 3/4 of the slots in use.
+  void reserveOne() {
+    if (slots.empty()) {
+      slots.resize(64);
+      return;
+    }
+    if ((used + 1) * 4 <= slots.size() * 3)
+      return;
+    // Grow only if live entries need it, otherwise just drop tombstones
+    rehash((live + 1) * 2 > slots.size() ? slots.size() * 2 : slots.size());
+  }
+
+public:
+  InterningTable() = default;
+  InterningTable(const InterningTable &) = delete;
+  InterningTable &operator=(const InterningTable &) = delete;
+
+  size_t size() const { return live; }
+  bool empty() const { return live == 0; }
+  size_t capacity() const { return slots.size(); }
+
+  /// Insert `value` unless an equal value is present.
+  ///
+  /// \return The interned value, and true iff `value` was inserted.
+  std::pair<T *, bool> insert(T *value) {
+    reserveOne();
+    unsigned hash = hasher(value);
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    Slot *free = nullptr;
+    for (;; i = (i + 1) & mask) {
+      Slot &slot = slots[i];
+      if (!slot.value)
+        break;
+      if (slot.value == tombstone()) {
+        if (!free)
+          free = &slot;
+      } else if (slot.hash == hash && equals(slot.value, value)) {
+        return {slot.value, false};
+      }
+    }
+    if (!free) {
+      free = &slots[i];
+      ++used;
+    }
+    free->value = value;
+    free->hash = hash;
+    ++live;
+    return {value, true};
+  }
+
+  /// Remove the entry holding exactly `value`.
+  ///
+  /// \return True iff `value` was present.
+  bool erase(T *value) {
+    if (slots.empty())
+      return false;
+    unsigned hash = hasher(value);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; slots[i].value; i = (i + 1) & mask) {
+      if (slots[i].value == value) {
+        slots[i].value = tombstone();
+        --live;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Call `f` on every entry, then remove all of them.
+  template <typename F> void clear(F f) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    live = used = 0;
+    for (const Slot &slot : old)
+      if (isLive(slot))
+        f(slot.value);
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_INTERNINGTABLE_H */
@@ -37,6 +37,9 @@ public:
 
   void insert(const std::set<K> &set, const V &value);
 
+  /// Remove the value of exactly this set, if any
+  void erase(const std::set<K> &set);
+
   V *lookup(const std::set<K> &set);
 
   iterator begin();
@@ -57,6 +60,8 @@ private:
 
   Node root;
 
+  bool erase(Node *n, typename std::set<K>::const_iterator begin,
+             typename std::set<K>::const_iterator end);
   template <class Iterator, class Vector>
   void findSubsets(Node *n, const std::set<K> &accum, Iterator begin,
                    Iterator end, Vector &resultsOut);
@@ -179,6 +184,26 @@ void MapOfSets<K, V>::insert(const std::set<K> &set, const V &value) {
   n->value = value;
 }
 
+template <class K, class V>
+void MapOfSets<K, V>::erase(const std::set<K> &set) {
+  erase(&root, set.begin(), set.end());
+}
+
+/// Returns whether `n` holds no set anymore, so that it can be removed
+template <class K, class V>
+bool MapOfSets<K, V>::erase(Node *n, typename std::set<K>::const_iterator begin,
+                            typename std::set<K>::const_iterator end) {
+  if (begin == end) {
+    n->isEndOfSet = false;
+    n->value = V();
+  } else {
+    typename Node::children_ty::iterator kit = n->children.find(*begin);
+    if (kit != n->children.end() && erase(&kit->second, ++begin, end))
+      n->children.erase(kit);
+  }
+  return !n->isEndOfSet && n->children.empty();
+}
+
 template <class K, class V> V *MapOfSets<K, V>::lookup(const std::set<K> &set) {
   Node *n = &root;
   for (typename std::set<K>::const_iterator it = set.begin(), ie = set.end();
@@ -0,0 +1,185 @@
+//===-- PrefixTrie.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PREFIXTRIE_H
+#define KLEE_PREFIXTRIE_H
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace klee {
+
+/// PrefixTrie - Indexes values by sequences of keys, so that the value whose
+/// sequence shares the longest prefix with a given sequence is found in time
+/// linear in the length of that sequence.
+///
+/// Every value is stored at most once. Each node remembers the value of its
+/// subtree whose sequence is the shortest, which is the one closest to any
+/// sequence that leaves the trie at that node.
+template <typename K, typename V, typename HASH = std::hash<K>,
+          typename PRED = std::equal_to<K>>
+class PrefixTrie {
+private:
+  struct Node {
+    Node *parent = nullptr;
+    const K *key = nullptr;
+    size_t depth = 0;
+    std::unordered_map<K, std::unique_ptr<Node>, HASH, PRED> children;
+    /// Values whose sequence ends at this node
+    std::vector<V> values;
+    /// The value of the subtree with the shortest sequence
+    const V *closest = nullptr;
+    size_t closestDepth = 0;
+  };
+
+  Node root;
+  std::unordered_map<V, Node *> nodes;
+
+  /// Recompute closest values from `node` up to the root.
+  void update(Node *node) {
+    for (; node; node = node->parent) {
+      node->closest = nullptr;
+      if (!node->values.empty()) {
+        node->closest = &node->values.back();
+        node->closestDepth = node->depth;
+        continue;
+      }
+      for (const auto &child : node->children) {
+        const Node *c = child.second.get();
+        if (c->closest &&
+            (!node->closest || c->closestDepth < node->closestDepth)) {
+          node->closest = c->closest;
+          node->closestDepth = c->closestDepth;
+        }
+      }
+    }
+  }
+
+public:
+  PrefixTrie() = default;
+  PrefixTrie(const PrefixTrie &) = delete;
+  PrefixTrie &operator=(const PrefixTrie &) = delete;
+
+  size_t size() const { return nodes.size(); }
+  bool empty() const { return nodes.empty(); }
+
+  /// Index `value` by the sequence [begin, end).
+  template <typename InputIterator>
+  void insert(InputIterator begin, InputIterator end, const V &value) {
+    assert(!nodes.count(value) && "value is already indexed");
+    Node *node = &root;
+    for (; begin != end; ++begin) {
+      auto it = node->children.find(*begin);
+      if (it == node->children.end()) {
+        auto child = std::make_unique<Node>();
+        child->parent = node;
+        child->depth = node->depth + 1;
+        it = node->children.emplace(*begin, std::move(child)).first;
+        it->second->key = &it->first;
+      }
+      node = it->second.get();
+    }
+    node->values.push_back(value);
+    nodes.emplace(value, node);
+    update(node);
+  }
+
+  /// Remove `value` from the index.
+  void erase(const V &value) {
+    auto found = nodes.find(value);
+    assert(found != nodes.end() && "value is not indexed");
+    Node *node = found->second;
+    nodes.erase(found);
+    for (auto it = node->values.begin(); it != node->values.end(); ++it) {
+      if (*it == value) {
+        node->values.erase(it);
+        break;
+      }
+    }
+    // Drop the nodes which no longer lead to any value
+    while (node != &root && node->values.empty() && node->children.empty()) {
+      Node *parent = node->parent;
+      K key = *node->key;
+      parent->children.erase(key);
+      node = parent;
+    }
+    update(node);
+  }
+
+  /// Find the value closest to the sequence [begin, end).
+  ///
+  /// \param [out] value - If some value's sequence is a prefix of [begin,
+  /// end), the one with the longest such sequence. Otherwise, among values
+  /// sharing the longest prefix with [begin, end), the one with the shortest
+  /// sequence.
+  /// \param [out] isPrefix - True iff the value's sequence is a prefix of
+  /// [begin, end).
+  /// \return False iff the trie is empty.
+  template <typename InputIterator>
+  bool find(InputIterator begin, InputIterator end, V &value,
+            bool &isPrefix) const {
+    const Node *node = &root;
+    const Node *prefix = root.values.empty() ? nullptr : &root;
+    for (; begin != end; ++begin) {
+      auto it = node->children.find(*begin);
+      if (it == node->children.end())
+        break;
+      node = it->second.get();
+      if (!node->values.empty())
+        prefix = node;
+    }
+    if (prefix) {
+      value = prefix->values.back();
+      isPrefix = true;
+      return true;
+    }
+    if (!node->closest)
+      return false;
+    value = *node->closest;
+    isPrefix = false;
+    return true;
+  }
+
+  /// Collect the values worth scoring against the sequence [begin, end):
+  /// those whose sequence is a prefix of it and, for every node on the longest
+  /// shared prefix, the value of its subtree with the shortest sequence.
+  /// Each value is reported once, so at most size() values are collected.
+  template <typename InputIterator>
+  void candidates(InputIterator begin, InputIterator end,
+                  std::vector<V> &result) const {
+    std::unordered_set<V> seen;
+    auto add = [&](const V &value) {
+      if (seen.insert(value).second)
+        result.push_back(value);
+    };
+    const Node *node = &root;
+    for (;;) {
+      for (const V &value : node->values)
+        add(value);
+      if (node->closest)
+        add(*node->closest);
+      if (begin == end)
+        break;
+      auto it = node->children.find(*begin);
+      if (it == node->children.end())
+        break;
+      node = it->second.get();
+      ++begin;
+    }
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_PREFIXTRIE_H */
@@ -2,6 +2,7 @@
 #define KLEE_STORAGEADAPTER_H
 
 #include "klee/ADT/PersistentHashMap.h"
+#include "klee/ADT/Ref.h"
 #include "klee/Support/CompilerWarning.h"
 
 #ifndef IMMER_NO_EXCEPTIONS
@@ -11,16 +12,24 @@
 #include <immer/vector.hpp>
 #include <immer/vector_transient.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
 };
 
 namespace klee {
-enum class StorageIteratorKind { UMap, PersistentUMap, SparseArray };
+enum class StorageIteratorKind {
+  UMap,
+  PersistentUMap,
+  SparseArray,
+  PagedArray
+};
 
 template <typename ValueType> struct UnorderedMapAdapterIterator {
   using storage_ty = std::unordered_map<size_t, ValueType>;
@@ -95,11 +104,34 @@ public:
   SparseArrayAdapterIterator(storage_ty it) : it(it) {}
 };
 
+template <typename ValueType, typename Eq> struct PagedArrayAdapter;
+
+template <typename ValueType, typename Eq = std::equal_to<ValueType>>
+struct PagedArrayAdapterIterator {
+  using storage_ty = const PagedArrayAdapter<ValueType, Eq> *;
+  using value_ty = std::pair<size_t, ValueType>;
+  storage_ty storage;
+  size_t index;
+
+public:
+  PagedArrayAdapterIterator(storage_ty storage, size_t index)
+      : storage(storage), index(storage->nextNonDefault(index)) {}
+  PagedArrayAdapterIterator &operator++() {
+    index = storage->nextNonDefault(index + 1);
+    return *this;
+  }
+  value_ty operator*() { return {index, storage->at(index)}; }
+  bool operator!=(const PagedArrayAdapterIterator &other) const {
+    return other.storage != storage || other.index != index;
+  }
+};
+
 template <typename ValueType, typename Eq = std::equal_to<ValueType>>
 union StorageIterator {
   UnorderedMapAdapterIterator<ValueType> umaIt;
   PersistentMapAdapterIterator<ValueType> pumaIt;
   SparseArrayAdapterIterator<ValueType, Eq> saaIt;
+  PagedArrayAdapterIterator<ValueType, Eq> paaIt;
   ~StorageIterator() {}
   StorageIterator(const UnorderedMapAdapterIterator<ValueType> &other)
       : umaIt(other) {}
@@ -107,6 +139,8 @@ union StorageIterator {
       : pumaIt(other) {}
   StorageIterator(const SparseArrayAdapterIterator<ValueType, Eq> &other)
       : saaIt(other) {}
+  StorageIterator(const PagedArrayAdapterIterator<ValueType, Eq> &other)
+      : paaIt(other) {}
 };
 
 template <typename ValueType, typename Eq = std::equal_to<ValueType>>
@@ -124,6 +158,8 @@ struct StorageAdapter {
         : kind(StorageIteratorKind::PersistentUMap), impl(impl) {}
     iterator(const SparseArrayAdapterIterator<ValueType, Eq> &impl)
         : kind(StorageIteratorKind::SparseArray), impl(impl) {}
+    iterator(const PagedArrayAdapterIterator<ValueType, Eq> &impl)
+        : kind(StorageIteratorKind::PagedArray), impl(impl) {}
     iterator(iterator const &right) : kind(right.kind) {
       switch (kind) {
       case klee::StorageIteratorKind::UMap: {
@@ -138,6 +174,10 @@ struct StorageAdapter {
         impl.saaIt = right.impl.saaIt;
         break;
       }
+      case klee::StorageIteratorKind::PagedArray: {
+        impl.paaIt = right.impl.paaIt;
+        break;
+      }
       default:
         assert(0 && "unhandled iterator kind");
         unreachable();
@@ -157,6 +197,10 @@ struct StorageAdapter {
         impl.saaIt.~SparseArrayAdapterIterator();
         break;
       }
+      case klee::StorageIteratorKind::PagedArray: {
+        impl.paaIt.~PagedArrayAdapterIterator();
+        break;
+      }
       default:
         assert(0 && "unhandled iterator kind");
         unreachable();
@@ -178,6 +222,10 @@ struct StorageAdapter {
         ++impl.saaIt;
         break;
       }
+      case klee::StorageIteratorKind::PagedArray: {
+        ++impl.paaIt;
+        break;
+      }
       default:
         assert(0 && "unhandled iterator kind");
         unreachable();
@@ -195,6 +243,9 @@ struct StorageAdapter {
       case klee::StorageIteratorKind::SparseArray: {
         return *impl.saaIt;
       }
+      case klee::StorageIteratorKind::PagedArray: {
+        return *impl.paaIt;
+      }
       default:
         assert(0 && "unhandled iterator kind");
         unreachable();
@@ -211,6 +262,9 @@ struct StorageAdapter {
       case klee::StorageIteratorKind::SparseArray: {
         return impl.saaIt != other.impl.saaIt;
       }
+      case klee::StorageIteratorKind::PagedArray: {
+        return impl.paaIt != other.impl.paaIt;
+      }
       default:
         assert(0 && "unhandled iterator kind");
         unreachable();
@@ -401,6 +455,140 @@ public:
   size_t size() const override { return nonDefaultValuesCount; }
 };
 
+/// PagedArrayAdapter - A fixed-size array split into pages which are shared
+/// between copies and copied on the first write.
+///
+/// Copying the adapter copies only the page table, and pages holding nothing
+/// but the default value are not allocated at all. A copy of a large object
+/// thus costs one pointer per page, and every page written afterwards costs
+/// one page copy.
+template <typename ValueType, typename Eq = std::equal_to<ValueType>>
+struct PagedArrayAdapter : public StorageAdapter<ValueType, Eq> {
+  static constexpr size_t PageSize = 256;
+
+  using base_ty = StorageAdapter<ValueType, Eq>;
+  using iterator = typename base_ty::iterator;
+  struct constructor {
+    size_t storageSize;
+    constructor(size_t storageSize) : storageSize(storageSize) {}
+    PagedArrayAdapter<ValueType, Eq>
+    operator()(const ValueType &defaultValue) const {
+      return PagedArrayAdapter<ValueType, Eq>(defaultValue, storageSize);
+    }
+  };
+
+private:
+  struct Page {
+    class ReferenceCounter _refCount;
+    ValueType values[PageSize];
+    size_t nonDefaultValuesCount = 0;
+
+    explicit Page(const ValueType &defaultValue) {
+      for (size_t i = 0; i < PageSize; ++i) {
+        values[i] = defaultValue;
+      }
+    }
+  };
+
+  std::vector<ref<Page>> pages;
+  size_t storageSize;
+  ValueType defaultValue;
+  size_t nonDefaultValuesCount;
+
+  /// The page holding `key`, private to this adapter.
+  Page &writablePage(size_t key) {
+    ref<Page> &page = pages[key / PageSize];
+    if (page.isNull()) {
+      page = new Page(defaultValue);
+    } else if (page->_refCount.getCount() > 1) {
+      page = new Page(*page);
+    }
+    return *page;
+  }
+
+public:
+  PagedArrayAdapter(const ValueType &defaultValue, size_t storageSize)
+      : pages((storageSize + PageSize - 1) / PageSize),
+        storageSize(storageSize), defaultValue(defaultValue),
+        nonDefaultValuesCount(0) {}
+
+  /// The first key from `key` on holding a value other than the default, or
+  /// the size of the array if there is none.
+  size_t nextNonDefault(size_t key) const {
+    while (key < storageSize) {
+      const ref<Page> &page = pages[key / PageSize];
+      size_t pageEnd = std::min(storageSize, (key / PageSize + 1) * PageSize);
+      if (!page.isNull() && page->nonDefaultValuesCount != 0) {
+        for (; key < pageEnd; ++key) {
+          if (!Eq()(page->values[key % PageSize], defaultValue)) {
+            return key;
+          }
+        }
+      }
+      key = pageEnd;
+    }
+    return storageSize;
+  }
+
+  bool contains(size_t key) const override { return lookup(key) != nullptr; }
+  iterator begin() const override {
+    return iterator(PagedArrayAdapterIterator<ValueType, Eq>(this, 0));
+  }
+  iterator end() const override {
+    return iterator(
+        PagedArrayAdapterIterator<ValueType, Eq>(this, storageSize));
+  }
+  const ValueType *lookup(size_t key) const override {
+    if (key >= storageSize) {
+      return nullptr;
+    }
+    const ref<Page> &page = pages[key / PageSize];
+    if (page.isNull() || Eq()(page->values[key % PageSize], defaultValue)) {
+      return nullptr;
+    }
+    return &page->values[key % PageSize];
+  }
+  bool empty() const override { return nonDefaultValuesCount == 0; }
+  void set(size_t key, const ValueType &value) override {
+    assert(key < storageSize && "key is out of bounds");
+    bool newDefault = Eq()(value, defaultValue);
+    if (newDefault && !lookup(key)) {
+      return;
+    }
+    if (newDefault) {
+      remove(key);
+      return;
+    }
+    Page &page = writablePage(key);
+    ValueType &slot = page.values[key % PageSize];
+    if (Eq()(slot, defaultValue)) {
+      ++page.nonDefaultValuesCount;
+      ++nonDefaultValuesCount;
+    }
+    slot = value;
+  }
+  void remove(size_t key) override {
+    if (!lookup(key)) {
+      return;
+    }
+    Page &page = writablePage(key);
+    page.values[key % PageSize] = defaultValue;
+    --nonDefaultValuesCount;
+    if (--page.nonDefaultValuesCount == 0) {
+      pages[key / PageSize] = ref<Page>();
+    }
+  }
+  const ValueType &at(size_t key) const override {
+    const ref<Page> &page = pages[key / PageSize];
+    return page.isNull() ? defaultValue : page->values[key % PageSize];
+  }
+  void clear() override {
+    pages.assign(pages.size(), ref<Page>());
+    nonDefaultValuesCount = 0;
+  }
+  size_t size() const override { return nonDefaultValuesCount; }
+};
+
 } // namespace klee
 
 #endif
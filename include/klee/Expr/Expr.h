@@ -10,6 +10,7 @@
 #ifndef KLEE_EXPR_H
 #define KLEE_EXPR_H
 
+#include "klee/ADT/InterningTable.h"
 #include "klee/ADT/Ref.h"
 #include "klee/Expr/SymbolicSource.h"
 
@@ -121,16 +122,12 @@ protected:
     }
   };
 
-  typedef std::unordered_set<Expr *, ExprHash, ExprCmp> CacheType;
+  typedef InterningTable<Expr, ExprHash, ExprCmp> CacheType;
 
   struct ExprCacheSet {
     CacheType cache;
     ~ExprCacheSet() {
-      while (cache.size() != 0) {
-        ref<Expr> tmp = *cache.begin();
-        tmp->isCached = false;
-        cache.erase(cache.begin());
-      }
+      cache.clear([](Expr *e) { e->isCached = false; });
     }
   };
 
@@ -158,6 +155,8 @@ protected:
   static ExprCacheSet cachedExpressions;
   static ConstantExprCacheSet cachedConstantExpressions;
   static ref<Expr> createCachedExpr(ref<Expr> e);
+  /// Account the memory of a newly interned node to its kind.
+  static void recordAllocation(const Expr *e);
   bool isCached = false;
   bool toBeCleared = false;
 
@@ -316,6 +315,14 @@ public:
   Expr() { Expr::count++; }
   virtual ~Expr();
 
+  /// Expression nodes are allocated from size-class slabs, see ExprAllocator.
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+
+  /// Print the bytes allocated for interned nodes of each kind and for
+  /// update nodes by the calling thread.
+  static void printAllocationStats(llvm::raw_ostream &os);
+
   virtual Kind getKind() const = 0;
   virtual Width getWidth() const = 0;
   ByteWidth getByteWidth() const;
@@ -628,6 +635,12 @@ public:
   UpdateNode() = delete;
   ~UpdateNode() = default;
 
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+
+  /// Bytes allocated for update nodes by the calling thread.
+  static uint64_t allocatedBytes();
+
   unsigned computeHash();
   unsigned computeHeight();
 };
@@ -1465,6 +1478,19 @@ private:
 
   bool mIsFloat;
 
+  /// Direct-mapped front of cachedConstantExpressions for values of at most
+  /// 64 bits, so that concrete arithmetic finds its result without hashing
+  /// an APInt. Entries do not own their constants: a constant clears its
+  /// slot when it is destroyed.
+  static const unsigned SmallConstantSlots = 1 << 12;
+  static ConstantExpr *smallConstants[SmallConstantSlots];
+
+  static unsigned smallConstantSlot(uint64_t v, Width w) {
+    return static_cast<unsigned>((v ^ (v >> 29) ^ (w * MAGIC_HASH_CONSTANT)) *
+                                 0x9E3779B1U) >>
+           20;
+  }
+
   ConstantExpr(const llvm::APInt &v, bool isFloat = false)
       : value(v), mIsFloat(isFloat) {
     if (mIsFloat) {
@@ -1538,6 +1564,15 @@ public:
   void toMemory(void *address);
 
   static ref<ConstantExpr> alloc(const llvm::APInt &v) {
+    ConstantExpr **slot = nullptr;
+    if (v.getBitWidth() <= 64) {
+      slot = &smallConstants[smallConstantSlot(v.getZExtValue(),
+                                               v.getBitWidth())];
+      if (*slot && (*slot)->value.getBitWidth() == v.getBitWidth() &&
+          (*slot)->value.getZExtValue() == v.getZExtValue())
+        return *slot;
+    }
+
     auto success = cachedConstantExpressions.cache.find(v);
     if (success == cachedConstantExpressions.cache.end()) {
       // Cache miss
@@ -1545,9 +1580,14 @@ public:
       r->computeHash();
       r->computeHeight();
       r->isCached = true;
+      recordAllocation(r.get());
       cachedConstantExpressions.cache[v] = r.get();
+      if (slot)
+        *slot = r.get();
       return r;
     }
+    if (slot)
+      *slot = success->second;
     return success->second;
   }
 
@@ -1662,6 +1702,13 @@ public:
   ref<ConstantExpr> Neg();
   ref<ConstantExpr> Not();
 
+  /// Compute the integer arithmetic, bitwise operation or comparison `kind`
+  /// on the values `left` and `right` of `width` bits, at most 64, like the
+  /// operations above but on machine words. Returns null for other kinds
+  /// and for divisions by zero.
+  static ref<ConstantExpr> evaluate(Kind kind, Width width, uint64_t left,
+                                    uint64_t right);
+
   // Get the representation of NaN that should be used. There are multiple
   // binary representations for NaN but we need try to use the same
   // representation for consistency with the solver.
@@ -13,8 +13,11 @@
 #include "KModule.h"
 #include "KValue.h"
 
+#include "klee/Expr/Expr.h"
+
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
@@ -72,6 +75,14 @@ struct KInstruction : public KValue {
   int *operands;
   KBlock *parent;
 
+  /// The operation, decoded once from the LLVM instruction, if it is a
+  /// binary operation or comparison on integers of at most 64 bits, which
+  /// the executor computes on machine words when both operands are concrete
+  /// (see ConstantExpr::evaluate)
+  Expr::Kind concreteKind = Expr::InvalidKind;
+  /// The width of the operands of concreteKind
+  std::uint8_t concreteWidth = 0;
+
 private:
   // Instruction index in the basic block
   const unsigned globalIndex;
@@ -23,11 +23,15 @@ const char ALL_QUERIES_SMT2_FILE_NAME[] = "all-queries.smt2";
 const char SOLVER_QUERIES_SMT2_FILE_NAME[] = "solver-queries.smt2";
 const char ALL_QUERIES_KQUERY_FILE_NAME[] = "all-queries.kquery";
 const char SOLVER_QUERIES_KQUERY_FILE_NAME[] = "solver-queries.kquery";
+const char ALL_QUERIES_BINARY_FILE_NAME[] = "all-queries.kqlog";
+const char SOLVER_QUERIES_BINARY_FILE_NAME[] = "solver-queries.kqlog";
+const char SOLVER_TRACE_FILE_NAME[] = "solver-trace.json";
 
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
-    std::string baseSolverQueryKQueryLogPath);
+    std::string baseSolverQueryKQueryLogPath, std::string queryBinaryLogPath,
+    std::string baseSolverQueryBinaryLogPath, std::string solverTracePath);
 } // namespace klee
 
 #endif /* KLEE_COMMON_H */
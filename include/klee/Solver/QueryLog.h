@@ -0,0 +1,139 @@
+//===-- QueryLog.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_QUERYLOG_H
+#define KLEE_QUERYLOG_H
+
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/System/Time.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+struct Query;
+
+/// The solver operations recorded in a binary query log.
+enum class QueryLogOperation : uint8_t {
+  Truth,
+  Validity,
+  Value,
+  InitialValues,
+  Check,
+  ValidityCore,
+  Feasibility
+};
+
+const unsigned QueryLogOperationCount =
+    static_cast<unsigned>(QueryLogOperation::Feasibility) + 1;
+
+const char *getQueryLogOperationName(QueryLogOperation operation);
+
+/// How the solver answered a logged query.
+struct QueryLogOutcome {
+  bool success = false;
+  SolverImpl::SolverRunStatus status =
+      SolverImpl::SOLVER_RUN_STATUS_FAILURE;
+  /// Whether `answer` holds a comparable answer: the truth, validity or
+  /// response kind of the query, or the number of feasible conditions
+  bool hasAnswer = false;
+  int64_t answer = 0;
+  time::Span elapsed;
+};
+
+/// A query read back from a binary query log.
+struct LoggedQuery {
+  QueryLogOperation operation = QueryLogOperation::Truth;
+  constraints_ty constraints;
+  ref<Expr> expr;
+  /// The conditions of a feasibility query
+  std::vector<ref<Expr>> conditions;
+  /// The arrays whose initial values were asked for
+  std::vector<const Array *> objects;
+  QueryLogOutcome outcome;
+};
+
+/// QueryLogWriter - Writes queries in a compact binary format. Every
+/// expression, update node and array is written once, the first time a
+/// query refers to it, and later queries refer back to it by number, so
+/// the growing path constraints shared by consecutive queries cost almost
+/// nothing to log.
+///
+/// Arrays keep their size, constant contents and domain and range. Other
+/// sources are logged as plain symbolic arrays named after the original
+/// array, which the core solvers cannot tell apart from the original.
+class QueryLogWriter {
+  llvm::raw_ostream &os;
+  std::string record;
+
+  ExprHashMap<uint64_t> exprIds;
+  std::vector<ref<Expr>> loggedExprs;
+  std::unordered_map<const UpdateNode *, uint64_t> updateIds;
+  std::vector<ref<UpdateNode>> loggedUpdates;
+  std::unordered_map<const Array *, uint64_t> arrayIds;
+
+  void reset();
+  uint64_t encode(const ref<Expr> &e);
+  uint64_t encode(const UpdateList &updates);
+  uint64_t encode(const Array *array);
+
+public:
+  explicit QueryLogWriter(llvm::raw_ostream &os);
+
+  void write(QueryLogOperation operation, const Query &query,
+             const std::vector<ref<Expr>> &conditions,
+             const std::vector<const Array *> &objects,
+             const QueryLogOutcome &outcome);
+};
+
+/// QueryLogReader - Reads back the queries written by a QueryLogWriter,
+/// from plain or gzip-compressed data.
+class QueryLogReader {
+  class Input;
+  std::unique_ptr<Input> input;
+  std::string error;
+
+  std::vector<ref<Expr>> exprs;
+  std::vector<ref<UpdateNode>> updates;
+  std::vector<const Array *> arrays;
+  uint64_t unreadable = 0;
+
+  bool readExpr();
+  bool readUpdate();
+  bool readArray();
+  bool readQuery(LoggedQuery &query, bool &complete);
+  bool readExprs(std::vector<ref<Expr>> &result, bool &complete);
+  bool fail(const std::string &message);
+
+public:
+  explicit QueryLogReader(llvm::StringRef data);
+  ~QueryLogReader();
+
+  /// Read the next query which could be rebuilt, skipping those referring
+  /// to arrays which only have a meaning inside the run that logged them.
+  /// Returns false at the end of the log or on a malformed log.
+  bool next(LoggedQuery &query);
+
+  const std::string &getError() const { return error; }
+
+  /// The number of queries skipped so far
+  uint64_t getUnreadable() const { return unreadable; }
+};
+
+} // namespace klee
+
+#endif /* KLEE_QUERYLOG_H */
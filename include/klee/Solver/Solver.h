@@ -115,6 +115,17 @@ public:
   /// \return True on success.
   bool mayBeTrue(const Query &, bool &result);
 
+  /// mayBeTrue - Determine for each of the given conditions whether there is
+  /// a valid assignment for the given state in which it evaluates to true.
+  /// The conditions are checked together, so that the constraints need to be
+  /// handled only once. The query expression is ignored.
+  ///
+  /// \param [out] result - On success, whether each condition may be true
+  ///
+  /// \return True on success.
+  bool mayBeTrue(const Query &, const std::vector<ref<Expr>> &conditions,
+                 std::vector<bool> &result);
+
   /// mayBeFalse - Determine if there is a valid assignment for the given
   /// state in which the expression evaluates to false.
   ///
@@ -250,6 +261,41 @@ std::unique_ptr<Solver> createIndependentSolver(std::unique_ptr<Solver> s);
 /// \param s - The underlying solver to use.
 std::unique_ptr<Solver> createAlphaEquivalenceSolver(std::unique_ptr<Solver> s);
 
+/// createConflictCachingSolver - Create a solver which remembers the validity
+/// cores of valid queries, and answers any query whose constraints and
+/// negated expression contain one of them as valid without asking the
+/// underlying solver.
+///
+/// \param s - The underlying solver to use.
+std::unique_ptr<Solver> createConflictCachingSolver(std::unique_ptr<Solver> s);
+
+/// createReadOverWriteSolver - Create a solver which drops from the update
+/// lists of array reads every write whose index cannot alias the read index,
+/// given the index ranges implied by the constraints, so that the core
+/// solver does not have to translate them.
+///
+/// \param s - The underlying solver to use.
+std::unique_ptr<Solver> createReadOverWriteSolver(std::unique_ptr<Solver> s);
+
+class SolverTracer;
+
+/// createSolverTracer - Create a recorder for the calls of traced solvers,
+/// written to the given path in Chrome trace format every few seconds and
+/// once the last solver using it is destroyed.
+///
+/// \param capacity - The number of latest calls to keep.
+/// \param sampleRate - Record only one of every `sampleRate` queries.
+std::shared_ptr<SolverTracer> createSolverTracer(std::string path,
+                                                 unsigned capacity,
+                                                 unsigned sampleRate);
+
+/// createTracingSolver - Create a solver which records every call of the
+/// given solver, named after its layer of the solver chain, with the
+/// tracer. Every traced solver gets its own instance number.
+std::unique_ptr<Solver>
+createTracingSolver(std::unique_ptr<Solver> s,
+                    std::shared_ptr<SolverTracer> tracer, const char *layer);
+
 /// createKQueryLoggingSolver - Create a solver which will forward all queries
 /// after writing them to the given path in .kquery format.
 std::unique_ptr<Solver> createKQueryLoggingSolver(std::unique_ptr<Solver> s,
@@ -264,6 +310,49 @@ std::unique_ptr<Solver> createSMTLIBLoggingSolver(std::unique_ptr<Solver> sm,
                                                   time::Span minQueryTimeToLog,
                                                   bool logTimedOut);
 
+/// createBinaryLoggingSolver - Create a solver which will forward all queries
+/// after writing them to the given path in the compact binary format read
+/// by QueryLogReader, compressed if KLEE was built with zlib.
+std::unique_ptr<Solver> createBinaryLoggingSolver(std::unique_ptr<Solver> s,
+                                                  std::string path,
+                                                  time::Span minQueryTimeToLog,
+                                                  bool logTimedOut);
+
+/// createPersistentCachingSolver - Create a solver which caches answers of
+/// the underlying solver in the file at `path`, shared with other (possibly
+/// concurrently running) KLEE processes. If the file cannot be opened, the
+/// underlying solver is returned unchanged.
+///
+/// \param s - The underlying solver to use.
+/// \param path - The cache file, created if it does not exist. Its index is
+/// kept next to it in `<path>.index`.
+std::unique_ptr<Solver> createPersistentCachingSolver(std::unique_ptr<Solver> s,
+                                                      const std::string &path);
+
+/// createPortfolioSolver - Create a solver which races the given core
+/// solvers on every query, each in a forked process, and takes the first
+/// answer. Once one of them has won nearly every race among queries of some
+/// shape (size, arrays, non-linear arithmetic, floating point), such queries
+/// are given to it alone, without forking.
+///
+/// \param solvers - The core solvers to race.
+std::unique_ptr<Solver>
+createPortfolioSolver(std::vector<std::unique_ptr<Solver>> solvers);
+
+/// createTimeoutPredictingSolver - Create a solver which gives every query
+/// a timeout predicted from how long earlier queries of the same shape took
+/// to solve, capped by the timeout set on the solver.
+///
+/// \param s - The underlying solver to use.
+/// \param predictTimeouts - Whether to shorten timeouts at all, or only to
+/// log the timings.
+/// \param timingLogPath - If not empty, a file with the features, solve time
+/// and status of every query. Timings logged there by earlier runs are used
+/// to predict timeouts from the start.
+std::unique_ptr<Solver>
+createTimeoutPredictingSolver(std::unique_ptr<Solver> s, bool predictTimeouts,
+                              const std::string &timingLogPath);
+
 /// createDummySolver - Create a dummy solver implementation which always
 /// fails.
 std::unique_ptr<Solver> createDummySolver();
@@ -25,12 +25,18 @@ extern llvm::cl::opt<bool> UseCexCache;
 
 extern llvm::cl::opt<bool> UseBranchCache;
 
+extern llvm::cl::opt<bool> UseConflictCache;
+
+extern llvm::cl::opt<unsigned> ConflictCacheSize;
+
 extern llvm::cl::opt<bool> UseAlphaEquivalence;
 
 extern llvm::cl::opt<bool> UseConcretizingSolver;
 
 extern llvm::cl::opt<bool> UseIndependentSolver;
 
+extern llvm::cl::opt<unsigned> IndependentFactorCacheSize;
+
 extern llvm::cl::opt<bool> DebugValidateSolver;
 
 extern llvm::cl::opt<std::string> MinQueryTimeToLog;
@@ -41,6 +47,20 @@ extern llvm::cl::opt<std::string> MaxCoreSolverTime;
 
 extern llvm::cl::opt<bool> UseForkedCoreSolver;
 
+extern llvm::cl::opt<std::string> QueryCacheFile;
+
+extern llvm::cl::opt<bool> PredictSolverTimeout;
+
+extern llvm::cl::opt<std::string> SolverTimingLog;
+
+extern llvm::cl::opt<bool> PruneReadOverWrite;
+
+extern llvm::cl::opt<bool> TraceSolverChain;
+
+extern llvm::cl::opt<unsigned> SolverTraceEvents;
+
+extern llvm::cl::opt<unsigned> SolverTraceSampleRate;
+
 extern llvm::cl::opt<bool> CoreSolverOptimizeDivides;
 
 extern llvm::cl::opt<bool> UseAssignmentValidatingSolver;
@@ -51,8 +71,10 @@ extern llvm::cl::opt<unsigned> MaxSolversApproxTreeInc;
 enum QueryLoggingSolverType {
   ALL_KQUERY,    ///< Log all queries in .kquery (KQuery) format
   ALL_SMTLIB,    ///< Log all queries .smt2 (SMT-LIBv2) format
+  ALL_BINARY,    ///< Log all queries in the binary query log format
   SOLVER_KQUERY, ///< Log queries passed to solver in .kquery (KQuery) format
-  SOLVER_SMTLIB  ///< Log queries passed to solver in .smt2 (SMT-LIBv2) format
+  SOLVER_SMTLIB, ///< Log queries passed to solver in .smt2 (SMT-LIBv2) format
+  SOLVER_BINARY  ///< Log queries passed to solver in the binary format
 };
 
 extern llvm::cl::bits<QueryLoggingSolverType> QueryLoggingOptions;
@@ -70,6 +92,8 @@ enum CoreSolverType {
 
 extern llvm::cl::opt<CoreSolverType> CoreSolverToUse;
 
+extern llvm::cl::list<CoreSolverType> SolverPortfolio;
+
 extern llvm::cl::opt<CoreSolverType> DebugCrossCheckCoreSolverWith;
 
 extern llvm::cl::opt<bool> ProduceUnsatCore;
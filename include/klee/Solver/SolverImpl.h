@@ -108,6 +108,22 @@ public:
   virtual bool computeMinimalUnsignedValue(const Query &query,
                                            ref<ConstantExpr> &result);
 
+  /// computeFeasibility - Determine for each of the given conditions
+  /// whether it may be true given the constraints of the query. The query
+  /// expression is ignored.
+  ///
+  /// The conditions are guaranteed to be non-constant and have bool type.
+  ///
+  /// SolverImpl provides a default implementation which uses computeTruth
+  /// on the negation of every condition in turn. Clients should override
+  /// this if the conditions can be checked together more cheaply.
+  ///
+  /// \param [out] feasible - On success, whether each condition may be true.
+  /// \return True on success
+  virtual bool computeFeasibility(const Query &query,
+                                  const std::vector<ref<Expr>> &conditions,
+                                  std::vector<bool> &feasible);
+
   /// getOperationStatusCode - get the status of the last solver operation
   virtual SolverRunStatus getOperationStatusCode() = 0;
 
@@ -24,12 +24,24 @@ extern Statistic queryCacheHits;
 extern Statistic queryCacheMisses;
 extern Statistic queryCexCacheHits;
 extern Statistic queryCexCacheMisses;
+extern Statistic queryPersistentCacheHits;
+extern Statistic queryPersistentCacheMisses;
+extern Statistic queryFactorCacheHits;
+extern Statistic queryFactorCacheMisses;
+extern Statistic queryConflictCacheHits;
+extern Statistic queryConflictCacheMisses;
+extern Statistic queryPredictedTimeouts;
 extern Statistic queryConstructs;
 extern Statistic queryCounterexamples;
 extern Statistic validQueriesSize;
 extern Statistic validityCoresSize;
 extern Statistic queryValidityCores;
 extern Statistic queryTime;
+extern Statistic queryTranslationTime;
+extern Statistic querySolveTime;
+extern Statistic queryTermCacheHits;
+extern Statistic queryPrunedWrites;
+extern Statistic queryReusedSolvers;
 
 #ifdef KLEE_ARRAY_DEBUG
 extern Statistic arrayHashTime;
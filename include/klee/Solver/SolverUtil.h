@@ -343,6 +343,10 @@ Validity fromPartial(PartialValidity v);
 
 PartialValidity toPartial(Validity v);
 
+// The validity of a query, given the responses to it and to its negation
+PartialValidity toPartial(const ref<SolverResponse> &queryResult,
+                          const ref<SolverResponse> &negatedQueryResult);
+
 PartialValidity negatePartialValidity(PartialValidity pv);
 
 }; // namespace klee
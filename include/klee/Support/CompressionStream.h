@@ -41,6 +41,12 @@ public:
   compressed_fd_ostream(const std::string &Filename, std::string &ErrorInfo);
 
   ~compressed_fd_ostream();
+
+  /// sync - Write out everything written so far, ending it at a byte
+  /// boundary of the compressed data (Z_SYNC_FLUSH), so that it can be
+  /// decompressed even if the stream is never finished. Each sync costs some
+  /// compression, so it should be done rarely.
+  void sync();
 };
 } // namespace klee
 
@@ -13,8 +13,10 @@
 #include "klee/Config/config.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <sys/types.h>
 
 namespace klee {
 std::unique_ptr<llvm::raw_fd_ostream>
@@ -24,6 +26,13 @@ klee_open_output_file(const std::string &path, std::string &error);
 std::unique_ptr<llvm::raw_ostream>
 klee_open_compressed_output_file(const std::string &path, std::string &error);
 #endif
+
+/// Write all of `data` to `fd`, retrying interrupted and short writes.
+bool klee_write_fully(int fd, const std::string &data);
+
+/// Read exactly `size` bytes at `offset` of `fd` into `buffer`, retrying
+/// interrupted and short reads.
+bool klee_read_fully(int fd, char *buffer, size_t size, off_t offset);
 } // namespace klee
 
 #endif /* KLEE_FILEHANDLING_H */
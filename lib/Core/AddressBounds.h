@@ -0,0 +1,99 @@
+//===-- AddressBounds.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_ADDRESSBOUNDS_H
+#define KLEE_ADDRESSBOUNDS_H
+
+#include "klee/ADT/Bits.h"
+#include "klee/Expr/Expr.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace klee {
+
+/// Unsigned bounds on the value of an address expression.
+struct AddressBounds {
+  uint64_t min = 0;
+  uint64_t max = 0;
+  /// The sorted values the address can take, if they are known
+  std::vector<uint64_t> values;
+  bool exact = false;
+
+  explicit AddressBounds(Expr::Width width)
+      : max(bits64::maxValueOfNBits(width)) {}
+
+  /// Whether no address satisfies the bounds
+  bool empty() const { return min > max; }
+
+  bool contains(uint64_t address) const {
+    if (address < min || address > max) {
+      return false;
+    }
+    return !exact || std::binary_search(values.begin(), values.end(), address);
+  }
+
+  /// Narrow the bounds by the constraint `e` over `address`, holding iff
+  /// `holds`.
+  void constrain(ref<Expr> e, ref<Expr> address, bool holds) {
+    if (auto ne = dyn_cast<NotExpr>(e)) {
+      constrain(ne->expr, address, !holds);
+      return;
+    }
+    if (auto ee = dyn_cast<EqExpr>(e); ee && ee->left->isFalse()) {
+      constrain(ee->right, address, !holds);
+      return;
+    }
+    if (e->getKind() != Expr::Eq && e->getKind() != Expr::Ult &&
+        e->getKind() != Expr::Ule) {
+      return;
+    }
+    ref<Expr> left = e->getKid(0), right = e->getKid(1);
+    bool addressLeft = left == address;
+    if (!(addressLeft ? isa<ConstantExpr>(right)
+                      : right == address && isa<ConstantExpr>(left))) {
+      return;
+    }
+    uint64_t k = cast<ConstantExpr>(addressLeft ? right : left)
+                     ->getZExtValue();
+    // Normalize to `address < k`, `address <= k`, `k < address` and so on
+    bool strict = e->getKind() == Expr::Ult;
+    bool upper = addressLeft;
+    if (!holds) {
+      if (e->getKind() == Expr::Eq) {
+        return;
+      }
+      strict = !strict;
+      upper = !upper;
+    }
+    if (e->getKind() == Expr::Eq) {
+      min = std::max(min, k);
+      max = std::min(max, k);
+    } else if (upper) {
+      if (strict && k == 0) {
+        max = 0;
+        min = 1;
+      } else {
+        max = std::min(max, strict ? k - 1 : k);
+      }
+    } else {
+      if (strict && k == UINT64_MAX) {
+        max = 0;
+        min = 1;
+      } else {
+        min = std::max(min, strict ? k + 1 : k);
+      }
+    }
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_ADDRESSBOUNDS_H */
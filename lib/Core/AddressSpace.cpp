@@ -9,10 +9,12 @@
 
 #include "AddressSpace.h"
 
+#include "AddressBounds.h"
 #include "ExecutionState.h"
 #include "Memory.h"
 #include "TimingSolver.h"
 
+#include "klee/ADT/Bits.h"
 #include "klee/Expr/ArrayExprVisitor.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Module/KType.h"
@@ -20,6 +22,9 @@
 
 #include "CoreStats.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace klee {
 llvm::cl::OptionCategory
     PointerResolvingCat("Pointer resolving options",
@@ -173,6 +178,65 @@ bool AddressSpace::resolveOneIfUnique(ExecutionState &state,
   return true;
 }
 
+void AddressSpace::collectCandidates(const ExecutionState &state,
+                                     ref<PointerExpr> p,
+                                     ResolutionList &candidates) const {
+  ref<Expr> base = p->getBase();
+  if (base->getWidth() > Expr::Int64) {
+    for (const auto &object : objects) {
+      candidates.push_back({object.first, object.second.get()});
+    }
+    return;
+  }
+
+  AddressBounds bounds(base->getWidth());
+  if (auto CE = dyn_cast<ConstantExpr>(base)) {
+    bounds.min = bounds.max = CE->getZExtValue();
+  } else if (auto SE = dyn_cast<SelectExpr>(base)) {
+    std::vector<ref<Expr>> alternatives;
+    ArrayExprHelper::collectAlternatives(*SE, alternatives);
+    bool allConstant = std::all_of(
+        alternatives.begin(), alternatives.end(),
+        [](ref<Expr> alternative) { return isa<ConstantExpr>(alternative); });
+    if (allConstant) {
+      for (auto alternative : alternatives) {
+        bounds.values.push_back(
+            cast<ConstantExpr>(alternative)->getZExtValue());
+      }
+      std::sort(bounds.values.begin(), bounds.values.end());
+      bounds.min = bounds.values.front();
+      bounds.max = bounds.values.back();
+      bounds.exact = true;
+    }
+  }
+  if (!isa<ConstantExpr>(base)) {
+    for (const auto &constraint : state.constraints.cs().cs()) {
+      bounds.constrain(constraint, base, true);
+    }
+  }
+
+  // Objects are ordered by address, those with symbolic addresses last. The
+  // latter cannot be excluded by bounds.
+  if (!bounds.empty()) {
+    MemoryObject lowest(bounds.min);
+    for (auto oi = objects.lower_bound(&lowest), oe = objects.end(); oi != oe;
+         ++oi) {
+      const MemoryObject *mo = oi->first;
+      if (!mo->address.has_value() || *mo->address > bounds.max) {
+        break;
+      }
+      if (bounds.contains(*mo->address)) {
+        candidates.push_back({mo, oi->second.get()});
+      }
+    }
+  }
+  MemoryObject highest(UINT64_MAX);
+  for (auto oi = objects.upper_bound(&highest), oe = objects.end(); oi != oe;
+       ++oi) {
+    candidates.push_back({oi->first, oi->second.get()});
+  }
+}
+
 class ResolvePredicate {
   bool useTimestamps;
   bool skipNotSymbolicObjects;
@@ -260,10 +324,11 @@ bool AddressSpace::resolveOne(ExecutionState &state, TimingSolver *solver,
 
   // didn't work, now we have to search
 
-  for (MemoryMap::iterator oi = objects.begin(), oe = objects.end(); oi != oe;
-       ++oi) {
-    const auto &mo = oi->first;
-    if (!predicate(mo, oi->second.get())) {
+  ResolutionList candidates;
+  collectCandidates(state, address, candidates);
+  for (const auto &candidate : candidates) {
+    const auto &mo = candidate.first;
+    if (!predicate(mo, candidate.second)) {
       continue;
     }
 
@@ -277,7 +342,7 @@ bool AddressSpace::resolveOne(ExecutionState &state, TimingSolver *solver,
                            state.queryMetaData))
       return false;
     if (mayBeTrue) {
-      result = {oi->first, oi->second.get()};
+      result = candidate;
       success = true;
       return true;
     }
@@ -287,41 +352,6 @@ bool AddressSpace::resolveOne(ExecutionState &state, TimingSolver *solver,
   return true;
 }
 
-int AddressSpace::checkPointerInObject(ExecutionState &state,
-                                       TimingSolver *solver, ref<PointerExpr> p,
-                                       const ObjectPair &op, ResolutionList &rl,
-                                       unsigned maxResolutions) const {
-  // XXX in the common case we can save one query if we ask
-  // mustBeTrue before mayBeTrue for the first result. easy
-  // to add I just want to have a nice symbolic test case first.
-  const MemoryObject *mo = op.first;
-  ref<Expr> inBounds = mo->getBoundsCheckPointer(p);
-
-  bool mayBeTrue;
-  if (!solver->mayBeTrue(state.constraints.cs(), inBounds, mayBeTrue,
-                         state.queryMetaData)) {
-    return 1;
-  }
-
-  if (mayBeTrue) {
-    rl.push_back(op);
-
-    // fast path check
-    auto size = rl.size();
-    if (size == 1) {
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints.cs(), inBounds, mustBeTrue,
-                              state.queryMetaData))
-        return 1;
-      if (mustBeTrue)
-        return 0;
-    } else if (size == maxResolutions)
-      return 1;
-  }
-
-  return 2;
-}
-
 bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
                            ref<PointerExpr> p, KType *objectType,
                            ResolutionList &rl, unsigned maxResolutions,
@@ -362,22 +392,52 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
   // to hit the fast path with exactly 2 queries). we could also
   // just get this by inspection of the expr.
 
-  for (MemoryMap::iterator oi = objects.begin(), oe = objects.end(); oi != oe;
-       ++oi) {
-    const MemoryObject *mo = oi->first;
-    if (!predicate(mo, oi->second.get())) {
+  ResolutionList candidates;
+  collectCandidates(state, p, candidates);
+  ResolutionList matching;
+  std::vector<ref<Expr>> inBounds;
+  for (const auto &op : candidates) {
+    if (!predicate(op.first, op.second)) {
       continue;
     }
 
     if (timeout && timeout < timer.delta())
       return true;
 
-    auto op = std::make_pair<>(mo, oi->second.get());
+    matching.push_back(op);
+    inBounds.push_back(op.first->getBoundsCheckPointer(p));
+  }
+  if (matching.empty())
+    return false;
+
+  // fast path check: `p` commonly points into the first candidate only, which
+  // a single mustBeTrue query decides
+  bool mustBeTrue;
+  if (!solver->mustBeTrue(state.constraints.cs(), inBounds.front(), mustBeTrue,
+                          state.queryMetaData))
+    return true;
+  if (mustBeTrue) {
+    rl.push_back(matching.front());
+    return false;
+  }
+
+  if (timeout && timeout < timer.delta())
+    return true;
+
+  // Whether `p` may point into each of the candidates is decided by a single
+  // query
+  std::vector<bool> mayBeInBounds;
+  if (!solver->mayBeTrue(state.constraints.cs(), inBounds, mayBeInBounds,
+                         state.queryMetaData)) {
+    return true;
+  }
 
-    int incomplete =
-        checkPointerInObject(state, solver, p, op, rl, maxResolutions);
-    if (incomplete != 2)
-      return incomplete ? true : false;
+  for (unsigned i = 0; i < matching.size(); ++i) {
+    if (!mayBeInBounds[i])
+      continue;
+    rl.push_back(matching[i]);
+    if (rl.size() == maxResolutions)
+      return true;
   }
   return false;
 }
@@ -49,16 +49,12 @@ private:
   /// Unsupported, use copy constructor
   AddressSpace &operator=(const AddressSpace &);
 
-  /// Check if pointer `p` can point to the memory object in the
-  /// given object pair.  If so, add it to the given resolution list.
-  ///
-  /// \return 1 iff the resolution is incomplete (`maxResolutions`
-  /// is non-zero and it was reached, or a query timed out), 0 iff
-  /// the resolution is complete (`p` can only point to the given
-  /// memory object), and 2 otherwise.
-  int checkPointerInObject(ExecutionState &state, TimingSolver *solver,
-                           ref<PointerExpr> p, const ObjectPair &op,
-                           ResolutionList &rl, unsigned maxResolutions) const;
+  /// Collect the objects pointer `p` may point to, judging only by the bounds
+  /// on its base which follow from the structure of the base and from its
+  /// comparisons with constants in the path constraints. The objects are
+  /// listed in address order.
+  void collectCandidates(const ExecutionState &state, ref<PointerExpr> p,
+                         ResolutionList &candidates) const;
 
 public:
   /// The MemoryObject -> ObjectState map that constitutes the
@@ -0,0 +1,93 @@
+//===-- Checkpoint.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Checkpoint.h"
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <utility>
+
+using namespace klee;
+
+namespace {
+const char CheckpointMagic[] = "KLEE checkpoint 1\n";
+
+/// Nodes are written in preorder, false subtree first, one character each.
+const char Leaf = 'L', OnlyFalse = 'F', OnlyTrue = 'T', Both = 'B';
+} // namespace
+
+void Checkpoint::write(llvm::raw_ostream &os) const {
+  os << CheckpointMagic;
+  // Paths are as deep as the programs run, so no recursion
+  std::vector<std::uint32_t> pending{root()};
+  while (!pending.empty()) {
+    const Node &node = nodes[pending.back()];
+    pending.pop_back();
+    if (node.isLeaf()) {
+      os << Leaf;
+    } else if (node.children[1] == NoNode) {
+      os << OnlyFalse;
+    } else if (node.children[0] == NoNode) {
+      os << OnlyTrue;
+    } else {
+      os << Both;
+    }
+    for (unsigned branch = 2; branch-- > 0;)
+      if (node.children[branch] != NoNode)
+        pending.push_back(node.children[branch]);
+  }
+  os << '\n';
+}
+
+bool Checkpoint::read(const std::string &path, std::string &error) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    error = buffer.getError().message();
+    return false;
+  }
+  llvm::StringRef data = (*buffer)->getBuffer();
+  if (!data.consume_front(CheckpointMagic)) {
+    error = "not a checkpoint";
+    return false;
+  }
+
+  nodes.assign(1, Node());
+  // Parents and branches of the nodes yet to be read, the root has none
+  std::vector<std::pair<std::uint32_t, unsigned>> pending{{NoNode, 0}};
+  for (char c : data) {
+    if (pending.empty())
+      break;
+    std::uint32_t parent = pending.back().first;
+    unsigned branch = pending.back().second;
+    pending.pop_back();
+    std::uint32_t node = root();
+    if (parent != NoNode) {
+      node = nodes.size();
+      nodes.emplace_back();
+      nodes[parent].children[branch] = node;
+    }
+
+    bool hasFalse = c == OnlyFalse || c == Both;
+    bool hasTrue = c == OnlyTrue || c == Both;
+    if (!hasFalse && !hasTrue && c != Leaf) {
+      error = "unexpected character in checkpoint";
+      return false;
+    }
+    if (hasTrue)
+      pending.emplace_back(node, 1);
+    if (hasFalse)
+      pending.emplace_back(node, 0);
+  }
+  if (!pending.empty()) {
+    error = "truncated checkpoint";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+//===-- Checkpoint.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_CHECKPOINT_H
+#define KLEE_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace klee {
+
+/// Checkpoint - The branch decisions of the states an interrupted run was
+/// still exploring, kept as a binary trie so that decisions shared by
+/// several states are stored once.
+///
+/// A run resumed from a checkpoint follows the decisions of the trie without
+/// querying the solver, and explores normally from where each state was
+/// interrupted. Only the decisions of two-way forks are recorded, which
+/// replay faithfully as long as the program, its inputs and the options are
+/// the same as in the checkpointed run.
+class Checkpoint {
+public:
+  static const std::uint32_t NoNode = ~0U;
+
+  struct Node {
+    /// The nodes following a false and a true decision, or NoNode
+    std::uint32_t children[2] = {NoNode, NoNode};
+
+    bool isLeaf() const {
+      return children[0] == NoNode && children[1] == NoNode;
+    }
+  };
+
+private:
+  std::vector<Node> nodes;
+
+public:
+  Checkpoint() : nodes(1) {}
+
+  std::uint32_t root() const { return 0; }
+  const Node &operator[](std::uint32_t node) const { return nodes[node]; }
+  std::size_t size() const { return nodes.size(); }
+
+  /// Add the decisions [begin, end) of a state.
+  template <typename InputIterator>
+  void insert(InputIterator begin, InputIterator end) {
+    std::uint32_t node = root();
+    for (; begin != end; ++begin) {
+      std::uint32_t &child = nodes[node].children[*begin ? 1 : 0];
+      if (child == NoNode) {
+        child = nodes.size();
+        nodes.emplace_back();
+      }
+      node = nodes[node].children[*begin ? 1 : 0];
+    }
+  }
+
+  void write(llvm::raw_ostream &os) const;
+
+  /// Load a checkpoint written by write(). Returns false and describes the
+  /// problem in `error` if the file is not a checkpoint.
+  bool read(const std::string &path, std::string &error);
+};
+
+} // namespace klee
+
+#endif /* KLEE_CHECKPOINT_H */
@@ -15,26 +15,51 @@
 #include "klee/Expr/Expr.h"
 #include "klee/Support/CompilerWarning.h"
 
+#include "llvm/Support/CommandLine.h"
+
 #include <cassert>
+#include <cstdint>
 #include <functional>
 
 namespace klee {
-enum class MemoryType { Fixed, Dynamic, Persistent, Mixed };
+enum class MemoryType { Fixed, Dynamic, Persistent, Paged, Mixed, Adaptive };
 
 extern llvm::cl::opt<MemoryType> MemoryBackend;
 extern llvm::cl::opt<unsigned long> MaxFixedSizeStructureSize;
+extern llvm::cl::opt<unsigned long> MaxPagedStructureSize;
+
+/// The representation --memory-backend=mixed uses for objects of the given
+/// constant size. Every copy of a paged object copies its page table, which
+/// costs more than a persistent map for large objects with few known bytes,
+/// so paging is limited to objects of moderate size.
+inline MemoryType
+mixedMemoryType(uint64_t size, size_t treshold = MaxFixedSizeStructureSize) {
+  if (size <= treshold)
+    return MemoryType::Fixed;
+  if (size <= MaxPagedStructureSize)
+    return MemoryType::Paged;
+  return MemoryType::Persistent;
+}
 
 template <typename ValueType, typename Eq = std::equal_to<ValueType>>
 SparseStorage<ValueType, Eq> *
 constructStorage(ref<Expr> size, const ValueType &defaultValue,
-                 size_t treshold = MaxFixedSizeStructureSize) {
-  switch (MemoryBackend) {
-  case klee::MemoryType::Mixed: {
-    if (auto constSize = dyn_cast<ConstantExpr>(size);
-        constSize && constSize->getZExtValue() <= treshold) {
+                 size_t treshold = MaxFixedSizeStructureSize,
+                 MemoryType type = MemoryBackend) {
+  switch (type) {
+  case klee::MemoryType::Mixed:
+  case klee::MemoryType::Adaptive: {
+    auto constSize = dyn_cast<ConstantExpr>(size);
+    return constructStorage<ValueType, Eq>(
+        size, defaultValue, treshold,
+        constSize ? mixedMemoryType(constSize->getZExtValue(), treshold)
+                  : MemoryType::Persistent);
+  }
+  case klee::MemoryType::Paged: {
+    if (auto constSize = dyn_cast<ConstantExpr>(size); constSize) {
       return new SparseStorageImpl<ValueType, Eq,
-                                   SparseArrayAdapter<ValueType, Eq>>(
-          defaultValue, typename SparseArrayAdapter<ValueType, Eq>::constructor(
+                                   PagedArrayAdapter<ValueType, Eq>>(
+          defaultValue, typename PagedArrayAdapter<ValueType, Eq>::constructor(
                             constSize->getZExtValue()));
     } else {
       return new SparseStorageImpl<ValueType, Eq,
@@ -72,9 +97,12 @@ constructStorage(ref<Expr> size, const ValueType &defaultValue,
 
 template <typename ValueType>
 FixedSizeStorageAdapter<ValueType> *
-constructStorage(size_t size, size_t treshold = MaxFixedSizeStructureSize) {
-  switch (MemoryBackend) {
-  case klee::MemoryType::Mixed: {
+constructStorage(size_t size, size_t treshold = MaxFixedSizeStructureSize,
+                 MemoryType type = MemoryBackend) {
+  switch (type) {
+  case klee::MemoryType::Mixed:
+  case klee::MemoryType::Adaptive:
+  case klee::MemoryType::Paged: {
     if (size <= treshold) {
       return new ArrayAdapter<ValueType>(size);
     } else {
@@ -32,12 +32,19 @@ extern Statistic solverTime;
 /// The number of external calls.
 extern Statistic externalCalls;
 
+/// The number of calls to functions of the module run natively.
+extern Statistic nativeCalls;
+
 /// The number of process forks.
 extern Statistic forks;
 
 /// Number of inhibited forks.
 extern Statistic inhibitedForks;
 
+/// Number of branch directions proven feasible by the model of the state,
+/// without a solver query.
+extern Statistic forkModelHits;
+
 /// Number of states, this is a "fake" statistic used by istats, it
 /// isn't normally up-to-date.
 extern Statistic states;
@@ -101,12 +101,16 @@ StackFrame::StackFrame(KFunction *kf) : kf(kf), varargs(nullptr) {
 }
 
 StackFrame::StackFrame(const StackFrame &s)
-    : kf(s.kf), allocas(s.allocas), varargs(s.varargs) {
-  locals.reset(s.locals->clone());
-}
+    : kf(s.kf), allocas(s.allocas), locals(s.locals), varargs(s.varargs) {}
 
 StackFrame::~StackFrame() {}
 
+void StackFrame::setLocal(size_t index, const Cell &value) {
+  if (locals.use_count() > 1)
+    locals.reset(locals->clone());
+  locals->set(index, value);
+}
+
 InfoStackFrame::InfoStackFrame(KFunction *kf) : kf(kf) {}
 
 /***/
@@ -155,14 +159,16 @@ ExecutionState::ExecutionState(const ExecutionState &state)
       stack(state.stack), stackBalance(state.stackBalance),
       incomingBBIndex(state.incomingBBIndex), depth(state.depth),
       level(state.level), addressSpace(state.addressSpace),
-      constraints(state.constraints), eventsRecorder(state.eventsRecorder),
+      constraints(state.constraints), model(state.model),
+      eventsRecorder(state.eventsRecorder),
       targetForest(state.targetForest), pathOS(state.pathOS),
-      symPathOS(state.symPathOS), coveredLines(state.coveredLines),
+      symPathOS(state.symPathOS), branches(state.branches),
+      resumeNode(state.resumeNode), coveredLines(state.coveredLines),
       symbolics(state.symbolics), resolvedPointers(state.resolvedPointers),
       cexPreferences(state.cexPreferences), arrayNames(state.arrayNames),
       steppedInstructions(state.steppedInstructions),
       steppedMemoryInstructions(state.steppedMemoryInstructions),
-      instsSinceCovNew(state.instsSinceCovNew),
+      lastSelected(state.lastSelected), instsSinceCovNew(state.instsSinceCovNew),
       roundingMode(state.roundingMode),
       unwindingInformation(state.unwindingInformation
                                ? state.unwindingInformation->clone()
@@ -181,7 +187,7 @@ ExecutionState *ExecutionState::branch() {
 
   auto *falseState = new ExecutionState(*this);
   falseState->setID();
-  falseState->coveredLines.clear();
+  falseState->coveredLines = {};
   falseState->prevTargets_ = falseState->targets_;
   falseState->prevHistory_ = falseState->history_;
 
@@ -397,6 +403,8 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
 
 void ExecutionState::addConstraint(ref<Expr> e) {
   constraints.addConstraint(e);
+  if (!model.bindings.empty() && !model.evaluate(e)->isTrue())
+    model = Assignment();
 }
 
 void ExecutionState::addCexPreference(const ref<Expr> &cond) {
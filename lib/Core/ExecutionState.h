@@ -16,6 +16,7 @@
 #include "klee/ADT/ImmutableList.h"
 #include "klee/ADT/ImmutableSet.h"
 #include "klee/ADT/PersistentMap.h"
+#include "klee/ADT/PersistentVector.h"
 #include "klee/ADT/PersistentSet.h"
 #include "klee/ADT/SparseStorage.h"
 #include "klee/ADT/TreeStream.h"
@@ -33,6 +34,7 @@
 #include "klee/Solver/Solver.h"
 #include "klee/Utilities/Math.h"
 
+#include "Checkpoint.h"
 #include "CodeLocation.h"
 #include "EventRecorder.h"
 
@@ -87,7 +89,9 @@ struct CallStackFrame {
 struct StackFrame {
   KFunction *kf;
   std::vector<ref<const MemoryObject>> allocas;
-  std::unique_ptr<FixedSizeStorageAdapter<Cell>> locals;
+  /// Copies of a frame share its registers until one of them writes a
+  /// register, so forking a state does not copy the whole stack
+  std::shared_ptr<FixedSizeStorageAdapter<Cell>> locals;
 
   // For vararg functions: arguments not passed via parameter are
   // stored (packed tightly) in a local (alloca) memory object. This
@@ -99,6 +103,10 @@ struct StackFrame {
   StackFrame(KFunction *kf);
   StackFrame(const StackFrame &s);
   ~StackFrame();
+
+  /// Set a register, first copying the registers if another frame still
+  /// shares them
+  void setLocal(size_t index, const Cell &value);
 };
 
 struct InfoStackFrame {
@@ -329,6 +337,11 @@ public:
   /// @brief Constraints collected so far
   PathConstraints constraints;
 
+  /// @brief An assignment satisfying the constraints, as found by the last
+  /// query which produced one, or empty. It is dropped as soon as a new
+  /// constraint does not hold under it
+  Assignment model;
+
   /// @brief Storage for the source code events (e.g. changing control flow or
   /// errors)
   EventRecorder eventsRecorder;
@@ -353,8 +366,15 @@ public:
   /// taken to reach/create this state
   TreeOStream symPathOS;
 
+  /// @brief Decisions at the forks of this state, recorded for checkpoints
+  PersistentVector<bool> branches;
+
+  /// @brief Node of the resumed checkpoint this state follows, or
+  /// Checkpoint::NoNode
+  std::uint32_t resumeNode = Checkpoint::NoNode;
+
   /// @brief Set containing which lines in which files are covered by this state
-  std::map<std::string, std::set<unsigned>> coveredLines;
+  PersistentMap<std::string, PersistentSet<unsigned>> coveredLines;
 
   /// @brief Pointer to the process tree of the current state
   /// Copies of ExecutionState should not copy ptreeNode
@@ -374,7 +394,7 @@ public:
   ImmutableSet<ref<Expr>> cexPreferences;
 
   /// @brief Set of used array names for this state.  Used to avoid collisions.
-  std::map<std::string, uint64_t> arrayNames;
+  PersistentMap<std::string, uint64_t> arrayNames;
 
   /// @brief The numbers of times this state has run through
   /// Executor::stepInstruction
@@ -384,6 +404,10 @@ public:
   /// Executor::stepInstruction with executeMemoryOperation
   std::uint64_t steppedMemoryInstructions = 0;
 
+  /// @brief The value of stats::instructions when the searcher last selected
+  /// this state. Used to find cold states under memory pressure.
+  std::uint64_t lastSelected = 0;
+
   /// @brief Counts how many instructions were executed since the last new
   /// instruction was covered.
   std::uint32_t instsSinceCovNew = 0;
@@ -601,6 +625,19 @@ struct ExecutionStateIDCompare {
 
 using states_ty = std::set<ExecutionState *, ExecutionStateIDCompare>;
 
+/// Orders states by how little terminating them loses under memory pressure:
+/// states which did not cover new code come first, then those the searcher
+/// has not selected for the longest time.
+struct ExecutionStateColdCompare {
+  bool operator()(const ExecutionState *a, const ExecutionState *b) const {
+    if (a->isCoveredNew() != b->isCoveredNew())
+      return !a->isCoveredNew();
+    if (a->lastSelected != b->lastSelected)
+      return a->lastSelected < b->lastSelected;
+    return a->getID() < b->getID();
+  }
+};
+
 } // namespace klee
 
 #endif /* KLEE_EXECUTIONSTATE_H */
@@ -11,6 +11,7 @@
 
 #include "AddressSpace.h"
 #include "CXXTypeSystem/CXXTypeManager.h"
+#include "Checkpoint.h"
 #include "ConstructStorage.h"
 #include "CoreStats.h"
 #include "DistanceCalculator.h"
@@ -82,10 +83,12 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
@@ -147,6 +150,13 @@ cl::opt<bool> MergedPointerDereference(
     cl::desc("Enable merged pointer dereference (default=false)"),
     cl::cat(ExecCat));
 
+cl::opt<bool> FastConcreteOperations(
+    "fast-concrete-operations", cl::init(true),
+    cl::desc("Compute integer arithmetic and comparisons on concrete operands "
+             "of at most 64 bits on machine words, without the expression "
+             "builders (default=true)"),
+    cl::cat(ExecCat));
+
 cl::opt<bool> UseTypeBasedAliasAnalysis(
     "use-tbaa",
     cl::desc("Turns on restrictions based on types compatibility for "
@@ -165,6 +175,13 @@ cl::opt<bool>
                                       "and return null (default=false)"),
                              cl::cat(ExecCat));
 
+cl::opt<bool> ForkModels(
+    "fork-models", cl::init(false),
+    cl::desc("Keep models of both directions of a fork, so later branches "
+             "they decide need one solver query instead of two "
+             "(default=false)"),
+    cl::cat(ExecCat));
+
 cl::opt<size_t> OSCopySizeMemoryCheckThreshold(
     "os-copy-size-mem-check-threshold", cl::init(30000),
     cl::desc("Check memory usage when this amount of bytes dense OS is copied"),
@@ -234,6 +251,21 @@ cl::opt<HaltExecution::Reason> DumpStatesOnHalt(
         clEnumValN(HaltExecution::Reason::Unspecified, "all",
                    "Dump test cases for all active states on exit (default)")),
     cl::cat(TestGenCat));
+
+cl::opt<bool> WriteCheckpoint(
+    "write-checkpoint", cl::init(false),
+    cl::desc("Write the branch decisions of the states left when execution "
+             "halts to checkpoint.paths, so that a later run can continue "
+             "exploring them with --resume-from (default=false)"),
+    cl::cat(TestGenCat));
+
+cl::opt<std::string> ResumeFrom(
+    "resume-from",
+    cl::desc("Continue the exploration of a run that wrote a checkpoint with "
+             "--write-checkpoint. States follow its branch decisions without "
+             "querying the solver, so the program, its inputs and the options "
+             "must be the same as in that run (default=off)"),
+    cl::value_desc("checkpoint file"), cl::cat(TestGenCat));
 } // namespace klee
 
 namespace {
@@ -338,6 +370,15 @@ cl::opt<bool> AllExternalWarnings(
              "as opposed to once per function (default=false)"),
     cl::cat(ExtCallsCat));
 
+cl::opt<bool> NativeConcreteCalls(
+    "native-concrete-calls", cl::init(false),
+    cl::desc("JIT-compile the functions of the module which take and return "
+             "integers, access no memory, have no loops, cannot trap and "
+             "shift by constant amounts only, and run their calls with "
+             "concrete arguments natively. The instructions they execute "
+             "are not counted as covered (default=false)"),
+    cl::cat(ExtCallsCat));
+
 /*** Seeding options ***/
 
 cl::opt<bool> AlwaysOutputSeeds(
@@ -503,6 +544,14 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
       haltExecution(HaltExecution::NotHalt), ivcEnabled(false),
       debugLogBuffer(debugBufferString), sarifReport({}) {
 
+  if (!ResumeFrom.empty()) {
+    resumeCheckpoint = std::make_unique<Checkpoint>();
+    std::string error;
+    if (!resumeCheckpoint->read(ResumeFrom, error))
+      klee_error("cannot resume from %s: %s", ResumeFrom.c_str(),
+                 error.c_str());
+  }
+
   objectManager = std::make_unique<ObjectManager>();
   seedMap = std::make_unique<SeedMap>();
   objectManager->addSubscriber(seedMap.get());
@@ -550,7 +599,10 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
       interpreterHandler->getOutputFilename(ALL_QUERIES_SMT2_FILE_NAME),
       interpreterHandler->getOutputFilename(SOLVER_QUERIES_SMT2_FILE_NAME),
       interpreterHandler->getOutputFilename(ALL_QUERIES_KQUERY_FILE_NAME),
-      interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQUERY_FILE_NAME));
+      interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQUERY_FILE_NAME),
+      interpreterHandler->getOutputFilename(ALL_QUERIES_BINARY_FILE_NAME),
+      interpreterHandler->getOutputFilename(SOLVER_QUERIES_BINARY_FILE_NAME),
+      interpreterHandler->getOutputFilename(SOLVER_TRACE_FILE_NAME));
 
   this->solver = std::make_unique<TimingSolver>(std::move(solver), optimizer,
                                                 EqualitySubstitution);
@@ -1211,6 +1263,9 @@ void Executor::branch(ExecutionState &state,
   unsigned N = conditions.size();
   assert(N);
 
+  // Checkpoints only record two-way forks, explore the rest normally
+  state.resumeNode = Checkpoint::NoNode;
+
   if (!branchingPermitted(state, N)) {
     unsigned next = theRNG.getInt32() % N;
     for (unsigned i = 0; i < N; ++i) {
@@ -1400,8 +1455,14 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
     shouldCheckFalseBlock = canReachSomeTargetFromBlock(current, ifFalseBlock);
   }
   PartialValidity res = PartialValidity::None;
+  std::uint32_t resumeFalseNode = Checkpoint::NoNode;
+  if (!isInternal && !isSeeding)
+    res = resumeBranch(current, resumeFalseNode);
+  Assignment trueModel, falseModel;
   bool terminateEverything = false, success = true;
-  if (!shouldCheckTrueBlock) {
+  if (res != PartialValidity::None) {
+    // Decided by the checkpoint
+  } else if (!shouldCheckTrueBlock) {
     bool mayBeFalse = false;
     if (shouldCheckFalseBlock) {
       // only solver->check-sat(!condition)
@@ -1431,8 +1492,7 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
   if (res != PartialValidity::None) {
     success = true;
   } else {
-    success = solver->evaluate(current.constraints.cs(), condition, res,
-                               current.queryMetaData);
+    success = evaluateBranch(current, condition, res, trueModel, falseModel);
   }
   solver->setTimeout(time::Span());
   if (!success) {
@@ -1470,6 +1530,8 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
           res = PValidity::MayBeTrue;
         } else {
           res = PValidity::MayBeFalse;
+          if (resumeFalseNode != Checkpoint::NoNode)
+            current.resumeNode = resumeFalseNode;
         }
         ++stats::inhibitedForks;
       }
@@ -1520,11 +1582,17 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       if (pathWriter) {
         current.pathOS << "1";
       }
+      if (WriteCheckpoint) {
+        current.branches.push_back(true);
+      }
     }
 
     if (res == PValidity::MayBeTrue) {
       addConstraint(current, condition);
     }
+    if (!trueModel.bindings.empty()) {
+      current.model = trueModel;
+    }
 
     return StatePair(&current, nullptr);
   } else if (res == PValidity::MustBeFalse || res == PValidity::MayBeFalse) {
@@ -1532,11 +1600,17 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       if (pathWriter) {
         current.pathOS << "0";
       }
+      if (WriteCheckpoint) {
+        current.branches.push_back(false);
+      }
     }
 
     if (res == PValidity::MayBeFalse) {
       addConstraint(current, Expr::createIsZero(condition));
     }
+    if (!falseModel.bindings.empty()) {
+      current.model = falseModel;
+    }
 
     return StatePair(nullptr, &current);
   } else {
@@ -1603,11 +1677,23 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
         falseState->symPathOS << "0";
       }
     }
+    if (WriteCheckpoint && !isInternal) {
+      trueState->branches.push_back(true);
+      falseState->branches.push_back(false);
+    }
+    if (resumeFalseNode != Checkpoint::NoNode)
+      falseState->resumeNode = resumeFalseNode;
 
     trueState->afterFork = true;
     falseState->afterFork = true;
     addConstraint(*trueState, condition);
     addConstraint(*falseState, Expr::createIsZero(condition));
+    if (!trueModel.bindings.empty()) {
+      trueState->model = trueModel;
+    }
+    if (!falseModel.bindings.empty()) {
+      falseState->model = falseModel;
+    }
 
     // Kinda gross, do we even really still want this option?
     if (MaxDepth && MaxDepth <= trueState->depth) {
@@ -1622,6 +1708,78 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
   }
 }
 
+PartialValidity Executor::resumeBranch(ExecutionState &state,
+                                      std::uint32_t &falseNode) {
+  if (!resumeCheckpoint || state.resumeNode == Checkpoint::NoNode)
+    return PartialValidity::None;
+
+  const Checkpoint::Node &node = (*resumeCheckpoint)[state.resumeNode];
+  if (node.isLeaf()) {
+    // The checkpointed run stopped here
+    state.resumeNode = Checkpoint::NoNode;
+    return PartialValidity::None;
+  }
+  if (node.children[0] == Checkpoint::NoNode) {
+    state.resumeNode = node.children[1];
+    return PartialValidity::MayBeTrue;
+  }
+  if (node.children[1] == Checkpoint::NoNode) {
+    state.resumeNode = node.children[0];
+    return PartialValidity::MayBeFalse;
+  }
+  state.resumeNode = node.children[1];
+  falseNode = node.children[0];
+  return PartialValidity::TrueOrFalse;
+}
+
+bool Executor::evaluateBranch(ExecutionState &state, ref<Expr> condition,
+                              PartialValidity &result, Assignment &trueModel,
+                              Assignment &falseModel) {
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
+    result = CE->isTrue() ? PValidity::MustBeTrue : PValidity::MustBeFalse;
+    return true;
+  }
+
+  ref<SolverResponse> queryResult, negatedQueryResult;
+  ref<Expr> value;
+  if (!state.model.bindings.empty()) {
+    value = state.model.evaluate(condition);
+  }
+  if (value && isa<ConstantExpr>(value)) {
+    // The model of the state shows one direction feasible, so only the
+    // other one is left to the solver
+    ++stats::forkModelHits;
+    bool isTrue = value->isTrue();
+    ref<SolverResponse> response;
+    if (!solver->getResponse(state.constraints.cs(),
+                             isTrue ? condition : Expr::createIsZero(condition),
+                             response, state.queryMetaData)) {
+      return false;
+    }
+    ref<SolverResponse> witness = new InvalidResponse(state.model.bindings);
+    queryResult = isTrue ? response : witness;
+    negatedQueryResult = isTrue ? witness : response;
+  } else if (!ForkModels) {
+    return solver->evaluate(state.constraints.cs(), condition, result,
+                            state.queryMetaData);
+  } else if (!solver->evaluate(state.constraints.cs(), condition, queryResult,
+                               negatedQueryResult, state.queryMetaData)) {
+    return false;
+  }
+
+  result = toPartial(queryResult, negatedQueryResult);
+  Assignment::bindings_ty bindings;
+  if (isa<InvalidResponse>(negatedQueryResult) &&
+      negatedQueryResult->tryGetInitialValues(bindings)) {
+    trueModel = Assignment(bindings);
+  }
+  if (isa<InvalidResponse>(queryResult) &&
+      queryResult->tryGetInitialValues(bindings)) {
+    falseModel = Assignment(bindings);
+  }
+  return result != PValidity::None;
+}
+
 Executor::StatePair Executor::forkInternal(ExecutionState &current,
                                            ref<Expr> condition,
                                            BranchType reason) {
@@ -2491,6 +2649,10 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
       transferToBasicBlock(ii->getNormalDest(), i->getParent(), state);
     }
   } else {
+    if (NativeConcreteCalls && isa<CallInst>(i) &&
+        callNatively(state, ki, f, arguments))
+      return;
+
     // Check if maximum stack size was reached.
     // We currently only count the number of stack frames
     if (RuntimeMaxStackFrames && state.stack.size() > RuntimeMaxStackFrames) {
@@ -2737,6 +2899,25 @@ void Executor::checkNullCheckAfterDeref(ref<Expr> cond, ExecutionState &state) {
   }
 }
 
+bool Executor::executeConcreteOp(ExecutionState &state,
+                                 const KInstruction *ki) {
+  const ConstantExpr *left = dyn_cast<ConstantExpr>(eval(ki, 0, state).value);
+  if (!left)
+    return false;
+  const ConstantExpr *right = dyn_cast<ConstantExpr>(eval(ki, 1, state).value);
+  if (!right)
+    return false;
+
+  Expr::Width width = ki->concreteWidth;
+  ref<ConstantExpr> result =
+      ConstantExpr::evaluate(ki->concreteKind, width, left->getZExtValue(width),
+                             right->getZExtValue(width));
+  if (!result)
+    return false;
+  bindLocal(ki, state, result);
+  return true;
+}
+
 void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   Instruction *i = ki->inst();
 
@@ -2754,6 +2935,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     }
   }
 
+  if (ki->concreteKind != Expr::InvalidKind &&
+      FastConcreteOperations && executeConcreteOp(state, ki))
+    return;
+
   switch (i->getOpcode()) {
     // Control flow
   case Instruction::Ret: {
@@ -2956,8 +3141,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
     ref<Expr> errorCase = ConstantExpr::alloc(1, Expr::Bool);
     SmallPtrSet<BasicBlock *, 5> destinations;
+    std::vector<BasicBlock *> candidates;
+    std::vector<ref<Expr>> conditions;
     KFunction *kf = state.stack.callStack().back().kf;
-    // collect and check destinations from label list
+    // collect destinations from label list
     for (unsigned k = 0; k < numDestinations; ++k) {
       // filter duplicates
       const auto d = bi->getDestination(k);
@@ -2974,21 +3161,22 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       // exclude address from errorCase
       errorCase = AndExpr::create(errorCase, Expr::createIsZero(e));
 
-      // check feasibility
-      bool result;
-      bool success __attribute__((unused)) = solver->mayBeTrue(
-          state.constraints.cs(), e, result, state.queryMetaData);
-      assert(success && "FIXME: Unhandled solver failure");
-      if (result) {
-        targets.push_back(d);
-        expressions.push_back(e);
-      }
+      candidates.push_back(d);
+      conditions.push_back(e);
     }
-    // check errorCase feasibility
-    bool result;
+    // check feasibility of the destinations and of errorCase at once
+    conditions.push_back(errorCase);
+    std::vector<bool> feasible;
     bool success __attribute__((unused)) = solver->mayBeTrue(
-        state.constraints.cs(), errorCase, result, state.queryMetaData);
+        state.constraints.cs(), conditions, feasible, state.queryMetaData);
     assert(success && "FIXME: Unhandled solver failure");
+    for (unsigned k = 0; k < candidates.size(); ++k) {
+      if (feasible[k]) {
+        targets.push_back(candidates[k]);
+        expressions.push_back(conditions[k]);
+      }
+    }
+    bool result = feasible.back();
     if (result) {
       expressions.push_back(errorCase);
     }
@@ -3049,6 +3237,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       }
 
       std::vector<ref<Expr>> notMatches;
+      // Conditions of the cases control flow may take, checked at once
+      std::vector<ref<Expr>> matches;
+      std::vector<BasicBlock *> matchSuccessors;
 
       KFunction *kf = state.stack.callStack().back().kf;
 
@@ -3071,31 +3262,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         if (!canReachSomeTargetFromBlock(state, kf->blockMap[caseSuccessor]))
           continue;
 
-        // Check if control flow could take this case
-        bool result;
-        match = optimizer.optimizeExpr(match, false);
-        bool success = solver->mayBeTrue(state.constraints.cs(), match, result,
-                                         state.queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void)success;
-        if (result) {
-          // Handle the case that a basic block might be the target of
-          // multiple switch cases. Currently we generate an expression
-          // containing all switch-case values for the same target basic
-          // block. We spare us forking too many times but we generate more
-          // complex condition expressions
-          // TODO Add option to allow to choose between those behaviors
-          std::pair<std::map<BasicBlock *, ref<Expr>>::iterator, bool> res =
-              branchTargets.insert(std::make_pair(
-                  caseSuccessor, ConstantExpr::alloc(0, Expr::Bool)));
-
-          res.first->second = OrExpr::create(match, res.first->second);
-
-          // Only add basic blocks which have not been target of a branch yet
-          if (res.second) {
-            bbOrder.push_back(caseSuccessor);
-          }
-        }
+        matches.push_back(optimizer.optimizeExpr(match, false));
+        matchSuccessors.push_back(caseSuccessor);
       }
 
       auto defaultDest = si->getDefaultDest();
@@ -3121,15 +3289,44 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         defaultValue = notMatches.back();
       }
 
-      if (canReachSomeTargetFromBlock(state, kf->blockMap[defaultDest])) {
-        // Check if control could take the default case
+      bool defaultReachable =
+          canReachSomeTargetFromBlock(state, kf->blockMap[defaultDest]);
+      if (defaultReachable) {
         defaultValue = optimizer.optimizeExpr(defaultValue, false);
-        bool res;
-        bool success = solver->mayBeTrue(state.constraints.cs(), defaultValue,
-                                         res, state.queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void)success;
-        if (res) {
+        matches.push_back(defaultValue);
+      }
+
+      // Check which of the cases control flow could take
+      std::vector<bool> feasible;
+      bool success = solver->mayBeTrue(state.constraints.cs(), matches,
+                                       feasible, state.queryMetaData);
+      assert(success && "FIXME: Unhandled solver failure");
+      (void)success;
+
+      for (unsigned k = 0; k < matchSuccessors.size(); ++k) {
+        if (!feasible[k])
+          continue;
+        // Handle the case that a basic block might be the target of
+        // multiple switch cases. Currently we generate an expression
+        // containing all switch-case values for the same target basic
+        // block. We spare us forking too many times but we generate more
+        // complex condition expressions
+        // TODO Add option to allow to choose between those behaviors
+        std::pair<std::map<BasicBlock *, ref<Expr>>::iterator, bool> res =
+            branchTargets.insert(std::make_pair(
+                matchSuccessors[k], ConstantExpr::alloc(0, Expr::Bool)));
+
+        res.first->second = OrExpr::create(matches[k], res.first->second);
+
+        // Only add basic blocks which have not been target of a branch yet
+        if (res.second) {
+          bbOrder.push_back(matchSuccessors[k]);
+        }
+      }
+
+      if (defaultReachable) {
+        // Check if control could take the default case
+        if (feasible.back()) {
           std::pair<std::map<BasicBlock *, ref<Expr>>::iterator, bool> ret =
               branchTargets.insert(std::make_pair(defaultDest, defaultValue));
           if (ret.second) {
@@ -4481,18 +4678,17 @@ bool Executor::checkMemoryUsage() {
   klee_warning("killing %lu states (over memory cap: %luMB)", toKill,
                totalUsage);
 
-  // randomly select states for early termination
+  // select the states the searcher has not picked for the longest time,
+  // sparing states that covered new code
   std::vector<ExecutionState *> arr(states.begin(),
                                     states.end()); // FIXME: expensive
-  for (unsigned i = 0, N = arr.size(); N && i < toKill; ++i, --N) {
-    unsigned idx = theRNG.getInt32() % N;
-    // Make two pulls to try and not hit a state that
-    // covered new code.
-    if (arr[idx]->isCoveredNew())
-      idx = theRNG.getInt32() % N;
-
-    std::swap(arr[idx], arr[N - 1]);
-    terminateStateEarly(*arr[N - 1], "Memory limit exceeded.",
+  toKill = std::min<size_t>(toKill, arr.size());
+  if (toKill == 0)
+    return false;
+  std::nth_element(arr.begin(), arr.begin() + (toKill - 1), arr.end(),
+                   ExecutionStateColdCompare());
+  for (unsigned i = 0; i < toKill; ++i) {
+    terminateStateEarly(*arr[i], "Memory limit exceeded.",
                         StateTerminationType::OutOfMemory);
   }
 
@@ -4517,8 +4713,25 @@ void Executor::decreaseConfidenceFromStoppedStates(
   }
 }
 
+void Executor::writeCheckpoint() {
+  Checkpoint checkpoint;
+  for (const auto &state : objectManager->getStates())
+    checkpoint.insert(state->branches.begin(), state->branches.end());
+
+  auto file = interpreterHandler->openOutputFile("checkpoint.paths");
+  if (!file) {
+    klee_warning("unable to write checkpoint, losing it");
+    return;
+  }
+  checkpoint.write(*file);
+  klee_message("wrote a checkpoint of %zu states (%zu branch decisions)",
+               objectManager->getStates().size(), checkpoint.size() - 1);
+}
+
 void Executor::doDumpStates() {
   auto &states = objectManager->getStates();
+  if (WriteCheckpoint && !states.empty())
+    writeCheckpoint();
   if (DumpStatesOnHalt == HaltExecution::Reason::NotHalt || states.empty()) {
     interpreterHandler->incPathsExplored(states.size());
     return;
@@ -4786,6 +4999,7 @@ void Executor::goForward(ref<ForwardAction> action) {
   ref<ForwardAction> fa = cast<ForwardAction>(action);
   objectManager->setCurrentState(fa->state);
   ExecutionState &state = *fa->state;
+  state.lastSelected = stats::instructions;
 
   if (coverOnTheFly && shouldWriteTest(state)) {
     fa->state->clearCoveredNew();
@@ -5394,6 +5608,176 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
   }
 }
 
+static bool isNativeValueType(const llvm::Type *t) {
+  if (t->isVoidTy())
+    return true;
+  if (!t->isIntegerTy())
+    return false;
+  switch (t->getIntegerBitWidth()) {
+  case Expr::Bool:
+  case Expr::Int8:
+  case Expr::Int16:
+  case Expr::Int32:
+  case Expr::Int64:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Whether the control flow graph of the function has a cycle, through
+/// which it may run forever
+static bool hasLoop(const llvm::Function *f) {
+  // Depth-first search, looking for an edge back to a block on the path
+  SmallPtrSet<const BasicBlock *, 16> visited, onPath;
+  std::vector<std::pair<const BasicBlock *, const_succ_iterator>> path;
+  const BasicBlock *entry = &f->getEntryBlock();
+  visited.insert(entry);
+  onPath.insert(entry);
+  path.emplace_back(entry, succ_begin(entry));
+  while (!path.empty()) {
+    const BasicBlock *block = path.back().first;
+    if (path.back().second == succ_end(block)) {
+      onPath.erase(block);
+      path.pop_back();
+      continue;
+    }
+    const BasicBlock *next = *path.back().second++;
+    if (onPath.count(next))
+      return true;
+    if (visited.insert(next).second) {
+      onPath.insert(next);
+      path.emplace_back(next, succ_begin(next));
+    }
+  }
+  return false;
+}
+
+bool Executor::isNativelyCallable(const llvm::Function *f) {
+  auto it = nativelyCallable.find(f);
+  if (it != nativelyCallable.end())
+    return it->second;
+  // Recursive calls are not run natively
+  nativelyCallable[f] = false;
+
+  auto check = [this](const llvm::Function *f) {
+    if (f->isDeclaration() || f->isVarArg() ||
+        !isNativeValueType(f->getReturnType()))
+      return false;
+    for (const auto &arg : f->args()) {
+      if (!isNativeValueType(arg.getType()))
+        return false;
+    }
+    // Native code cannot be interrupted by timeouts or halting, so it has
+    // to finish on its own: loops are left to the interpreter
+    if (hasLoop(f))
+      return false;
+
+    for (const auto &inst : llvm::instructions(f)) {
+      if (isa<DbgInfoIntrinsic>(inst))
+        continue;
+      // Floating point is left to the interpreter, which follows the
+      // rounding mode and the floating point support of the state
+      if (inst.getType()->isFPOrFPVectorTy())
+        return false;
+
+      const llvm::Function *callee = nullptr;
+      if (const auto *call = dyn_cast<CallInst>(&inst)) {
+        callee = call->getCalledFunction();
+        if (!callee || call->isInlineAsm())
+          return false;
+        if (callee->isIntrinsic() ? !callee->doesNotAccessMemory()
+                                  : !isNativelyCallable(callee))
+          return false;
+      } else if (isa<AllocaInst>(inst) || isa<UnreachableInst>(inst) ||
+                 inst.isEHPad() || isa<InvokeInst>(inst) ||
+                 isa<CallBrInst>(inst) || inst.mayReadOrWriteMemory()) {
+        return false;
+      }
+
+      // Division traps on a zero divisor, or on an overflow when signed
+      switch (inst.getOpcode()) {
+      case Instruction::UDiv:
+      case Instruction::URem:
+      case Instruction::SDiv:
+      case Instruction::SRem: {
+        const auto *divisor = dyn_cast<ConstantInt>(inst.getOperand(1));
+        bool isSigned = inst.getOpcode() == Instruction::SDiv ||
+                        inst.getOpcode() == Instruction::SRem;
+        if (!divisor || divisor->isZero() ||
+            (isSigned && divisor->isMinusOne()))
+          return false;
+        break;
+      }
+      // Shifts by the width or more are poison, and native shifts mask the
+      // amount instead, so only constant amounts below the width are run
+      case Instruction::Shl:
+      case Instruction::LShr:
+      case Instruction::AShr: {
+        const auto *amount = dyn_cast<ConstantInt>(inst.getOperand(1));
+        if (!amount || amount->getValue().uge(amount->getBitWidth()))
+          return false;
+        break;
+      }
+      default:
+        break;
+      }
+
+      for (const auto &op : inst.operands()) {
+        if (op->getType()->isFPOrFPVectorTy())
+          return false;
+        if (isa<Constant>(op) && !isa<ConstantData>(op) && op != callee)
+          return false;
+      }
+    }
+    return true;
+  };
+
+  return nativelyCallable[f] = check(f);
+}
+
+bool Executor::callNatively(ExecutionState &state, KInstruction *target,
+                            Function *f,
+                            const std::vector<ref<Expr>> &arguments) {
+  // Targeted states have to follow the callee's blocks to their targets
+  if (!state.targetForest.empty() || arguments.size() != f->arg_size() ||
+      target->inst()->getType() != f->getReturnType() ||
+      !isNativelyCallable(f))
+    return false;
+
+  size_t allocatedBytes = Expr::MaxWidth / 8 * (arguments.size() + 1);
+  uint64_t *args = (uint64_t *)alloca(allocatedBytes);
+  memset(args, 0, allocatedBytes);
+  unsigned wordIndex = 2;
+  for (const auto &param : f->args()) {
+    ConstantExpr *ce = dyn_cast<ConstantExpr>(arguments[param.getArgNo()]);
+    // The call may pass other types than the function takes, if bitcast
+    if (!ce || ce->getWidth() != getWidthForLLVMType(param.getType()))
+      return false;
+    ce->toMemory(&args[wordIndex]);
+    wordIndex += (ce->getWidth() + 63) / 64;
+  }
+
+  int roundingMode = LLVMRoundingModeToCRoundingMode(state.roundingMode);
+  if (roundingMode == -1)
+    return false;
+  if (!externalDispatcher->executeNativeCall(kmodule->functionMap[f],
+                                             target->inst(), args,
+                                             roundingMode)) {
+    klee_warning("failed to run %s natively, interpreting it instead",
+                 f->getName().data());
+    nativelyCallable[f] = false;
+    return false;
+  }
+
+  Type *resultType = target->inst()->getType();
+  if (!resultType->isVoidTy())
+    bindLocal(target, state,
+              ConstantExpr::fromMemory((void *)args,
+                                       getWidthForLLVMType(resultType)));
+  return true;
+}
+
 /***/
 
 ref<Expr> Executor::replaceReadWithSymbolic(ExecutionState &state,
@@ -6120,47 +6504,71 @@ bool Executor::checkResolvedMemoryObjects(
       }
     }
   } else {
-    for (unsigned int i = 0; i < mayBeResolvedMemoryObjects.size(); ++i) {
+    unsigned count = mayBeResolvedMemoryObjects.size();
+    std::vector<ref<Expr>> inBounds(count);
+    for (unsigned int i = 0; i < count; ++i) {
       const MemoryObject *mo = mayBeResolvedMemoryObjects.at(i).get();
-
       state.addPointerResolution(address, mo);
+      inBounds[i] = mo->getBoundsCheckPointer(address, bytes);
+    }
 
-      ref<Expr> inBounds = mo->getBoundsCheckPointer(address, bytes);
-      ref<Expr> baseInBounds = Expr::createTrue();
-      ref<Expr> notInBounds = Expr::createIsZero(inBounds);
-      ref<Expr> addressNotInBounds =
-          Expr::createIsZero(mo->getBoundsCheckAddress(address->getValue()));
+    // A lazily initialized object may only be pointed to where none of the
+    // others is, so it is checked on its own, once the others are known. The
+    // others are checked at once.
+    unsigned eager = hasLazyInitialized ? count - 1 : count;
+    std::vector<ref<Expr>> eagerInBounds;
+    for (unsigned int i = 0; i < eager; ++i) {
+      eagerInBounds.push_back(
+          Simplificator::simplifyExpr(state.constraints.cs(), inBounds[i])
+              .simplified);
+    }
+    std::vector<bool> mayBeInBounds;
+    solver->setTimeout(coreSolverTimeout);
+    bool success = solver->mayBeTrue(state.constraints.cs(), eagerInBounds,
+                                     mayBeInBounds, state.queryMetaData);
+    solver->setTimeout(time::Span());
+    if (!success) {
+      return false;
+    }
+
+    for (unsigned int i = 0; i < count; ++i) {
+      const MemoryObject *mo = mayBeResolvedMemoryObjects.at(i).get();
 
-      if (hasLazyInitialized && i == mayBeResolvedMemoryObjects.size() - 1) {
-        inBounds = AndExpr::create(inBounds, checkOutOfBounds);
+      ref<Expr> notInBounds = Expr::createIsZero(inBounds[i]);
+      if (i < eager) {
+        inBounds[i] = eagerInBounds[i];
+      } else {
+        inBounds[i] = AndExpr::create(inBounds[i], checkOutOfBounds);
+        inBounds[i] =
+            Simplificator::simplifyExpr(state.constraints.cs(), inBounds[i])
+                .simplified;
+        bool mayBeInBound;
+        solver->setTimeout(coreSolverTimeout);
+        bool success = solver->mayBeTrue(state.constraints.cs(), inBounds[i],
+                                         mayBeInBound, state.queryMetaData);
+        solver->setTimeout(time::Span());
+        if (!success) {
+          return false;
+        }
+        mayBeInBounds.push_back(mayBeInBound);
+      }
+      if (!mayBeInBounds[i]) {
+        continue;
       }
 
-      inBounds = AndExpr::create(inBounds, baseInBounds);
-      inBounds = Simplificator::simplifyExpr(state.constraints.cs(), inBounds)
-                     .simplified;
       notInBounds =
           Simplificator::simplifyExpr(state.constraints.cs(), notInBounds)
               .simplified;
+      ref<Expr> addressNotInBounds =
+          Expr::createIsZero(mo->getBoundsCheckAddress(address->getValue()));
       addressNotInBounds = Simplificator::simplifyExpr(state.constraints.cs(),
                                                        addressNotInBounds)
                                .simplified;
 
-      bool mayBeInBounds;
-      solver->setTimeout(coreSolverTimeout);
-      bool success = solver->mayBeTrue(state.constraints.cs(), inBounds,
-                                       mayBeInBounds, state.queryMetaData);
-      solver->setTimeout(time::Span());
-      if (!success) {
-        return false;
-      }
-      if (!mayBeInBounds) {
-        continue;
-      }
-
       state.addPointerResolution(address, mo, bytes);
       state.addPointerResolution(basePointer, mo, size);
 
-      resolveConditions.push_back(inBounds);
+      resolveConditions.push_back(inBounds[i]);
       resolvedMemoryObjects.push_back(mo);
       unboundConditions.push_back(addressNotInBounds);
 
@@ -6763,10 +7171,10 @@ void Executor::lazyInitializeLocalObject(ExecutionState &state,
 uint64_t Executor::updateNameVersion(ExecutionState &state,
                                      const std::string &name) {
   uint64_t id = 0;
-  if (state.arrayNames.count(name)) {
-    id = state.arrayNames[name];
+  if (auto version = state.arrayNames.lookup(name)) {
+    id = version->second;
   }
-  state.arrayNames[name] = id + 1;
+  state.arrayNames.replace({name, id + 1});
   return id;
 }
 
@@ -7048,6 +7456,9 @@ void Executor::runFunctionAsMain(Function *f, int argc, char **argv,
     prepareTargetedExecution(*state, forest);
   }
 
+  if (resumeCheckpoint)
+    state->resumeNode = resumeCheckpoint->root();
+
   objectManager->addInitialState(state);
 
   TreeOStream pathOS;
@@ -7665,7 +8076,10 @@ bool Executor::getSymbolicSolution(const ExecutionState &state, KTest &res) {
 
 void Executor::getCoveredLines(const ExecutionState &state,
                                std::map<std::string, std::set<unsigned>> &res) {
-  res = state.coveredLines;
+  res.clear();
+  for (const auto &file : state.coveredLines) {
+    res[file.first].insert(file.second.begin(), file.second.end());
+  }
 }
 
 void Executor::getBlockPath(const ExecutionState &state,
@@ -186,6 +186,10 @@ private:
   /// Used to validate and dereference function pointers.
   std::unordered_map<std::uint64_t, llvm::Function *> legalFunctions;
 
+  /// Whether each function checked so far can be run natively, see
+  /// isNativelyCallable()
+  std::unordered_map<const llvm::Function *, bool> nativelyCallable;
+
   /// Manager for everything related to targeted execution mode
   std::unique_ptr<TargetedExecutionManager> targetedExecutionManager;
 
@@ -200,6 +204,10 @@ private:
   /// object.
   unsigned replayPosition;
 
+  /// When non-null the checkpoint whose branch decisions states follow until
+  /// they reach where the checkpointed run left them.
+  std::unique_ptr<Checkpoint> resumeCheckpoint;
+
   /// When non-null a list of "seed" inputs which will be used to
   /// drive execution.
   const std::vector<struct KTest *> *usingSeeds;
@@ -302,10 +310,26 @@ private:
   void transferToBasicBlock(KBlock *dst, llvm::BasicBlock *src,
                             ExecutionState &state);
 
+  /// Compute the integer operation decoded for the given instruction
+  /// directly, if both its operands are concrete. Returns false if it has to
+  /// be executed as usual instead.
+  bool executeConcreteOp(ExecutionState &state, const KInstruction *ki);
+
   void callExternalFunction(ExecutionState &state, KInstruction *target,
                             KCallable *callable,
                             std::vector<ref<Expr>> &arguments);
 
+  /// Whether calls to the given function of the module may be JIT-compiled
+  /// and run natively: it takes and returns integers only, and neither it
+  /// nor the functions it calls access memory, loop or may trap.
+  bool isNativelyCallable(const llvm::Function *f);
+
+  /// Run a call to the given function of the module natively, if it is
+  /// natively callable and all the arguments are concrete. Returns false if
+  /// the call has to be interpreted instead.
+  bool callNatively(ExecutionState &state, KInstruction *target,
+                    llvm::Function *f, const std::vector<ref<Expr>> &arguments);
+
   ObjectState *bindObjectInState(ExecutionState &state, const MemoryObject *mo,
                                  KType *dynamicType, bool IsAlloca,
                                  const Array *array = nullptr);
@@ -458,6 +482,21 @@ private:
   StatePair forkInternal(ExecutionState &current, ref<Expr> condition,
                          BranchType reason);
 
+  /// Evaluate the branch condition on the state like TimingSolver::evaluate.
+  /// A direction which the model of the state already satisfies is not
+  /// queried, and the other one yields a model. The models of both
+  /// directions are collected only with --fork-models.
+  /// Returns false on solver failure.
+  bool evaluateBranch(ExecutionState &state, ref<Expr> condition,
+                      PartialValidity &result, Assignment &trueModel,
+                      Assignment &falseModel);
+
+  /// Decide a fork of a state resuming a checkpoint by the decisions
+  /// recorded there. When both directions were taken, `falseNode` is where
+  /// the false branch continues. Returns None once the state has reached
+  /// where the checkpointed run left it.
+  PartialValidity resumeBranch(ExecutionState &state, std::uint32_t &falseNode);
+
   // If the MaxStatic*Pct limits have been reached, concretize the condition
   // and return it. Otherwise, return the unmodified condition.
   ref<Expr> maxStaticPctChecks(ExecutionState &current, ref<Expr> condition);
@@ -508,12 +547,12 @@ private:
 
   void setArgumentCell(StackFrame &frame, const KFunction *kf, unsigned index,
                        ref<Expr> value) {
-    return frame.locals->set(kf->getArgRegister(index), Cell(value));
+    return frame.setLocal(kf->getArgRegister(index), Cell(value));
   }
 
   void setDestCell(StackFrame &frame, const KInstruction *target,
                    ref<Expr> value) {
-    return frame.locals->set(target->getDest(), Cell(value));
+    return frame.setLocal(target->getDest(), Cell(value));
   }
 
   const Cell &eval(const KInstruction *ki, unsigned index,
@@ -723,6 +762,7 @@ private:
 
   void printDebugInstructions(ExecutionState &state);
   void doDumpStates();
+  void writeCheckpoint();
 
   /// Only for debug purposes; enable via debugger or klee-control
   void dumpStates();
@@ -10,6 +10,7 @@
 #include "ExternalDispatcher.h"
 
 #include "CoreStats.h"
+#include "klee/Config/Version.h"
 #include "klee/Module/KCallable.h"
 #include "klee/Module/KModule.h"
 
@@ -22,10 +23,12 @@
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include <cfenv>
 #include <csignal>
@@ -54,6 +57,12 @@ private:
   dispatchers_ty dispatchers;
   llvm::Function *createDispatcher(KCallable *target, llvm::Instruction *i,
                                    llvm::Module *module);
+  /// Names of the JIT-compiled copies of the functions of the module under
+  /// test
+  std::map<const llvm::Function *, std::string> nativeFunctions;
+  bool compileNativeFunction(llvm::Function *f);
+  bool dispatchCall(KCallable *callable, llvm::Instruction *i, uint64_t *args,
+                    int roundingMode);
   llvm::ExecutionEngine *executionEngine;
   LLVMContext &ctx;
   std::map<std::string, void *> preboundFunctions;
@@ -68,6 +77,8 @@ public:
   ~ExternalDispatcherImpl();
   bool executeCall(KCallable *callable, llvm::Instruction *i, uint64_t *args,
                    int roundingMode);
+  bool executeNativeCall(KFunction *function, llvm::Instruction *i,
+                         uint64_t *args, int roundingMode);
   void *resolveSymbol(const std::string &name);
   int getLastErrno();
   void setLastErrno(int newErrno);
@@ -163,6 +174,101 @@ ExternalDispatcherImpl::~ExternalDispatcherImpl() {
 bool ExternalDispatcherImpl::executeCall(KCallable *callable, Instruction *i,
                                          uint64_t *args, int roundingMode) {
   ++stats::externalCalls;
+  return dispatchCall(callable, i, args, roundingMode);
+}
+
+bool ExternalDispatcherImpl::executeNativeCall(KFunction *function,
+                                               Instruction *i, uint64_t *args,
+                                               int roundingMode) {
+  if (!compileNativeFunction(function->function()) ||
+      !dispatchCall(function, i, args, roundingMode))
+    return false;
+  ++stats::nativeCalls;
+  return true;
+}
+
+bool ExternalDispatcherImpl::compileNativeFunction(Function *f) {
+  if (nativeFunctions.count(f))
+    return true;
+
+  // Gather the functions called from f which were not compiled before
+  std::vector<Function *> functions = {f};
+  std::set<Function *> seen = {f};
+  for (unsigned k = 0; k < functions.size(); ++k) {
+    for (auto &bb : *functions[k]) {
+      for (auto &inst : bb) {
+        auto *call = dyn_cast<CallInst>(&inst);
+        Function *callee = call ? call->getCalledFunction() : nullptr;
+        if (callee && !callee->isDeclaration() &&
+            !nativeFunctions.count(callee) && seen.insert(callee).second)
+          functions.push_back(callee);
+      }
+    }
+  }
+
+  Module *nativeModule = new Module(getFreshModuleID(), ctx);
+  nativeModule->setDataLayout(f->getParent()->getDataLayout());
+  nativeModule->setTargetTriple(f->getParent()->getTargetTriple());
+
+  // Copies get fresh names, as the module under test may define functions
+  // named like those of KLEE itself
+  ValueToValueMapTy vmap;
+  std::vector<std::pair<Function *, Function *>> clones;
+  for (Function *original : functions) {
+    Function *clone = Function::Create(
+        original->getFunctionType(), GlobalValue::ExternalLinkage,
+        "__klee_native_" + original->getName() + "_" +
+            nativeModule->getModuleIdentifier(),
+        nativeModule);
+    vmap[original] = clone;
+    for (unsigned i = 0; i < original->arg_size(); ++i)
+      vmap[original->getArg(i)] = clone->getArg(i);
+    clones.emplace_back(original, clone);
+  }
+  for (Function *original : functions) {
+    for (auto &bb : *original) {
+      for (auto &inst : bb) {
+        auto *call = dyn_cast<CallInst>(&inst);
+        Function *callee = call ? call->getCalledFunction() : nullptr;
+        if (!callee || vmap.count(callee))
+          continue;
+        auto native = nativeFunctions.find(callee);
+        vmap[callee] = cast<Function>(
+            nativeModule
+                ->getOrInsertFunction(native != nativeFunctions.end()
+                                          ? native->second
+                                          : callee->getName().str(),
+                                      callee->getFunctionType(),
+                                      callee->getAttributes())
+                .getCallee());
+      }
+    }
+  }
+
+  for (auto &[original, clone] : clones) {
+    SmallVector<ReturnInst *, 8> returns;
+#if LLVM_VERSION_CODE >= LLVM_VERSION(13, 0)
+    CloneFunctionInto(clone, original, vmap,
+                      CloneFunctionChangeType::DifferentModule, returns);
+#else
+    CloneFunctionInto(clone, original, vmap, true, returns);
+#endif
+    clone->setLinkage(GlobalValue::ExternalLinkage);
+  }
+  StripDebugInfo(*nativeModule);
+
+  executionEngine->addModule(std::unique_ptr<Module>(nativeModule));
+  for (auto &[original, clone] : clones) {
+    if (!executionEngine->getFunctionAddress(clone->getName().str()))
+      return false;
+    nativeFunctions[original] = clone->getName().str();
+  }
+  executionEngine->finalizeObject();
+  return true;
+}
+
+bool ExternalDispatcherImpl::dispatchCall(KCallable *callable, Instruction *i,
+                                          uint64_t *args, int roundingMode) {
   dispatchers_ty::iterator it = dispatchers.find(i);
   // Save current rounding mode used by KLEE internally and set the
   // rounding mode needed during the external call.
@@ -284,8 +390,14 @@ bool ExternalDispatcherImpl::runProtectedCall(Function *f, uint64_t *args) {
 Function *ExternalDispatcherImpl::createDispatcher(KCallable *target,
                                                    Instruction *inst,
                                                    Module *module) {
-  if (isa<KFunction>(target) && !resolveSymbol(target->getName().str()))
-    return 0;
+  std::string calleeName = target->getName().str();
+  if (auto *func = dyn_cast<KFunction>(target)) {
+    auto native = nativeFunctions.find(func->function());
+    if (native != nativeFunctions.end())
+      calleeName = native->second;
+    else if (!resolveSymbol(calleeName))
+      return 0;
+  }
 
   const CallBase &cb = cast<CallBase>(*inst);
   Value **args = new Value *[cb.arg_size()];
@@ -343,7 +455,7 @@ Function *ExternalDispatcherImpl::createDispatcher(KCallable *target,
   llvm::CallInst *result;
   if (auto *func = dyn_cast<KFunction>(target)) {
     auto dispatchTarget = module->getOrInsertFunction(
-        target->getName(), FTy, func->function()->getAttributes());
+        calleeName, FTy, func->function()->getAttributes());
     result = Builder.CreateCall(dispatchTarget,
                                 llvm::ArrayRef<Value *>(args, args + i));
   } else {
@@ -381,6 +493,12 @@ bool ExternalDispatcher::executeCall(KCallable *callable, llvm::Instruction *i,
   return impl->executeCall(callable, i, args, roundingMode);
 }
 
+bool ExternalDispatcher::executeNativeCall(KFunction *function,
+                                           llvm::Instruction *i,
+                                           uint64_t *args, int roundingMode) {
+  return impl->executeNativeCall(function, i, args, roundingMode);
+}
+
 void *ExternalDispatcher::resolveSymbol(const std::string &name) {
   return impl->resolveSymbol(name);
 }
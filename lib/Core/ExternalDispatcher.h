@@ -21,6 +21,7 @@ class LLVMContext;
 namespace klee {
 class ExternalDispatcherImpl;
 struct KCallable;
+struct KFunction;
 class ExternalDispatcher {
 private:
   ExternalDispatcherImpl *impl;
@@ -35,6 +36,13 @@ public:
    */
   bool executeCall(KCallable *callable, llvm::Instruction *i, uint64_t *args,
                    int roundingMode);
+
+  /* Same as executeCall, for a call to a function of the module under
+   * test. That function is JIT-compiled first, along with the functions it
+   * calls, none of which may access memory.
+   */
+  bool executeNativeCall(KFunction *function, llvm::Instruction *i,
+                         uint64_t *args, int roundingMode);
   void *resolveSymbol(const std::string &name);
 
   int getLastErrno();
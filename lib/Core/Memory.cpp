@@ -45,8 +45,20 @@ llvm::cl::opt<MemoryType> MemoryBackend(
                                 "Use dynamic size data structure"),
                      clEnumValN(MemoryType::Persistent, "persistent",
                                 "Use persistent data structures"),
+                     clEnumValN(MemoryType::Paged, "paged",
+                                "Use copy-on-write pages for objects of "
+                                "constant size"),
                      clEnumValN(MemoryType::Mixed, "mixed",
-                                "Use according to the conditions")),
+                                "Use fixed size data structures for small "
+                                "objects, copy-on-write pages for objects up "
+                                "to --max-paged-structures-size (10Kb to 1Mb "
+                                "by default, which used persistent data "
+                                "structures before) and persistent data "
+                                "structures for larger or symbolically sized "
+                                "ones"),
+                     clEnumValN(MemoryType::Adaptive, "adaptive",
+                                "Choose per allocation site, according to "
+                                "how its objects have been used so far")),
     llvm::cl::init(MemoryType::Fixed));
 
 llvm::cl::opt<unsigned long> MaxFixedSizeStructureSize(
@@ -54,6 +66,13 @@ llvm::cl::opt<unsigned long> MaxFixedSizeStructureSize(
     llvm::cl::desc("Maximum available size to use dense structures for memory "
                    "(default 10Mb)"),
     llvm::cl::init(10ll << 10));
+
+llvm::cl::opt<unsigned long> MaxPagedStructureSize(
+    "max-paged-structures-size",
+    llvm::cl::desc("Maximum size of objects kept in copy-on-write pages by "
+                   "--memory-backend=mixed, larger ones use persistent maps "
+                   "(default 1Mb)"),
+    llvm::cl::init(1ll << 20));
 } // namespace klee
 
 using namespace llvm;
@@ -98,29 +117,109 @@ std::string MemoryObject::getAllocInfo() const {
 
 /***/
 
+/// Objects below this size are always kept in dense arrays
+static const std::uint64_t SmallObjectSize = 64;
+/// Allocations seen at a site before its profile is trusted
+static const std::uint64_t ProfileWarmup = 8;
+
+void AllocationSiteProfile::allocated(ref<Expr> size) {
+  ++objects;
+  if (auto constSize = dyn_cast<ConstantExpr>(size))
+    bytes += constSize->getZExtValue();
+}
+
+MemoryType AllocationSiteProfile::choose(ref<Expr> size) const {
+  // Copies of the objects are frequent, so they should share their contents
+  bool shared = copies >= objects;
+  auto constSize = dyn_cast<ConstantExpr>(size);
+  if (!constSize)
+    return shared ? MemoryType::Persistent : MemoryType::Dynamic;
+
+  std::uint64_t n = constSize->getZExtValue();
+  if (n <= SmallObjectSize || objects < ProfileWarmup)
+    return mixedMemoryType(n);
+
+  // Symbolic writes keep flushing the known bytes into the update list, and
+  // only a few of them ever stay known
+  bool symbolic = symbolicWrites * 2 > writes;
+  // Whether the objects had at least a quarter of their bytes known, as seen
+  // when copied, or else as guessed from the bytes written to them
+  bool dense = copiedBytes ? copiedEntries * 4 >= copiedBytes
+                           : writes * 4 >= bytes;
+  if (symbolic || !dense)
+    return shared ? MemoryType::Persistent : MemoryType::Dynamic;
+  if (shared || n > MaxFixedSizeStructureSize)
+    return MemoryType::Paged;
+  return MemoryType::Fixed;
+}
+
+bool AllocationSiteProfile::isWarm() const { return objects >= ProfileWarmup; }
+
+static AllocationSiteProfile *profileAllocation(const MemoryObject *mo,
+                                                ref<Expr> size) {
+  AllocationSiteProfile *profile =
+      mo && mo->parent ? mo->parent->getProfile(mo->allocSite) : nullptr;
+  if (profile)
+    profile->allocated(size);
+  return profile;
+}
+
+static MemoryType chooseMemoryType(AllocationSiteProfile *profile,
+                                   ref<Expr> size) {
+  return profile ? profile->choose(size) : MemoryBackend;
+}
+
 ObjectState::ObjectState(const MemoryObject *mo, const Array *array, KType *dt)
-    : copyOnWriteOwner(0), object(mo), valueOS(ObjectStage(array, nullptr)),
+    : copyOnWriteOwner(0), object(mo),
+      profile(profileAllocation(mo, array->size)),
+      settledMemoryType(profile && profile->isWarm()),
+      valueOS(ObjectStage(array, nullptr, true, Expr::Int8,
+                          chooseMemoryType(profile, array->size))),
       baseOS(ObjectStage(array->size, Expr::createPointer(0), false,
-                         Context::get().getPointerWidth())),
+                         Context::get().getPointerWidth(),
+                         valueOS.getMemoryType())),
       lastUpdate(nullptr), size(array->size), dynamicType(dt), readOnly(false) {
   baseOS.initializeToZero();
 }
 
 ObjectState::ObjectState(const MemoryObject *mo, KType *dt)
     : copyOnWriteOwner(0), object(mo),
-      valueOS(ObjectStage(mo->getSizeExpr(), nullptr)),
+      profile(profileAllocation(mo, mo->getSizeExpr())),
+      settledMemoryType(profile && profile->isWarm()),
+      valueOS(ObjectStage(mo->getSizeExpr(), nullptr, true, Expr::Int8,
+                          chooseMemoryType(profile, mo->getSizeExpr()))),
       baseOS(ObjectStage(mo->getSizeExpr(), Expr::createPointer(0), false,
-                         Context::get().getPointerWidth())),
+                         Context::get().getPointerWidth(),
+                         valueOS.getMemoryType())),
       lastUpdate(nullptr), size(mo->getSizeExpr()), dynamicType(dt),
       readOnly(false) {
   baseOS.initializeToZero();
 }
 
 ObjectState::ObjectState(const ObjectState &os)
-    : copyOnWriteOwner(0), object(os.object), valueOS(os.valueOS),
+    : copyOnWriteOwner(0), object(os.object), profile(os.profile),
+      settledMemoryType(os.settledMemoryType), valueOS(os.valueOS),
       baseOS(os.baseOS), lastUpdate(os.lastUpdate), size(os.size),
       dynamicType(os.dynamicType), readOnly(os.readOnly),
-      wasWritten(os.wasWritten) {}
+      wasWritten(os.wasWritten) {
+  if (!profile)
+    return;
+
+  ++profile->copies;
+  if (auto constSize = dyn_cast<ConstantExpr>(size)) {
+    profile->copiedEntries += valueOS.getKnownBytes();
+    profile->copiedBytes += constSize->getZExtValue();
+  }
+
+  // The copy is about to be written, so this is where a representation
+  // chosen before the site's use was known is replaced, once per object
+  if (settledMemoryType || !profile->isWarm())
+    return;
+  MemoryType type = profile->choose(size);
+  valueOS.setMemoryType(type);
+  baseOS.setMemoryType(type);
+  settledMemoryType = true;
+}
 
 /***/
 
@@ -223,6 +322,8 @@ ref<Expr> ObjectState::readBase8(ref<Expr> offset) const {
 }
 
 void ObjectState::write8(unsigned offset, uint8_t value) {
+  if (profile)
+    profile->written(false);
   valueOS.writeWidth(offset, value);
   baseOS.writeWidth(offset,
                     ConstantExpr::create(0, Context::get().getPointerWidth()));
@@ -230,6 +331,8 @@ void ObjectState::write8(unsigned offset, uint8_t value) {
 
 void ObjectState::write8(unsigned offset, ref<Expr> value) {
   wasWritten = true;
+  if (profile)
+    profile->written(!isa<ConstantExpr>(value));
   if (auto pointer = dyn_cast<PointerExpr>(value)) {
     valueOS.writeWidth(offset, pointer->getValue());
     baseOS.writeWidth(offset, pointer->getBase());
@@ -242,6 +345,8 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
 
 void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
   wasWritten = true;
+  if (profile)
+    profile->written(true);
 
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic write8");
@@ -520,26 +625,49 @@ bool ObjectState::isAccessableFrom(KType *accessingType) const {
 /***/
 
 ObjectStage::ObjectStage(const Array *array, ref<Expr> defaultValue, bool safe,
-                         Expr::Width width)
-    : updates(array, nullptr), size(array->size), safeRead(safe), width(width) {
+                         Expr::Width width, MemoryType type)
+    : updates(array, nullptr), size(array->size), safeRead(safe), width(width),
+      type(type) {
   knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
-      array->getSize(), defaultValue, MaxFixedSizeStructureSize));
-  unflushedMask.reset(
-      constructStorage(array->getSize(), false, MaxFixedSizeStructureSize));
+      array->getSize(), defaultValue, MaxFixedSizeStructureSize, type));
+  unflushedMask.reset(constructStorage(array->getSize(), false,
+                                       MaxFixedSizeStructureSize, type));
 }
 
 ObjectStage::ObjectStage(ref<Expr> size, ref<Expr> defaultValue, bool safe,
-                         Expr::Width width)
-    : updates(nullptr, nullptr), size(size), safeRead(safe), width(width) {
+                         Expr::Width width, MemoryType type)
+    : updates(nullptr, nullptr), size(size), safeRead(safe), width(width),
+      type(type) {
   knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
-      size, defaultValue, MaxFixedSizeStructureSize));
-  unflushedMask.reset(constructStorage(size, false, MaxFixedSizeStructureSize));
+      size, defaultValue, MaxFixedSizeStructureSize, type));
+  unflushedMask.reset(
+      constructStorage(size, false, MaxFixedSizeStructureSize, type));
 }
 
 ObjectStage::ObjectStage(const ObjectStage &os)
     : knownSymbolics(os.knownSymbolics->clone()),
       unflushedMask(os.unflushedMask->clone()), updates(os.updates),
-      size(os.size), safeRead(os.safeRead), width(os.width) {}
+      size(os.size), safeRead(os.safeRead), width(os.width), type(os.type) {}
+
+void ObjectStage::setMemoryType(MemoryType newType) {
+  if (type == newType)
+    return;
+
+  std::unique_ptr<storage_ty> symbolics(
+      constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
+          size, knownSymbolics->defaultV(), MaxFixedSizeStructureSize,
+          newType));
+  for (const auto &byte : knownSymbolics->storage())
+    symbolics->store(byte.first, byte.second);
+  std::unique_ptr<bool_storage_ty> mask(
+      constructStorage(size, false, MaxFixedSizeStructureSize, newType));
+  for (const auto &unflushed : unflushedMask->storage())
+    mask->store(unflushed.first, unflushed.second);
+
+  knownSymbolics = std::move(symbolics);
+  unflushedMask = std::move(mask);
+  type = newType;
+}
 
 /***/
 
@@ -690,6 +818,7 @@ void ObjectStage::write(const ObjectStage &os) {
   } else {
     knownSymbolics.reset(os.knownSymbolics->clone());
     unflushedMask.reset(os.unflushedMask->clone());
+    type = os.type;
   }
   updates = UpdateList(updates.root, os.updates.head);
 }
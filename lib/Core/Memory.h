@@ -11,6 +11,7 @@
 #define KLEE_MEMORY_H
 
 #include "CodeLocation.h"
+#include "ConstructStorage.h"
 #include "MemoryManager.h"
 #include "klee/ADT/Ref.h"
 #include "klee/ADT/SparseStorage.h"
@@ -213,6 +214,36 @@ public:
   bool equals(const MemoryObject &b) const { return compare(b) == 0; }
 };
 
+/// AllocationSiteProfile - How the objects allocated at one site have been
+/// used so far. With --memory-backend=adaptive, it picks the representation
+/// of the next objects allocated there, and of the copies made of the
+/// current ones when a forked state writes to them.
+class AllocationSiteProfile {
+public:
+  /// Objects allocated at the site, and their total constant size
+  std::uint64_t objects = 0;
+  std::uint64_t bytes = 0;
+  /// Bytes written to them, and how many of those were symbolic
+  std::uint64_t writes = 0;
+  std::uint64_t symbolicWrites = 0;
+  /// Copies made of them for states writing to objects shared after a fork
+  std::uint64_t copies = 0;
+  /// Known bytes found in the copied objects, out of their total size
+  std::uint64_t copiedEntries = 0;
+  std::uint64_t copiedBytes = 0;
+
+  void allocated(ref<Expr> size);
+  void written(bool symbolic) {
+    ++writes;
+    symbolicWrites += symbolic;
+  }
+
+  /// The representation to use for an object of the given size
+  MemoryType choose(ref<Expr> size) const;
+  /// Whether enough objects were seen for choose() to rely on the profile
+  bool isWarm() const;
+};
+
 class ObjectStage {
 private:
   using storage_ty = SparseStorage<ref<Expr>, OptionalRefEq<Expr>>;
@@ -231,12 +262,14 @@ private:
   ref<Expr> size;
   bool safeRead;
   Expr::Width width;
+  /// The representation of knownSymbolics and unflushedMask
+  MemoryType type;
 
 public:
   ObjectStage(const Array *array, ref<Expr> defaultValue, bool safe = true,
-              Expr::Width width = Expr::Int8);
+              Expr::Width width = Expr::Int8, MemoryType type = MemoryBackend);
   ObjectStage(ref<Expr> size, ref<Expr> defaultValue, bool safe = true,
-              Expr::Width width = Expr::Int8);
+              Expr::Width width = Expr::Int8, MemoryType type = MemoryBackend);
 
   ObjectStage(const ObjectStage &os);
   ~ObjectStage() = default;
@@ -256,8 +289,13 @@ public:
   size_t getSparseStorageEntries() {
     return knownSymbolics->storage().size() + unflushedMask->storage().size();
   }
+  size_t getKnownBytes() const { return knownSymbolics->storage().size(); }
   void initializeToZero();
 
+  MemoryType getMemoryType() const { return type; }
+  /// Move the known bytes to storage of the given representation
+  void setMemoryType(MemoryType newType);
+
 private:
   const UpdateList &getUpdates() const;
 
@@ -280,6 +318,14 @@ private:
 
   ref<const MemoryObject> object;
 
+  /// The profile of the object's allocation site, if backends are chosen
+  /// per site
+  AllocationSiteProfile *profile;
+  /// Whether the representation was chosen from a warm profile. Until then,
+  /// the first copy made afterwards converts it, and copies of that copy
+  /// keep its representation.
+  bool settledMemoryType;
+
   ObjectStage valueOS;
   ObjectStage baseOS;
 
@@ -237,6 +237,16 @@ void MemoryManager::markFreed(MemoryObject *mo) {
   }
 }
 
+AllocationSiteProfile *
+MemoryManager::getProfile(const ref<CodeLocation> &allocSite) {
+  if (MemoryBackend != MemoryType::Adaptive || !allocSite || !allocSite->source)
+    return nullptr;
+  auto &profile = profiles[allocSite->source];
+  if (!profile)
+    profile = std::make_unique<AllocationSiteProfile>();
+  return profile.get();
+}
+
 size_t MemoryManager::getUsedDeterministicSize() {
   return nextFreeSlot - deterministicSpace;
 }
@@ -14,16 +14,20 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <set>
+#include <unordered_map>
 
 namespace llvm {
 class Value;
 }
 
 namespace klee {
+class AllocationSiteProfile;
 class KType;
 class MemoryObject;
 struct CodeLocation;
+struct KValue;
 
 typedef uint64_t IDType;
 
@@ -36,6 +40,10 @@ private:
   char *nextFreeSlot;
   size_t spaceSize;
 
+  /// Profiles of the allocation sites, with --memory-backend=adaptive
+  std::unordered_map<const KValue *, std::unique_ptr<AllocationSiteProfile>>
+      profiles;
+
 public:
   MemoryManager();
   ~MemoryManager();
@@ -54,6 +62,9 @@ public:
   MemoryObject *allocateFixed(uint64_t address, uint64_t size,
                               ref<CodeLocation> allocSite, KType *type);
   void markFreed(MemoryObject *mo);
+  /// The profile of the given allocation site, or null if backends are not
+  /// chosen per site
+  AllocationSiteProfile *getProfile(const ref<CodeLocation> &allocSite);
   /*
    * Returns the size used by deterministic allocation in bytes
    */
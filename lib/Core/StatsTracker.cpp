@@ -401,7 +401,11 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
         //
         // FIXME: This trick no longer works, we should fix this in the line
         // number propogation.
-        es.coveredLines[ki->getSourceFilepath()].insert(ki->getLine());
+        PersistentSet<unsigned> lines;
+        if (auto covered = es.coveredLines.lookup(ki->getSourceFilepath()))
+          lines = covered->second;
+        lines.insert(ki->getLine());
+        es.coveredLines.replace({ki->getSourceFilepath(), lines});
         es.instsSinceCovNew = 1;
         ++stats::coveredInstructions;
         stats::uncoveredInstructions += (uint64_t)-1;
@@ -517,6 +521,8 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCexCacheHits INTEGER,"
          << "InhibitedForks INTEGER,"
          << "ExternalCalls INTEGER,"
+         << "ForkModelHits INTEGER,"
+         << "NativeCalls INTEGER,"
          << "Allocations INTEGER,"
          << "States INTEGER," BRANCH_TYPES TERMINATION_CLASSES
          << "ArrayHashTime INTEGER" << ')';
@@ -566,6 +572,8 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCexCacheHits,"
          << "InhibitedForks,"
          << "ExternalCalls,"
+         << "ForkModelHits,"
+         << "NativeCalls,"
          << "Allocations,"
          << "States," BRANCH_TYPES TERMINATION_CLASSES << "ArrayHashTime"
          << ')';
@@ -599,6 +607,8 @@ void StatsTracker::writeStatsHeader() {
          << "?,"
          << "?,"
          << "?,"
+         << "?,"
+         << "?,"
          << "?," BRANCH_TYPES TERMINATION_CLASSES << "? " << ')';
 
   if (sqlite3_prepare_v2(statsFile, insert.str().c_str(), -1, &insertStmt,
@@ -648,6 +658,8 @@ void StatsTracker::writeStatsLine() {
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheHits);
   sqlite3_bind_int64(insertStmt, arg++, stats::inhibitedForks);
   sqlite3_bind_int64(insertStmt, arg++, stats::externalCalls);
+  sqlite3_bind_int64(insertStmt, arg++, stats::forkModelHits);
+  sqlite3_bind_int64(insertStmt, arg++, stats::nativeCalls);
   sqlite3_bind_int64(insertStmt, arg++, stats::allocations);
   sqlite3_bind_int64(insertStmt, arg++, ExecutionState::getLastID());
   BRANCH_TYPES
@@ -20,6 +20,9 @@
 
 #include "CoreStats.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace klee;
 using namespace llvm;
 
@@ -50,27 +53,7 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
                      : solver->evaluate(query, result);
 
   if (success && produceValidityCore) {
-    if (isa<ValidResponse>(queryResult) &&
-        isa<InvalidResponse>(negatedQueryResult)) {
-      result = PValidity::MustBeTrue;
-    } else if (isa<InvalidResponse>(queryResult) &&
-               isa<ValidResponse>(negatedQueryResult)) {
-      result = PValidity::MustBeFalse;
-    } else if (isa<InvalidResponse>(queryResult) &&
-               isa<InvalidResponse>(negatedQueryResult)) {
-      result = PValidity::TrueOrFalse;
-    } else if (isa<InvalidResponse>(queryResult) &&
-               isa<UnknownResponse>(negatedQueryResult)) {
-      result = PValidity::MayBeFalse;
-    } else if (isa<UnknownResponse>(queryResult) &&
-               isa<InvalidResponse>(negatedQueryResult)) {
-      result = PValidity::MayBeTrue;
-    } else if (isa<UnknownResponse>(queryResult) &&
-               isa<UnknownResponse>(negatedQueryResult)) {
-      result = PValidity::None;
-    } else {
-      assert(0 && "unreachable");
-    }
+    result = toPartial(queryResult, negatedQueryResult);
   }
 
   metaData.queryCost += timer.delta();
@@ -153,6 +136,36 @@ bool TimingSolver::mayBeTrue(const ConstraintSet &constraints, ref<Expr> expr,
   return true;
 }
 
+bool TimingSolver::mayBeTrue(const ConstraintSet &constraints,
+                             const std::vector<ref<Expr>> &conditions,
+                             std::vector<bool> &result,
+                             SolverQueryMetaData &metaData) {
+  // The batch is a single query, however many conditions it checks
+  ++stats::queries;
+  // Fast path, to avoid timer and OS overhead.
+  if (std::all_of(conditions.begin(), conditions.end(),
+                  [](const ref<Expr> &e) { return isa<ConstantExpr>(e); })) {
+    result.clear();
+    for (const auto &condition : conditions)
+      result.push_back(cast<ConstantExpr>(condition)->isTrue());
+    return true;
+  }
+
+  TimerStatIncrementer timer(stats::solverTime);
+
+  std::vector<ref<Expr>> exprs(conditions);
+  if (simplifyExprs)
+    for (auto &expr : exprs)
+      expr = Simplificator::simplifyExpr(constraints, expr).simplified;
+
+  bool success = solver->mayBeTrue(
+      Query(constraints, Expr::createFalse(), metaData.id), exprs, result);
+
+  metaData.queryCost += timer.delta();
+
+  return success;
+}
+
 bool TimingSolver::mayBeFalse(const ConstraintSet &constraints, ref<Expr> expr,
                               bool &result, SolverQueryMetaData &metaData,
                               bool produceValidityCore) {
@@ -80,6 +80,12 @@ public:
                  SolverQueryMetaData &metaData,
                  bool produceValidityCore = false);
 
+  /// Determine for each of the given conditions whether it may be true,
+  /// checking all of them in a single query to the solver.
+  bool mayBeTrue(const ConstraintSet &,
+                 const std::vector<ref<Expr>> &conditions,
+                 std::vector<bool> &result, SolverQueryMetaData &metaData);
+
   bool mayBeFalse(const ConstraintSet &, ref<Expr>, bool &result,
                   SolverQueryMetaData &metaData,
                   bool produceValidityCore = false);
@@ -9,6 +9,8 @@
 
 #include "klee/Expr/Expr.h"
 
+#include "ExprAllocator.h"
+
 #include "klee/Config/Version.h"
 #include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/ExprPPrinter.h"
@@ -566,8 +568,42 @@ std::string Expr::toString() const {
 
 /***/
 
+namespace {
+/// Bytes allocated for interned nodes, per kind
+thread_local uint64_t allocatedBytesByKind[Expr::LastKind + 1];
+} // namespace
+
+void *Expr::operator new(size_t size) { return ExprAllocator::allocate(size); }
+
+void Expr::operator delete(void *p, size_t size) {
+  ExprAllocator::deallocate(p, size);
+}
+
+void Expr::recordAllocation(const Expr *e) {
+  allocatedBytesByKind[e->getKind()] += ExprAllocator::blockSize(e);
+}
+
+void Expr::printAllocationStats(llvm::raw_ostream &os) {
+  uint64_t total = 0;
+  for (int k = 0; k <= LastKind; ++k) {
+    if (!allocatedBytesByKind[k])
+      continue;
+    os << "KLEE: done: expr bytes allocated (";
+    printKind(os, static_cast<Kind>(k));
+    os << ") = " << allocatedBytesByKind[k] << "\n";
+    total += allocatedBytesByKind[k];
+  }
+  os << "KLEE: done: expr bytes allocated (UpdateNode) = "
+     << UpdateNode::allocatedBytes() << "\n";
+  total += UpdateNode::allocatedBytes();
+  os << "KLEE: done: expr bytes allocated = " << total << "\n";
+  os << "KLEE: done: expr slab bytes reserved = "
+     << ExprAllocator::reservedBytes() << "\n";
+}
+
 Expr::ExprCacheSet Expr::cachedExpressions;
 Expr::ConstantExprCacheSet Expr::cachedConstantExpressions;
+ConstantExpr *ConstantExpr::smallConstants[ConstantExpr::SmallConstantSlots];
 
 Expr::~Expr() {
   Expr::count--;
@@ -585,6 +621,12 @@ ConstantExpr::~ConstantExpr() {
       cachedExpressions.cache.erase(this);
     } else {
       cachedConstantExpressions.cache.erase(value);
+      if (getWidth() <= 64) {
+        ConstantExpr *&slot =
+            smallConstants[smallConstantSlot(value.getZExtValue(), getWidth())];
+        if (slot == this)
+          slot = nullptr;
+      }
     }
     isCached = false;
   }
@@ -599,15 +641,15 @@ Expr::ConstantExprCacheSet::~ConstantExprCacheSet() {
 }
 
 ref<Expr> Expr::createCachedExpr(ref<Expr> e) {
-  std::pair<CacheType::const_iterator, bool> success;
-  success = cachedExpressions.cache.insert(e.get());
+  std::pair<Expr *, bool> success = cachedExpressions.cache.insert(e.get());
   if (success.second) {
     // Cache miss
     e->isCached = true;
+    recordAllocation(e.get());
     return e;
   }
   // Cache hit
-  return (ref<Expr>)*(success.first);
+  return ref<Expr>(success.first);
 }
 /***/
 
@@ -1169,6 +1211,92 @@ ref<ConstantExpr> ConstantExpr::Sge(const ref<ConstantExpr> &RHS) {
   return ConstantExpr::alloc(value.sge(RHS->value), Expr::Bool);
 }
 
+ref<ConstantExpr> ConstantExpr::evaluate(Kind kind, Width width, uint64_t left,
+                                         uint64_t right) {
+  assert(width && width <= 64 && "invalid width");
+  uint64_t a = bits64::truncateToNBits(left, width);
+  uint64_t b = bits64::truncateToNBits(right, width);
+  unsigned unused = 64 - width;
+  int64_t sa = static_cast<int64_t>(a << unused) >> unused;
+  int64_t sb = static_cast<int64_t>(b << unused) >> unused;
+
+  uint64_t result;
+  switch (kind) {
+  case Expr::Add:
+    result = a + b;
+    break;
+  case Expr::Sub:
+    result = a - b;
+    break;
+  case Expr::Mul:
+    result = a * b;
+    break;
+  case Expr::UDiv:
+    if (!b)
+      return nullptr;
+    result = a / b;
+    break;
+  case Expr::URem:
+    if (!b)
+      return nullptr;
+    result = a % b;
+    break;
+  // The only signed overflow, of the smallest value by -1, wraps around
+  case Expr::SDiv:
+    if (!b)
+      return nullptr;
+    result = sb == -1 ? 0 - a : static_cast<uint64_t>(sa / sb);
+    break;
+  case Expr::SRem:
+    if (!b)
+      return nullptr;
+    result = sb == -1 ? 0 : static_cast<uint64_t>(sa % sb);
+    break;
+  case Expr::And:
+    result = a & b;
+    break;
+  case Expr::Or:
+    result = a | b;
+    break;
+  case Expr::Xor:
+    result = a ^ b;
+    break;
+  // Shifts by the width or more behave as llvm::APInt's
+  case Expr::Shl:
+    result = b >= width ? 0 : a << b;
+    break;
+  case Expr::LShr:
+    result = b >= width ? 0 : a >> b;
+    break;
+  case Expr::AShr:
+    result = sa >> (b >= width ? width - 1 : b);
+    break;
+  case Expr::Eq:
+    return ConstantExpr::alloc(a == b, Expr::Bool);
+  case Expr::Ne:
+    return ConstantExpr::alloc(a != b, Expr::Bool);
+  case Expr::Ult:
+    return ConstantExpr::alloc(a < b, Expr::Bool);
+  case Expr::Ule:
+    return ConstantExpr::alloc(a <= b, Expr::Bool);
+  case Expr::Ugt:
+    return ConstantExpr::alloc(a > b, Expr::Bool);
+  case Expr::Uge:
+    return ConstantExpr::alloc(a >= b, Expr::Bool);
+  case Expr::Slt:
+    return ConstantExpr::alloc(sa < sb, Expr::Bool);
+  case Expr::Sle:
+    return ConstantExpr::alloc(sa <= sb, Expr::Bool);
+  case Expr::Sgt:
+    return ConstantExpr::alloc(sa > sb, Expr::Bool);
+  case Expr::Sge:
+    return ConstantExpr::alloc(sa >= sb, Expr::Bool);
+  default:
+    return nullptr;
+  }
+  return ConstantExpr::alloc(bits64::truncateToNBits(result, width), width);
+}
+
 // Floating point
 
 ref<ConstantExpr> ConstantExpr::GetNaN(Expr::Width w) {
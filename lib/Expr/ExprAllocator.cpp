@@ -0,0 +1,188 @@
+//===-- ExprAllocator.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ExprAllocator.h"
+
+#include "llvm/Support/ErrorHandling.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+
+using namespace klee;
+
+namespace {
+struct SlabHeader {
+  size_t blockSize;
+};
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+/// Blocks start after the header, keeping the allocator's alignment.
+constexpr size_t HeaderSize =
+    (sizeof(SlabHeader) + ExprAllocator::Granularity - 1) &
+    ~(ExprAllocator::Granularity - 1);
+
+struct SizeClass {
+  FreeBlock *freeList = nullptr;
+  /// Unused tail of the last slab of this class
+  char *bump = nullptr;
+  char *bumpEnd = nullptr;
+  uint64_t allocatedBytes = 0;
+};
+
+/// Free blocks left behind by exited threads, per size class
+std::atomic<FreeBlock *> orphans[ExprAllocator::SizeClasses];
+
+/// Push the list [head, tail] onto the orphaned blocks of a size class.
+void orphan(size_t index, FreeBlock *head, FreeBlock *tail) {
+  FreeBlock *top = orphans[index].load(std::memory_order_relaxed);
+  do {
+    tail->next = top;
+  } while (!orphans[index].compare_exchange_weak(
+      top, head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/// Set once the cache of the thread is destroyed. Being trivially
+/// destructible, it stays readable while the thread's other destructors run,
+/// which may still allocate and free nodes; those go to the orphans.
+thread_local bool threadCacheDestroyed = false;
+
+struct ThreadCache {
+  SizeClass sizeClasses[ExprAllocator::SizeClasses];
+
+  /// Hand the free blocks and unused slab tails over to other threads.
+  ~ThreadCache() {
+    for (size_t index = 0; index < ExprAllocator::SizeClasses; ++index) {
+      SizeClass &sc = sizeClasses[index];
+      size_t blockSize = (index + 1) * ExprAllocator::Granularity;
+      for (; sc.bumpEnd - sc.bump >= static_cast<ptrdiff_t>(blockSize);
+           sc.bump += blockSize) {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(sc.bump);
+        block->next = sc.freeList;
+        sc.freeList = block;
+      }
+      if (FreeBlock *head = sc.freeList) {
+        FreeBlock *tail = head;
+        while (tail->next)
+          tail = tail->next;
+        orphan(index, head, tail);
+        sc.freeList = nullptr;
+      }
+    }
+    threadCacheDestroyed = true;
+  }
+};
+
+thread_local ThreadCache threadCache;
+
+std::atomic<uint64_t> reservedSlabBytes;
+
+void *allocateSlab(size_t bytes, size_t blockSize) {
+  void *slab = std::aligned_alloc(ExprAllocator::SlabSize, bytes);
+  if (!slab)
+    llvm::report_bad_alloc_error("Allocation of an expression slab failed");
+  static_cast<SlabHeader *>(slab)->blockSize = blockSize;
+  reservedSlabBytes += bytes;
+  return slab;
+}
+
+/// Allocate a block without the cache of the thread, which is destroyed.
+void *allocateOrphan(size_t index, size_t blockSize) {
+  // Taking the whole list avoids the ABA problem of popping a single block
+  FreeBlock *head = orphans[index].exchange(nullptr, std::memory_order_acquire);
+  if (!head) {
+    char *slab = static_cast<char *>(
+        allocateSlab(ExprAllocator::SlabSize, blockSize));
+    for (char *p = slab + HeaderSize;
+         ExprAllocator::SlabSize - (p - slab) >= blockSize; p += blockSize) {
+      FreeBlock *block = reinterpret_cast<FreeBlock *>(p);
+      block->next = head;
+      head = block;
+    }
+  }
+  if (FreeBlock *rest = head->next) {
+    FreeBlock *tail = rest;
+    while (tail->next)
+      tail = tail->next;
+    orphan(index, rest, tail);
+  }
+  return head;
+}
+} // namespace
+
+void *ExprAllocator::allocate(size_t size) {
+  if (size > MaxBlockSize) {
+    // Oversized nodes get a slab of their own
+    size_t bytes = (HeaderSize + size + SlabSize - 1) & ~(SlabSize - 1);
+    return static_cast<char *>(allocateSlab(bytes, size)) + HeaderSize;
+  }
+
+  size_t index = size ? (size - 1) / Granularity : 0;
+  size_t blockSize = (index + 1) * Granularity;
+  if (threadCacheDestroyed)
+    return allocateOrphan(index, blockSize);
+  SizeClass &sc = threadCache.sizeClasses[index];
+  sc.allocatedBytes += blockSize;
+
+  if (!sc.freeList && orphans[index].load(std::memory_order_relaxed))
+    sc.freeList = orphans[index].exchange(nullptr, std::memory_order_acquire);
+  if (FreeBlock *block = sc.freeList) {
+    sc.freeList = block->next;
+    return block;
+  }
+  if (sc.bumpEnd - sc.bump < static_cast<ptrdiff_t>(blockSize)) {
+    char *slab = static_cast<char *>(allocateSlab(SlabSize, blockSize));
+    sc.bump = slab + HeaderSize;
+    sc.bumpEnd = slab + SlabSize;
+  }
+  void *block = sc.bump;
+  sc.bump += blockSize;
+  return block;
+}
+
+void ExprAllocator::deallocate(void *p, size_t size) {
+  if (!p)
+    return;
+  if (size > MaxBlockSize) {
+    char *slab = static_cast<char *>(p) - HeaderSize;
+    reservedSlabBytes -= (HeaderSize + size + SlabSize - 1) & ~(SlabSize - 1);
+    std::free(slab);
+    return;
+  }
+
+  assert(blockSize(p) == ((size ? (size - 1) / Granularity : 0) + 1) *
+                             Granularity &&
+         "size does not match the block");
+  size_t index = size ? (size - 1) / Granularity : 0;
+  FreeBlock *block = static_cast<FreeBlock *>(p);
+  if (threadCacheDestroyed) {
+    orphan(index, block, block);
+    return;
+  }
+  SizeClass &sc = threadCache.sizeClasses[index];
+  block->next = sc.freeList;
+  sc.freeList = block;
+}
+
+size_t ExprAllocator::blockSize(const void *p) {
+  auto slab = reinterpret_cast<uintptr_t>(p) & ~(uintptr_t(SlabSize) - 1);
+  return reinterpret_cast<const SlabHeader *>(slab)->blockSize;
+}
+
+uint64_t ExprAllocator::allocatedBytes(size_t sizeClass) {
+  assert(sizeClass < SizeClasses);
+  if (threadCacheDestroyed)
+    return 0;
+  return threadCache.sizeClasses[sizeClass].allocatedBytes;
+}
+
+uint64_t ExprAllocator::reservedBytes() { return reservedSlabBytes.load(); }
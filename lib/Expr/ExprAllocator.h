@@ -0,0 +1,56 @@
+//===-- ExprAllocator.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_EXPRALLOCATOR_H
+#define KLEE_EXPRALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace klee {
+
+/// ExprAllocator - A size-class slab allocator for expression and update
+/// nodes.
+///
+/// Nodes are carved out of 64KiB slabs, one free list per 16-byte size class
+/// and thread. Every slab starts with a header recording its block size,
+/// which makes the size of any node known from its address alone.
+///
+/// Slabs of small nodes are never returned to the system, so a node may be
+/// freed by a different thread than the one which allocated it. Freed blocks
+/// are reused instead: a thread which runs out of free blocks first takes over
+/// the free lists left behind by exited threads. The bytes held by these slabs
+/// are thus bounded by the peak bytes of live nodes of each size class, plus
+/// the unused tail of one slab per size class and thread. Oversized nodes get
+/// a slab of their own, which is released with std::free() as soon as the
+/// node is deallocated.
+class ExprAllocator {
+public:
+  static constexpr size_t Granularity = 16;
+  static constexpr size_t SizeClasses = 16;
+  static constexpr size_t MaxBlockSize = Granularity * SizeClasses;
+  static constexpr size_t SlabSize = size_t(1) << 16;
+
+  static void *allocate(size_t size);
+  static void deallocate(void *p, size_t size);
+
+  /// The size of the block holding the node at `p`.
+  static size_t blockSize(const void *p);
+
+  /// Bytes handed out so far by the calling thread for blocks of the given
+  /// size class, including blocks freed since then.
+  static uint64_t allocatedBytes(size_t sizeClass);
+
+  /// Bytes currently held by slabs.
+  static uint64_t reservedBytes();
+};
+
+} // namespace klee
+
+#endif /* KLEE_EXPRALLOCATOR_H */
@@ -9,12 +9,30 @@
 
 #include "klee/Expr/Expr.h"
 
+#include "ExprAllocator.h"
+
 #include <cassert>
 
 using namespace klee;
 
 ///
 
+namespace {
+thread_local uint64_t updateNodeBytes = 0;
+} // namespace
+
+void *UpdateNode::operator new(size_t size) {
+  void *p = ExprAllocator::allocate(size);
+  updateNodeBytes += ExprAllocator::blockSize(p);
+  return p;
+}
+
+void UpdateNode::operator delete(void *p, size_t size) {
+  ExprAllocator::deallocate(p, size);
+}
+
+uint64_t UpdateNode::allocatedBytes() { return updateNodeBytes; }
+
 UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
                        const ref<Expr> &_value)
     : next(_next), index(_index), value(_value) {
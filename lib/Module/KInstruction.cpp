@@ -40,6 +40,66 @@ static int getOperandNum(
   }
 }
 
+static Expr::Kind decodeConcreteKind(const Instruction *inst) {
+  if (const auto *cmp = dyn_cast<ICmpInst>(inst)) {
+    switch (cmp->getPredicate()) {
+    case ICmpInst::ICMP_EQ:
+      return Expr::Eq;
+    case ICmpInst::ICMP_NE:
+      return Expr::Ne;
+    case ICmpInst::ICMP_ULT:
+      return Expr::Ult;
+    case ICmpInst::ICMP_ULE:
+      return Expr::Ule;
+    case ICmpInst::ICMP_UGT:
+      return Expr::Ugt;
+    case ICmpInst::ICMP_UGE:
+      return Expr::Uge;
+    case ICmpInst::ICMP_SLT:
+      return Expr::Slt;
+    case ICmpInst::ICMP_SLE:
+      return Expr::Sle;
+    case ICmpInst::ICMP_SGT:
+      return Expr::Sgt;
+    case ICmpInst::ICMP_SGE:
+      return Expr::Sge;
+    default:
+      return Expr::InvalidKind;
+    }
+  }
+
+  switch (inst->getOpcode()) {
+  case Instruction::Add:
+    return Expr::Add;
+  case Instruction::Sub:
+    return Expr::Sub;
+  case Instruction::Mul:
+    return Expr::Mul;
+  case Instruction::UDiv:
+    return Expr::UDiv;
+  case Instruction::SDiv:
+    return Expr::SDiv;
+  case Instruction::URem:
+    return Expr::URem;
+  case Instruction::SRem:
+    return Expr::SRem;
+  case Instruction::And:
+    return Expr::And;
+  case Instruction::Or:
+    return Expr::Or;
+  case Instruction::Xor:
+    return Expr::Xor;
+  case Instruction::Shl:
+    return Expr::Shl;
+  case Instruction::LShr:
+    return Expr::LShr;
+  case Instruction::AShr:
+    return Expr::AShr;
+  default:
+    return Expr::InvalidKind;
+  }
+}
+
 KInstruction::KInstruction(
     const std::unordered_map<llvm::Instruction *, unsigned>
         &_instructionToRegisterMap,
@@ -65,6 +125,15 @@ KInstruction::KInstruction(
       operands[j] = getOperandNum(v, _instructionToRegisterMap, _km, this);
     }
   }
+
+  // Pointers are left out, as their values carry a base
+  if (inst()->getNumOperands() == 2) {
+    llvm::Type *type = inst()->getOperand(0)->getType();
+    if (type->isIntegerTy() && type->getIntegerBitWidth() <= 64) {
+      concreteKind = decodeConcreteKind(inst());
+      concreteWidth = type->getIntegerBitWidth();
+    }
+  }
 }
 
 KInstruction::~KInstruction() { delete[] operands; }
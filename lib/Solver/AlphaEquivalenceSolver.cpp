@@ -39,6 +39,9 @@ public:
   bool check(const Query &query, ref<SolverResponse> &result);
   bool computeValidityCore(const Query &query, ValidityCore &validityCore,
                            bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
   SolverRunStatus getOperationStatusCode();
   char *getConstraintLog(const Query &);
   void setCoreSolverTimeout(time::Span timeout);
@@ -147,6 +150,20 @@ bool AlphaEquivalenceSolver::computeTruth(const Query &query, bool &isValid) {
       isValid);
 }
 
+bool AlphaEquivalenceSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  AlphaBuilder builder;
+  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  std::vector<ref<Expr>> alphaConditions;
+  alphaConditions.reserve(conditions.size());
+  for (const auto &condition : conditions)
+    alphaConditions.push_back(builder.build(condition));
+  return solver->impl->computeFeasibility(
+      Query(ConstraintSet(alphaQuery, {}, {}), Expr::createFalse(), query.id),
+      alphaConditions, feasible);
+}
+
 bool AlphaEquivalenceSolver::computeValue(const Query &query,
                                           ref<Expr> &result) {
   AlphaBuilder builder;
@@ -38,6 +38,9 @@ public:
   bool check(const Query &query, ref<SolverResponse> &result);
   bool computeValidityCore(const Query &query, ValidityCore &validityCore,
                            bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
   void
   validateAssignment(const Query &query,
                      const std::vector<const Array *> &objects,
@@ -161,6 +164,12 @@ bool AssignmentValidatingSolver::computeValidityCore(const Query &query,
   return solver->impl->computeValidityCore(query, validityCore, isValid);
 }
 
+bool AssignmentValidatingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  return solver->impl->computeFeasibility(query, conditions, feasible);
+}
+
 void AssignmentValidatingSolver::dumpAssignmentQuery(
     const Query &query, const Assignment &assignment) {
   // Create a Query that is augmented with constraints that
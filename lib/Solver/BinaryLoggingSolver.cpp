@@ -0,0 +1,211 @@
+//===-- BinaryLoggingSolver.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Config/config.h"
+#include "klee/Solver/QueryLog.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+#ifdef HAVE_ZLIB_H
+#include "klee/Support/CompressionStream.h"
+#endif
+#include "klee/System/Time.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+/// BinaryLoggingSolver - Logs every query, with how the underlying solver
+/// answered it, to a binary query log.
+class BinaryLoggingSolver : public SolverImpl {
+private:
+  std::unique_ptr<Solver> solver;
+  std::unique_ptr<llvm::raw_ostream> os;
+  std::unique_ptr<QueryLogWriter> writer;
+  /// Records written since the log was last made readable up to its end
+  unsigned unsyncedRecords = 0;
+  /// Only queries which take longer than this are logged
+  time::Span minQueryTimeToLog;
+  bool logTimedOutQueries;
+
+  /// Records are made readable in batches of this many: a write, and with
+  /// compression a sync point, per query would cost both time and
+  /// compression
+  static constexpr unsigned RecordsPerSync = 256;
+
+  void log(QueryLogOperation operation, const Query &query,
+           time::Point start, bool success, bool hasAnswer, int64_t answer,
+           const std::vector<ref<Expr>> &conditions = {},
+           const std::vector<const Array *> &objects = {});
+
+public:
+  BinaryLoggingSolver(std::unique_ptr<Solver> solver, std::string path,
+                      time::Span queryTimeToLog, bool logTimedOut);
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool
+  computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+BinaryLoggingSolver::BinaryLoggingSolver(std::unique_ptr<Solver> solver,
+                                         std::string path,
+                                         time::Span queryTimeToLog,
+                                         bool logTimedOut)
+    : solver(std::move(solver)), minQueryTimeToLog(queryTimeToLog),
+      logTimedOutQueries(logTimedOut) {
+  std::string error;
+#ifdef HAVE_ZLIB_H
+  path.append(".gz");
+  os = klee_open_compressed_output_file(path, error);
+#else
+  os = klee_open_output_file(path, error);
+#endif
+  if (!os) {
+    klee_error("Could not open file %s : %s", path.c_str(), error.c_str());
+  }
+  writer = std::make_unique<QueryLogWriter>(*os);
+}
+
+void BinaryLoggingSolver::log(QueryLogOperation operation, const Query &query,
+                              time::Point start, bool success, bool hasAnswer,
+                              int64_t answer,
+                              const std::vector<ref<Expr>> &conditions,
+                              const std::vector<const Array *> &objects) {
+  QueryLogOutcome outcome;
+  outcome.elapsed = time::getWallTime() - start;
+  outcome.status = solver->impl->getOperationStatusCode();
+  outcome.success = success;
+  outcome.hasAnswer = success && hasAnswer;
+  outcome.answer = answer;
+
+  if (minQueryTimeToLog && !(outcome.elapsed > minQueryTimeToLog) &&
+      !(logTimedOutQueries && outcome.status == SOLVER_RUN_STATUS_TIMEOUT))
+    return;
+  writer->write(operation, query, conditions, objects, outcome);
+
+  if (++unsyncedRecords < RecordsPerSync)
+    return;
+  unsyncedRecords = 0;
+#ifdef HAVE_ZLIB_H
+  static_cast<compressed_fd_ostream &>(*os).sync();
+#else
+  os->flush();
+#endif
+}
+
+bool BinaryLoggingSolver::computeTruth(const Query &query, bool &isValid) {
+  time::Point start = time::getWallTime();
+  bool success = solver->impl->computeTruth(query, isValid);
+  log(QueryLogOperation::Truth, query, start, success, true,
+      success && isValid);
+  return success;
+}
+
+bool BinaryLoggingSolver::computeValidity(const Query &query,
+                                          PartialValidity &result) {
+  time::Point start = time::getWallTime();
+  bool success = solver->impl->computeValidity(query, result);
+  log(QueryLogOperation::Validity, query, start, success, true,
+      success ? static_cast<int64_t>(result) : 0);
+  return success;
+}
+
+bool BinaryLoggingSolver::computeValue(const Query &query, ref<Expr> &result) {
+  time::Point start = time::getWallTime();
+  bool success = solver->impl->computeValue(query, result);
+  // Any value allowed by the constraints is a correct answer
+  log(QueryLogOperation::Value, query, start, success, false, 0);
+  return success;
+}
+
+bool BinaryLoggingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  time::Point start = time::getWallTime();
+  bool success =
+      solver->impl->computeInitialValues(query, objects, values, hasSolution);
+  log(QueryLogOperation::InitialValues, query, start, success, true,
+      success && hasSolution, {}, objects);
+  return success;
+}
+
+bool BinaryLoggingSolver::check(const Query &query,
+                                ref<SolverResponse> &result) {
+  time::Point start = time::getWallTime();
+  bool success = solver->impl->check(query, result);
+  log(QueryLogOperation::Check, query, start, success, true,
+      success ? result->getResponseKind() : 0);
+  return success;
+}
+
+bool BinaryLoggingSolver::computeValidityCore(const Query &query,
+                                              ValidityCore &validityCore,
+                                              bool &isValid) {
+  time::Point start = time::getWallTime();
+  bool success =
+      solver->impl->computeValidityCore(query, validityCore, isValid);
+  log(QueryLogOperation::ValidityCore, query, start, success, true,
+      success && isValid);
+  return success;
+}
+
+bool BinaryLoggingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  time::Point start = time::getWallTime();
+  bool success = solver->impl->computeFeasibility(query, conditions, feasible);
+  log(QueryLogOperation::Feasibility, query, start, success, true,
+      std::count(feasible.begin(), feasible.end(), true), conditions);
+  return success;
+}
+
+SolverImpl::SolverRunStatus BinaryLoggingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *BinaryLoggingSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void BinaryLoggingSolver::setCoreSolverTimeout(time::Span timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void BinaryLoggingSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+std::unique_ptr<Solver>
+klee::createBinaryLoggingSolver(std::unique_ptr<Solver> solver,
+                                std::string path, time::Span minQueryTimeToLog,
+                                bool logTimedOut) {
+  return std::make_unique<Solver>(std::make_unique<BinaryLoggingSolver>(
+      std::move(solver), std::move(path), minQueryTimeToLog, logTimedOut));
+}
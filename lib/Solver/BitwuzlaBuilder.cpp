@@ -23,6 +23,13 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/StringExtras.h"
 
+#include <algorithm>
+
+namespace {
+/// Size of the construct cache below which it is not swept
+const size_t MinTermCacheSweep = 1 << 14;
+} // namespace
+
 namespace klee {
 
 BitwuzlaArrayExprHash::~BitwuzlaArrayExprHash() {}
@@ -35,7 +42,8 @@ void BitwuzlaArrayExprHash::clear() {
 void BitwuzlaArrayExprHash::clearUpdates() { _update_node_hash.clear(); }
 
 BitwuzlaBuilder::BitwuzlaBuilder(bool autoClearConstructCache)
-    : autoClearConstructCache(autoClearConstructCache) {}
+    : nextSweep(MinTermCacheSweep),
+      autoClearConstructCache(autoClearConstructCache) {}
 
 BitwuzlaBuilder::~BitwuzlaBuilder() {
   _arr_hash.clearUpdates();
@@ -433,22 +441,63 @@ Term BitwuzlaBuilder::construct(ref<Expr> e, int *width_out) {
   if (!BitwuzlaHashConfig::UseConstructHashBitwuzla || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Term, unsigned>>::iterator it = constructed.find(e);
+    ExprHashMap<ConstructedTerm>::iterator it = constructed.find(e);
     if (it != constructed.end()) {
+      ++stats::queryTermCacheHits;
+      it->second.lastUse = generation;
+      if (it->second.local)
+        ++localUses;
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = it->second.width;
+      return it->second.term;
     } else {
       int width;
       if (!width_out)
         width_out = &width;
+      size_t sides = sideConstraints.size();
+      uint64_t uses = localUses;
       Term res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      localUses += sideConstraints.size() - sides;
+      bool local = localUses != uses;
+      constructed.insert(std::make_pair(
+          e, ConstructedTerm{res, static_cast<unsigned>(*width_out),
+                             generation, local}));
+      if (local)
+        queryLocal.push_back(e);
       return res;
     }
   }
 }
 
+void BitwuzlaBuilder::finishQuery() {
+  clearSideConstraints();
+  ++generation;
+  if (!BitwuzlaHashConfig::BitwuzlaTermCacheIdleQueries) {
+    clearConstructCache();
+    return;
+  }
+
+  for (const auto &e : queryLocal)
+    constructed.erase(e);
+  queryLocal.clear();
+
+  // Sweeping visits every term, so it is done only when the cache has
+  // doubled since the last sweep
+  if (constructed.size() < nextSweep)
+    return;
+  for (auto it = constructed.begin(); it != constructed.end();) {
+    // Referenced only by the cache, so only a query which rebuilds the
+    // same expression would use the term again
+    if (it->first->_refCount.getCount() == 1 &&
+        generation - it->second.lastUse >
+            BitwuzlaHashConfig::BitwuzlaTermCacheIdleQueries)
+      it = constructed.erase(it);
+    else
+      ++it;
+  }
+  nextSweep = std::max<size_t>(2 * constructed.size(), MinTermCacheSweep);
+}
+
 void BitwuzlaBuilder::FPCastWidthAssert([[maybe_unused]] int *width_out,
                                         [[maybe_unused]] char const *msg) {
   assert(&(ConstantExpr::widthToFloatSemantics(*width_out)) !=
@@ -107,7 +107,25 @@ protected:
   Term getRoundingModeSort(llvm::APFloat::roundingMode rm);
   Term getx87FP80ExplicitSignificandIntegerBit(const Term &e);
 
-  ExprHashMap<std::pair<Term, unsigned>> constructed;
+  struct ConstructedTerm {
+    Term term;
+    unsigned width;
+    /// The last query which used the term
+    uint64_t lastUse;
+    /// Whether the term relies on side constraints of the current query
+    bool local;
+  };
+  ExprHashMap<ConstructedTerm> constructed;
+  /// Expressions whose terms rely on side constraints of the current query,
+  /// which are not asserted again for later queries
+  std::vector<ref<Expr>> queryLocal;
+  /// Number of side constraints plus uses of query-local terms so far, to
+  /// tell whether building a term relied on any
+  uint64_t localUses = 0;
+  /// Number of queries finished
+  uint64_t generation = 0;
+  /// Size of the construct cache at which it is next swept
+  size_t nextSweep;
   BitwuzlaArrayExprHash _arr_hash;
   bool autoClearConstructCache;
 
@@ -133,8 +151,15 @@ public:
       clearConstructCache();
     return res;
   }
-  void clearConstructCache() { constructed.clear(); }
+  void clearConstructCache() {
+    constructed.clear();
+    queryLocal.clear();
+  }
   void clearSideConstraints() { sideConstraints.clear(); }
+
+  /// Called after every query. Drops the terms not worth keeping for later
+  /// queries and the side constraints of the query.
+  void finishQuery();
 };
 } // namespace klee
 
@@ -17,4 +17,13 @@ llvm::cl::opt<bool> UseConstructHashBitwuzla(
     llvm::cl::desc(
         "Use hash-consing during Bitwuzla query construction (default=true)"),
     llvm::cl::init(true), llvm::cl::cat(klee::ExprCat));
+
+llvm::cl::opt<unsigned> BitwuzlaTermCacheIdleQueries(
+    "bitwuzla-term-cache-idle-queries",
+    llvm::cl::desc("Keep Bitwuzla terms built for a query to reuse them in "
+                   "later queries. A term is dropped once its expression is "
+                   "no longer referenced elsewhere and no query used it for "
+                   "this many queries; 0 drops all terms after every query "
+                   "(default=8)"),
+    llvm::cl::init(8), llvm::cl::cat(klee::ExprCat));
 } // namespace BitwuzlaHashConfig
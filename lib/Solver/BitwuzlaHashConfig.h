@@ -15,5 +15,6 @@
 
 namespace BitwuzlaHashConfig {
 extern llvm::cl::opt<bool> UseConstructHashBitwuzla;
+extern llvm::cl::opt<unsigned> BitwuzlaTermCacheIdleQueries;
 } // namespace BitwuzlaHashConfig
 #endif // KLEE_BITWUZLAHASHCONFIG_H
@@ -19,6 +19,7 @@
 #include "BitwuzlaSolver.h"
 
 #include "klee/ADT/Incremental.h"
+#include "klee/ADT/PrefixTrie.h"
 #include "klee/ADT/SparseStorage.h"
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/Constraints.h"
@@ -29,9 +30,13 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <csignal>
 #include <functional>
+#include <iterator>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "bitwuzla/cpp/bitwuzla.h"
 
@@ -465,6 +470,7 @@ bool BitwuzlaSolverImpl::internalRunSolver(
 
   std::unordered_set<const Array *> all_constant_arrays_in_query;
   BitwuzlaASTIncSet exprs;
+  WallTimer translationTimer;
 
   for (size_t i = 0; i < query.constraints.framesSize();
        i++, env.push(), exprs.push()) {
@@ -516,6 +522,7 @@ bool BitwuzlaSolverImpl::internalRunSolver(
                  builder->sideConstraints.end());
   }
   exprs.pop(1); // drop last empty frame
+  stats::queryTranslationTime += translationTimer.delta().toMicroseconds();
 
   ++stats::solverQueries;
   if (!env.objects.v.empty())
@@ -543,7 +550,11 @@ bool BitwuzlaSolverImpl::internalRunSolver(
     }
   }
 
-  Result satisfiable = theSolver.check_sat();
+  Result satisfiable;
+  {
+    TimerStatIncrementer solveTimer(stats::querySolveTime);
+    satisfiable = theSolver.check_sat();
+  }
   theSolver.configure_terminator(nullptr);
   runStatusCode = handleSolverResponse(theSolver, satisfiable, env, needObjects,
                                        values, hasSolution);
@@ -583,13 +594,11 @@ bool BitwuzlaSolverImpl::internalRunSolver(
 
   deinitNativeBitwuzla(theSolver);
 
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
-  // we allow Term expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
-  // ``builder->construct()``.
-  builder->clearConstructCache();
-  builder->clearSideConstraints();
+  // Drop the builder's cached terms not worth keeping, to prevent memory
+  // usage exploding. By using ``autoClearConstructCache=false`` we allow
+  // Term expressions to be shared from an entire ``Query``, and those
+  // kept here with later queries.
+  builder->finishQuery();
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
     if (hasSolution) {
@@ -771,6 +780,9 @@ public:
 
   Bitwuzla &getOrInit();
 
+  /// The constraints asserted in the underlying solver, in order
+  const ConstraintFrames::vec &constraints() const { return frames.v; }
+
   bool isConsistent() const {
     return frames.framesSize() == env.objects.framesSize();
   }
@@ -847,16 +859,24 @@ void BitwuzlaIncNativeSolver::distance(const ConstraintQuery &query,
 
 class BitwuzlaTreeSolverImpl final : public BitwuzlaSolverImpl {
 private:
-  using solvers_ty = std::vector<std::unique_ptr<BitwuzlaIncNativeSolver>>;
-  using solvers_it = solvers_ty::iterator;
+  using solvers_ty =
+      std::unordered_map<const BitwuzlaIncNativeSolver *,
+                         std::unique_ptr<BitwuzlaIncNativeSolver>>;
 
   const size_t maxSolvers;
   std::unique_ptr<BitwuzlaIncNativeSolver> currentSolver = nullptr;
+  /// Pooled solvers, owned by their address
   solvers_ty solvers;
+  /// Pooled solvers whose state has terminated
+  std::unordered_set<BitwuzlaIncNativeSolver *> recycled;
+  /// Pooled solvers indexed by their asserted constraints
+  PrefixTrie<ref<Expr>, BitwuzlaIncNativeSolver *, util::ExprHash,
+             util::ExprCmp>
+      solversIndex;
 
   void findSuitableSolver(const ConstraintQuery &query,
                           ConstraintDistance &delta);
-  void setSolver(solvers_it &it, bool recycle = false);
+  void setSolver(BitwuzlaIncNativeSolver *solver, bool recycle = false);
   ConstraintQuery prepare(const Query &q);
 
 public:
@@ -869,7 +889,11 @@ public:
   }
   void deinitNativeBitwuzla(Bitwuzla &) override {
     assert(currentSolver->isConsistent());
-    solvers.push_back(std::move(currentSolver));
+    solversIndex.insert(currentSolver->constraints().begin(),
+                        currentSolver->constraints().end(),
+                        currentSolver.get());
+    const auto *solver = currentSolver.get();
+    solvers.emplace(solver, std::move(currentSolver));
   }
   void push(Bitwuzla &s) override { s.push(1); }
 
@@ -888,9 +912,13 @@ public:
   void notifyStateTermination(std::uint32_t id) override;
 };
 
-void BitwuzlaTreeSolverImpl::setSolver(solvers_it &it, bool recycle) {
+void BitwuzlaTreeSolverImpl::setSolver(BitwuzlaIncNativeSolver *solver,
+                                       bool recycle) {
+  auto it = solvers.find(solver);
   assert(it != solvers.end());
-  currentSolver = std::move(*it);
+  solversIndex.erase(solver);
+  recycled.erase(solver);
+  currentSolver = std::move(it->second);
   solvers.erase(it);
   currentSolver->isRecycled = false;
   if (recycle)
@@ -899,40 +927,45 @@ void BitwuzlaTreeSolverImpl::setSolver(solvers_it &it, bool recycle) {
 
 void BitwuzlaTreeSolverImpl::findSuitableSolver(const ConstraintQuery &query,
                                                 ConstraintDistance &delta) {
+  // Score the solvers sharing a prefix with the query by the constraints they
+  // have to pop and push. A live state's solver gets its popped constraints
+  // pushed back once that state queries again, so they count twice; the
+  // constraints of a recycled solver are of no use to anyone. A state forked
+  // from the state which last used a solver thus gets that solver back.
+  std::vector<BitwuzlaIncNativeSolver *> candidates;
+  solversIndex.candidates(query.constraints.v.begin(),
+                          query.constraints.v.end(), candidates);
+  BitwuzlaIncNativeSolver *closest = nullptr;
   ConstraintDistance min_delta;
   auto min_distance = std::numeric_limits<size_t>::max();
-  auto min_it = solvers.end();
-  auto free_it = solvers.end();
-  for (auto it = solvers.begin(), ite = min_it; it != ite; it++) {
-    if ((*it)->isRecycled)
-      free_it = it;
-    (*it)->distance(query, delta);
-    if (delta.isOnlyPush()) {
-      setSolver(it);
-      return;
-    }
-    auto distance = delta.getDistance();
+  for (auto *solver : candidates) {
+    ConstraintDistance d;
+    solver->distance(query, d);
+    auto distance = d.getDistance() + (solver->isRecycled ? 0 : d.toPopSize);
     if (distance < min_distance) {
-      min_delta = delta;
+      closest = solver;
+      min_delta = std::move(d);
       min_distance = distance;
-      min_it = it;
     }
   }
-  if (solvers.size() < maxSolvers) {
-    delta = ConstraintDistance(query);
-    if (delta.getDistance() < min_distance) {
-      // it is cheaper to create new solver
-      if (free_it == solvers.end())
-        currentSolver =
-            std::make_unique<BitwuzlaIncNativeSolver>(solverParameters);
-      else
-        setSolver(free_it, /*recycle=*/true);
+  if (query.size() < min_distance) {
+    // it is cheaper to start from an empty solver
+    if (!recycled.empty()) {
+      delta = ConstraintDistance(query);
+      setSolver(*recycled.begin(), /*recycle=*/true);
+      return;
+    }
+    if (solvers.size() < maxSolvers) {
+      delta = ConstraintDistance(query);
+      currentSolver =
+          std::make_unique<BitwuzlaIncNativeSolver>(solverParameters);
       return;
     }
   }
-  assert(min_it != solvers.end());
+  assert(closest);
+  ++stats::queryReusedSolvers;
   delta = min_delta;
-  setSolver(min_it);
+  setSolver(closest);
 }
 
 ConstraintQuery BitwuzlaTreeSolverImpl::prepare(const Query &q) {
@@ -980,9 +1013,12 @@ bool BitwuzlaTreeSolverImpl::computeValidityCore(const Query &query,
 }
 
 void BitwuzlaTreeSolverImpl::notifyStateTermination(std::uint32_t id) {
-  for (auto &s : solvers)
-    if (s->stateID == id)
-      s->isRecycled = true;
+  for (auto &s : solvers) {
+    if (s.second->stateID == id) {
+      s.second->isRecycled = true;
+      recycled.insert(s.second.get());
+    }
+  }
 }
 
 BitwuzlaTreeSolver::BitwuzlaTreeSolver(unsigned maxSolvers)
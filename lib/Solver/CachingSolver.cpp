@@ -17,6 +17,7 @@
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 using namespace klee;
 
@@ -85,6 +86,9 @@ public:
   bool check(const Query &query, ref<SolverResponse> &result);
   bool computeValidityCore(const Query &, ValidityCore &validityCore,
                            bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
   SolverRunStatus getOperationStatusCode();
   char *getConstraintLog(const Query &);
   void setCoreSolverTimeout(time::Span timeout);
@@ -269,6 +273,56 @@ bool CachingSolver::computeTruth(const Query &query, bool &isValid) {
   return true;
 }
 
+bool CachingSolver::computeFeasibility(const Query &query,
+                                       const std::vector<ref<Expr>> &conditions,
+                                       std::vector<bool> &feasible) {
+  feasible.resize(conditions.size());
+  std::vector<ref<Expr>> missed;
+  std::vector<unsigned> positions;
+  std::vector<PartialValidity> cachedResults;
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    PartialValidity cachedResult;
+    bool cacheHit = cacheLookup(query.withExpr(conditions[i]), cachedResult);
+
+    // only a cached result of MayBeFalse leaves open whether a true
+    // assignment exists
+    if (cacheHit && cachedResult != PValidity::MayBeFalse &&
+        cachedResult != PValidity::None) {
+      ++stats::queryCacheHits;
+      feasible[i] = (cachedResult != PValidity::MustBeFalse);
+      continue;
+    }
+
+    ++stats::queryCacheMisses;
+    missed.push_back(conditions[i]);
+    positions.push_back(i);
+    cachedResults.push_back(cacheHit ? cachedResult : PValidity::None);
+  }
+  if (missed.empty())
+    return true;
+
+  // cache miss: query solver
+  std::vector<bool> missedFeasible;
+  if (!solver->impl->computeFeasibility(query, missed, missedFeasible))
+    return false;
+
+  for (unsigned i = 0; i < missed.size(); ++i) {
+    feasible[positions[i]] = missedFeasible[i];
+    PartialValidity cachedResult;
+    if (!missedFeasible[i]) {
+      cachedResult = PValidity::MustBeFalse;
+    } else if (cachedResults[i] == PValidity::MayBeFalse) {
+      // We know a false assignment exists, and a true one as well, so
+      // must be TrueOrFalse.
+      cachedResult = PValidity::TrueOrFalse;
+    } else {
+      cachedResult = PValidity::MayBeTrue;
+    }
+    cacheInsert(query.withExpr(missed[i]), cachedResult);
+  }
+  return true;
+}
+
 bool CachingSolver::computeValidityCore(const Query &query,
                                         ValidityCore &validityCore,
                                         bool &isValid) {
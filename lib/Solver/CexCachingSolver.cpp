@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 using namespace klee;
 using namespace llvm;
@@ -77,6 +78,11 @@ class CexCachingSolver : public SolverImpl {
   MapOfSets<ref<Expr>, ref<SolverResponse>> cache;
   // memo table
   responseTable_ty responseTable;
+  // keys of the queries known to be valid only from a batched feasibility
+  // check, which produces neither an assignment nor a validity core
+  MapOfSets<ref<Expr>, bool> validKeys;
+
+  bool lookupValidKey(const KeyType &key);
 
   bool searchForResponse(KeyType &key, ref<SolverResponse> &result);
 
@@ -106,6 +112,9 @@ public:
   bool check(const Query &query, ref<SolverResponse> &result);
   bool computeValidityCore(const Query &, ValidityCore &validityCore,
                            bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
   SolverRunStatus getOperationStatusCode();
   char *getConstraintLog(const Query &query);
   void setCoreSolverTimeout(time::Span timeout);
@@ -124,6 +133,10 @@ struct isInvalidResponse {
   }
 };
 
+struct isKnownValid {
+  bool operator()(bool a) const { return a; }
+};
+
 struct isValidOrSatisfyingResponse {
   KeyType key;
   isValidOrSatisfyingResponse(KeyType &_key) : key(_key) {}
@@ -245,6 +258,16 @@ bool CexCachingSolver::lookupResponse(const Query &query, KeyType &key,
   return found;
 }
 
+/// lookupValidKey - Check whether the query with the given key, or a query
+/// over a subset of its constraints, was found valid by a batched feasibility
+/// check.
+bool CexCachingSolver::lookupValidKey(const KeyType &key) {
+  if (!validKeys.findSubset(key, isKnownValid()))
+    return false;
+  ++stats::queryCexCacheHits;
+  return true;
+}
+
 bool CexCachingSolver::getResponse(const Query &query,
                                    ref<SolverResponse> &result) {
   if (lookupResponse(query, result)) {
@@ -296,7 +319,10 @@ void CexCachingSolver::setResponse(const Query &query,
 
 ///
 
-CexCachingSolver::~CexCachingSolver() { cache.clear(); }
+CexCachingSolver::~CexCachingSolver() {
+  cache.clear();
+  validKeys.clear();
+}
 
 bool CexCachingSolver::computeValidity(const Query &query,
                                        PartialValidity &result) {
@@ -346,6 +372,11 @@ bool CexCachingSolver::computeTruth(const Query &query, bool &isValid) {
       return false;
   }
 
+  if (lookupValidKey(makeKey(query))) {
+    isValid = true;
+    return true;
+  }
+
   ref<SolverResponse> a;
   if (!getResponse(query, a))
     return false;
@@ -355,6 +386,46 @@ bool CexCachingSolver::computeTruth(const Query &query, bool &isValid) {
   return true;
 }
 
+bool CexCachingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  TimerStatIncrementer t(stats::cexCacheTime);
+
+  feasible.resize(conditions.size());
+  std::vector<ref<Expr>> missed;
+  std::vector<unsigned> positions;
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    Query negated = query.withExpr(Expr::createIsZero(conditions[i]));
+    if (lookupValidKey(makeKey(negated))) {
+      feasible[i] = false;
+      continue;
+    }
+    ref<SolverResponse> a;
+    if (lookupResponse(negated, a)) {
+      feasible[i] = isa<InvalidResponse>(a);
+      continue;
+    }
+    missed.push_back(conditions[i]);
+    positions.push_back(i);
+  }
+  if (missed.empty())
+    return true;
+
+  // The missed conditions are checked together, which produces neither
+  // assignments nor validity cores, so only their infeasibility is memorized,
+  // apart from the cache of responses
+  std::vector<bool> missedFeasible;
+  if (!solver->impl->computeFeasibility(query, missed, missedFeasible))
+    return false;
+  for (unsigned i = 0; i < missed.size(); ++i) {
+    feasible[positions[i]] = missedFeasible[i];
+    if (!missedFeasible[i])
+      validKeys.insert(makeKey(query.withExpr(Expr::createIsZero(missed[i]))),
+                       true);
+  }
+  return true;
+}
+
 bool CexCachingSolver::computeValue(const Query &query, ref<Expr> &result) {
   TimerStatIncrementer t(stats::cexCacheTime);
 
@@ -50,6 +50,9 @@ public:
   bool computeValidityCore(const Query &query, ValidityCore &validityCore,
                            bool &isValid);
   bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
 
   bool computeValue(const Query &, ref<Expr> &result);
   bool computeInitialValues(
@@ -505,6 +508,16 @@ bool ConcretizingSolver::computeValidityCore(const Query &query,
   return true;
 }
 
+bool ConcretizingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  if (!query.containsSymcretes()) {
+    return solver->impl->computeFeasibility(query, conditions, feasible);
+  }
+  // Every condition may need a concretization of its own
+  return SolverImpl::computeFeasibility(query, conditions, feasible);
+}
+
 bool ConcretizingSolver::computeValue(const Query &query, ref<Expr> &result) {
   if (!query.containsSymcretes()) {
     return solver->impl->computeValue(query, result);
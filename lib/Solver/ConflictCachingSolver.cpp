@@ -0,0 +1,251 @@
+//===-- ConflictCachingSolver.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/MapOfSets.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Solver/SolverUtil.h"
+
+#include <list>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+typedef std::set<ref<Expr>> KeyType;
+
+/// ConflictCachingSolver - Remembers the validity cores of valid queries as
+/// conflicts: sets of expressions which cannot hold together. A query whose
+/// constraints and negated expression contain a known conflict is valid, and
+/// is answered without asking the underlying solver. As cores are usually
+/// much smaller than the queries they came from, a single conflict answers
+/// every later query along any path which still carries its constraints.
+/// Conflicts are only learned from the cores the underlying solver produces;
+/// a query merely known to be valid would give a conflict as large as the
+/// query itself. At most ConflictCacheSize conflicts are kept.
+class ConflictCachingSolver : public SolverImpl {
+private:
+  typedef std::list<KeyType> recent_ty;
+
+  std::unique_ptr<Solver> solver;
+  /// Every known conflict, mapped to its position in `recent`
+  MapOfSets<ref<Expr>, recent_ty::iterator> conflicts;
+  /// The known conflicts, the most recently used first
+  recent_ty recent;
+
+  /// Look for a known conflict among the constraints and the negated
+  /// expression of `query`. On success, `core` is a validity core of the
+  /// query made of the conflict.
+  bool lookup(const Query &query, ValidityCore &core);
+  /// Remember the validity core of the valid query `query`
+  void learn(const Query &query, const ValidityCore &core);
+
+public:
+  ConflictCachingSolver(std::unique_ptr<Solver> solver)
+      : solver(std::move(solver)) {}
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool computeInitialValues(
+      const Query &query, const std::vector<const Array *> &objects,
+      std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+bool ConflictCachingSolver::lookup(const Query &query, ValidityCore &core) {
+  ref<Expr> negation = Expr::createIsZero(query.expr);
+  KeyType key(query.constraints.cs().begin(), query.constraints.cs().end());
+  key.insert(negation);
+
+  recent_ty::iterator *conflict = conflicts.findSubset(
+      key, [](const recent_ty::iterator &) { return true; });
+  if (!conflict) {
+    ++stats::queryConflictCacheMisses;
+    return false;
+  }
+
+  ++stats::queryConflictCacheHits;
+  recent.splice(recent.begin(), recent, *conflict);
+  ValidityCore::constraints_typ constraints;
+  for (const auto &e : **conflict) {
+    if (e != negation)
+      constraints.insert(e);
+  }
+  core = ValidityCore(constraints, query.expr);
+  return true;
+}
+
+void ConflictCachingSolver::learn(const Query &query,
+                                  const ValidityCore &core) {
+  // Symcretes constrain the query beyond its constraints
+  if (!query.constraints.symcretes().empty() || ConflictCacheSize == 0)
+    return;
+
+  KeyType conflict;
+  for (const auto &e : core.constraints) {
+    if (!e->isTrue())
+      conflict.insert(e);
+  }
+  ref<Expr> negation = Expr::createIsZero(core.expr);
+  if (!negation->isTrue())
+    conflict.insert(negation);
+
+  // A constant false conflict never occurs in the queries reaching here
+  if (conflict.empty() || conflict.count(Expr::createFalse()) ||
+      conflicts.lookup(conflict))
+    return;
+  recent.push_front(conflict);
+  conflicts.insert(conflict, recent.begin());
+
+  if (recent.size() > ConflictCacheSize) {
+    conflicts.erase(recent.back());
+    recent.pop_back();
+  }
+}
+
+bool ConflictCachingSolver::computeTruth(const Query &query, bool &isValid) {
+  ValidityCore core;
+  if (lookup(query, core)) {
+    isValid = true;
+    return true;
+  }
+
+  return solver->impl->computeTruth(query, isValid);
+}
+
+bool ConflictCachingSolver::computeValidity(const Query &query,
+                                            PartialValidity &result) {
+  ValidityCore core;
+  if (lookup(query, core)) {
+    result = PValidity::MustBeTrue;
+    return true;
+  }
+  Query negated = query.negateExpr();
+  if (lookup(negated, core)) {
+    result = PValidity::MustBeFalse;
+    return true;
+  }
+
+  return solver->impl->computeValidity(query, result);
+}
+
+bool ConflictCachingSolver::computeValue(const Query &query,
+                                         ref<Expr> &result) {
+  return solver->impl->computeValue(query, result);
+}
+
+bool ConflictCachingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  ValidityCore core;
+  if (lookup(query, core)) {
+    hasSolution = false;
+    return true;
+  }
+
+  return solver->impl->computeInitialValues(query, objects, values,
+                                            hasSolution);
+}
+
+bool ConflictCachingSolver::check(const Query &query,
+                                  ref<SolverResponse> &result) {
+  ValidityCore core;
+  if (lookup(query, core)) {
+    result = new ValidResponse(core);
+    return true;
+  }
+
+  if (!solver->impl->check(query, result))
+    return false;
+  if (result->tryGetValidityCore(core))
+    learn(query, core);
+  return true;
+}
+
+bool ConflictCachingSolver::computeValidityCore(const Query &query,
+                                                ValidityCore &validityCore,
+                                                bool &isValid) {
+  if (lookup(query, validityCore)) {
+    isValid = true;
+    return true;
+  }
+
+  if (!solver->impl->computeValidityCore(query, validityCore, isValid))
+    return false;
+  if (isValid)
+    learn(query, validityCore);
+  return true;
+}
+
+bool ConflictCachingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  // A condition is infeasible if its negation is valid
+  feasible.assign(conditions.size(), false);
+  std::vector<ref<Expr>> unknown;
+  std::vector<unsigned> unknownIndices;
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    ValidityCore core;
+    if (!lookup(query.withExpr(Expr::createIsZero(conditions[i])), core)) {
+      unknown.push_back(conditions[i]);
+      unknownIndices.push_back(i);
+    }
+  }
+  if (unknown.empty())
+    return true;
+
+  std::vector<bool> unknownFeasible;
+  if (!solver->impl->computeFeasibility(query, unknown, unknownFeasible))
+    return false;
+  for (unsigned i = 0; i < unknown.size(); ++i)
+    feasible[unknownIndices[i]] = unknownFeasible[i];
+  return true;
+}
+
+SolverImpl::SolverRunStatus ConflictCachingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *ConflictCachingSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void ConflictCachingSolver::setCoreSolverTimeout(time::Span timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void ConflictCachingSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+} // namespace
+
+std::unique_ptr<Solver>
+klee::createConflictCachingSolver(std::unique_ptr<Solver> s) {
+  return std::make_unique<Solver>(
+      std::make_unique<ConflictCachingSolver>(std::move(s)));
+}
@@ -20,17 +20,61 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace klee {
 
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
-    std::string baseSolverQueryKQueryLogPath) {
+    std::string baseSolverQueryKQueryLogPath, std::string queryBinaryLogPath,
+    std::string baseSolverQueryBinaryLogPath, std::string solverTracePath) {
   Solver *rawCoreSolver = coreSolver.get();
   std::unique_ptr<Solver> solver = std::move(coreSolver);
   const time::Span minQueryTimeToLog(MinQueryTimeToLog);
 
+  std::shared_ptr<SolverTracer> tracer;
+  if (TraceSolverChain) {
+    tracer = createSolverTracer(solverTracePath, SolverTraceEvents,
+                                SolverTraceSampleRate);
+    klee_message("Tracing the solver chain to %s\n", solverTracePath.c_str());
+  }
+  // Record the calls of the layer just added to the chain
+  auto trace = [&](const char *layer) {
+    if (tracer)
+      solver = createTracingSolver(std::move(solver), tracer, layer);
+  };
+  trace("Core");
+
+  if (!SolverPortfolio.empty()) {
+    std::vector<std::unique_ptr<Solver>> solvers;
+    solvers.push_back(std::move(solver));
+    for (CoreSolverType type : SolverPortfolio) {
+      if (type == CoreSolverToUse)
+        continue;
+      // Told apart from the default core solver by their instance
+      if (std::unique_ptr<Solver> member = createCoreSolver(type))
+        solvers.push_back(tracer ? createTracingSolver(std::move(member),
+                                                       tracer, "Core")
+                                 : std::move(member));
+    }
+    if (solvers.size() > 1)
+      klee_message("Racing %zu core solvers on every query", solvers.size());
+    solver = createPortfolioSolver(std::move(solvers));
+    trace("Portfolio");
+  }
+
+  if (PruneReadOverWrite) {
+    solver = createReadOverWriteSolver(std::move(solver));
+    trace("ReadOverWrite");
+  }
+
+  if (PredictSolverTimeout || !SolverTimingLog.empty()) {
+    solver = createTimeoutPredictingSolver(
+        std::move(solver), PredictSolverTimeout, SolverTimingLog);
+    trace("TimeoutPredicting");
+  }
+
   if (QueryLoggingOptions.isSet(SOLVER_KQUERY)) {
     solver = createKQueryLoggingSolver(std::move(solver),
                                        baseSolverQueryKQueryLogPath,
@@ -47,38 +91,79 @@ std::unique_ptr<Solver> constructSolverChain(
                  baseSolverQuerySMT2LogPath.c_str());
   }
 
-  if (UseAssignmentValidatingSolver)
+  if (QueryLoggingOptions.isSet(SOLVER_BINARY)) {
+    solver = createBinaryLoggingSolver(std::move(solver),
+                                       baseSolverQueryBinaryLogPath,
+                                       minQueryTimeToLog, LogTimedOutQueries);
+    klee_message("Logging queries that reach solver in binary format to %s\n",
+                 baseSolverQueryBinaryLogPath.c_str());
+  }
+
+  if (!QueryCacheFile.empty()) {
+    solver = createPersistentCachingSolver(std::move(solver), QueryCacheFile);
+    trace("PersistentCache");
+    klee_message("Using persistent query cache %s\n", QueryCacheFile.c_str());
+  }
+
+  if (UseConflictCache) {
+    solver = createConflictCachingSolver(std::move(solver));
+    trace("ConflictCache");
+  }
+
+  if (UseAssignmentValidatingSolver) {
     solver = createAssignmentValidatingSolver(std::move(solver));
+    trace("AssignmentValidating");
+  }
 
-  if (UseFastCexSolver)
+  if (UseFastCexSolver) {
     solver = createFastCexSolver(std::move(solver));
+    trace("FastCex");
+  }
 
-  if (UseCexCache)
+  if (UseCexCache) {
     solver = createCexCachingSolver(std::move(solver));
+    trace("CexCache");
+  }
 
-  if (UseBranchCache)
+  if (UseBranchCache) {
     solver = createCachingSolver(std::move(solver));
+    trace("BranchCache");
+  }
 
-  if (UseAlphaEquivalence)
+  if (UseAlphaEquivalence) {
     solver = createAlphaEquivalenceSolver(std::move(solver));
+    trace("AlphaEquivalence");
+  }
 
-  if (UseIndependentSolver)
+  if (UseIndependentSolver) {
     solver = createIndependentSolver(std::move(solver));
+    trace("Independent");
+  }
 
-  if (UseConcretizingSolver)
+  if (UseConcretizingSolver) {
     solver = createConcretizingSolver(std::move(solver));
+    trace("Concretizing");
+  }
 
-  if (UseCexCache && UseConcretizingSolver)
+  if (UseCexCache && UseConcretizingSolver) {
     solver = createCexCachingSolver(std::move(solver));
+    trace("CexCache");
+  }
 
-  if (UseBranchCache && UseConcretizingSolver)
+  if (UseBranchCache && UseConcretizingSolver) {
     solver = createCachingSolver(std::move(solver));
+    trace("BranchCache");
+  }
 
-  if (UseIndependentSolver && UseConcretizingSolver)
+  if (UseIndependentSolver && UseConcretizingSolver) {
     solver = createIndependentSolver(std::move(solver));
+    trace("Independent");
+  }
 
-  if (DebugValidateSolver)
+  if (DebugValidateSolver) {
     solver = createValidatingSolver(std::move(solver), rawCoreSolver, false);
+    trace("Validating");
+  }
 
   if (QueryLoggingOptions.isSet(ALL_KQUERY)) {
     solver = createKQueryLoggingSolver(std::move(solver), queryKQueryLogPath,
@@ -93,6 +178,13 @@ std::unique_ptr<Solver> constructSolverChain(
     klee_message("Logging all queries in .smt2 format to %s\n",
                  querySMT2LogPath.c_str());
   }
+
+  if (QueryLoggingOptions.isSet(ALL_BINARY)) {
+    solver = createBinaryLoggingSolver(std::move(solver), queryBinaryLogPath,
+                                       minQueryTimeToLog, LogTimedOutQueries);
+    klee_message("Logging all queries in binary format to %s\n",
+                 queryBinaryLogPath.c_str());
+  }
   if (DebugCrossCheckCoreSolverWith != NO_SOLVER) {
     std::unique_ptr<Solver> oracleSolver =
         createCoreSolver(DebugCrossCheckCoreSolverWith);
@@ -19,9 +19,13 @@
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/IndependentConstraintSetUnion.h"
 #include "klee/Expr/IndependentSet.h"
+#include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
 
+#include <list>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -30,8 +34,54 @@ using namespace llvm;
 
 class IndependentSolver : public SolverImpl {
 private:
+  struct FactorEntry {
+    constraints_ty constraints;
+    bool operator==(const FactorEntry &b) const {
+      return constraints == b.constraints;
+    }
+  };
+
+  struct FactorEntryHash {
+    unsigned operator()(const FactorEntry &fe) const {
+      unsigned result = 0;
+      for (auto const &constraint : fe.constraints) {
+        result ^= constraint->hash();
+      }
+      return result;
+    }
+  };
+
+  struct FactorModel {
+    std::vector<const Array *> objects;
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    /// The model's position in recentFactors
+    std::list<const FactorEntry *>::iterator recent;
+  };
+
   std::unique_ptr<Solver> solver;
 
+  /// Satisfying assignments of independent factors. An independent factor is
+  /// solved on its own, so its assignment does not depend on the query it
+  /// was part of and is reused by every later query, of any state, which
+  /// contains the same factor. At most --independent-factor-cache-size
+  /// models are kept, the least recently used ones are dropped first.
+  std::unordered_map<FactorEntry, FactorModel, FactorEntryHash> factorModels;
+  /// The factors of factorModels, most recently used first
+  std::list<const FactorEntry *> recentFactors;
+
+  static bool isCacheable(const IndependentConstraintSet &factor) {
+    return factor.symcretes.empty() && factor.concretization.bindings.empty();
+  }
+
+  bool factorLookup(const IndependentConstraintSet &factor,
+                    const std::vector<const Array *> &objects,
+                    std::vector<SparseStorageImpl<unsigned char>> &values);
+
+  void
+  factorInsert(const IndependentConstraintSet &factor,
+               const std::vector<const Array *> &objects,
+               const std::vector<SparseStorageImpl<unsigned char>> &values);
+
 public:
   IndependentSolver(std::unique_ptr<Solver> solver)
       : solver(std::move(solver)) {}
@@ -45,12 +95,58 @@ public:
   bool check(const Query &query, ref<SolverResponse> &result);
   bool computeValidityCore(const Query &query, ValidityCore &validityCore,
                            bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
   SolverRunStatus getOperationStatusCode();
   char *getConstraintLog(const Query &);
   void setCoreSolverTimeout(time::Span timeout);
   void notifyStateTermination(std::uint32_t id);
 };
 
+bool IndependentSolver::factorLookup(
+    const IndependentConstraintSet &factor,
+    const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values) {
+  if (!isCacheable(factor)) {
+    return false;
+  }
+  auto it = factorModels.find(FactorEntry{factor.getConstraints()});
+  if (it == factorModels.end() || it->second.objects != objects) {
+    ++stats::queryFactorCacheMisses;
+    return false;
+  }
+  ++stats::queryFactorCacheHits;
+  FactorModel &model = it->second;
+  recentFactors.splice(recentFactors.begin(), recentFactors, model.recent);
+  values = model.values;
+  return true;
+}
+
+void IndependentSolver::factorInsert(
+    const IndependentConstraintSet &factor,
+    const std::vector<const Array *> &objects,
+    const std::vector<SparseStorageImpl<unsigned char>> &values) {
+  if (!isCacheable(factor) || IndependentFactorCacheSize == 0) {
+    return;
+  }
+  auto inserted = factorModels.try_emplace(
+      FactorEntry{factor.getConstraints()}, FactorModel{objects, values});
+  FactorModel &model = inserted.first->second;
+  if (!inserted.second) {
+    model.objects = objects;
+    model.values = values;
+    recentFactors.splice(recentFactors.begin(), recentFactors, model.recent);
+    return;
+  }
+  recentFactors.push_front(&inserted.first->first);
+  model.recent = recentFactors.begin();
+  while (factorModels.size() > IndependentFactorCacheSize) {
+    factorModels.erase(*recentFactors.back());
+    recentFactors.pop_back();
+  }
+}
+
 bool IndependentSolver::computeValidity(const Query &query,
                                         PartialValidity &result) {
   std::vector<ref<const IndependentConstraintSet>> factors;
@@ -190,13 +286,16 @@ bool IndependentSolver::computeInitialValues(
       [[maybe_unused]] bool success =
           tempResult->tryGetInitialValuesFor(arraysInFactor, tempValues);
       assert(success && "Can not get initial values (Independent solver)!");
-    } else {
+    } else if (!factorLookup(*it, arraysInFactor, tempValues)) {
       if (!solver->impl->computeInitialValues(
               Query(tmp, Expr::createFalse(), query.id), arraysInFactor,
               tempValues, hasSolution)) {
         values.clear();
         return false;
       }
+      if (hasSolution) {
+        factorInsert(*it, arraysInFactor, tempValues);
+      }
     }
 
     if (!hasSolution) {
@@ -292,6 +391,9 @@ bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
       continue;
     } else if (it->exprs.size() == 0) {
       tempResult = new InvalidResponse();
+    } else if (factorLookup(*it, arraysInFactor, tempValues)) {
+      it->addValuesToAssignment(arraysInFactor, tempValues, retMap);
+      continue;
     } else {
       if (!solver->impl->check(
               Query(ConstraintSet(it), Expr::createFalse(), query.id),
@@ -307,6 +409,9 @@ bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
       [[maybe_unused]] bool success =
           tempResult->tryGetInitialValuesFor(arraysInFactor, tempValues);
       assert(success && "Can not get initial values (Independent solver)!");
+      if (!it->exprs.empty()) {
+        factorInsert(*it, arraysInFactor, tempValues);
+      }
       assert(tempValues.size() == arraysInFactor.size() &&
              "Should be equal number arrays and answers");
       // We already have an array with some partially correct answers,
@@ -336,6 +441,23 @@ bool IndependentSolver::computeValidityCore(const Query &query,
                                            validityCore, isValid);
 }
 
+bool IndependentSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  // Sibling conditions usually constrain the same values, so the factors
+  // any of them depends on are those each of them depends on
+  ref<Expr> anyCondition = Expr::createFalse();
+  for (const auto &condition : conditions)
+    anyCondition = OrExpr::create(anyCondition, condition);
+
+  std::vector<ref<const IndependentConstraintSet>> factors;
+  query.withExpr(anyCondition).getAllDependentConstraintsSets(factors);
+  ConstraintSet tmp(factors,
+                    query.constraints.independentElements().concretizedExprs);
+  return solver->impl->computeFeasibility(query.withConstraints(tmp),
+                                          conditions, feasible);
+}
+
 SolverImpl::SolverRunStatus IndependentSolver::getOperationStatusCode() {
   return solver->impl->getOperationStatusCode();
 }
@@ -0,0 +1,746 @@
+//===-- PersistentCachingSolver.cpp ---------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverPayload.h"
+
+#include "klee/Config/CompileTimeInfo.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/ExprUtil.h"
+#include "klee/Expr/SymbolicSource.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+/// A 128-bit structural digest of a query.
+struct CacheKey {
+  uint64_t first = 14695981039346656037ULL;
+  uint64_t second = 0;
+
+  bool operator==(const CacheKey &b) const {
+    return first == b.first && second == b.second;
+  }
+
+  /// Mix a value into both lanes: FNV-1a and an independent polynomial hash.
+  void add(uint64_t v) {
+    v += 0x9E3779B97F4A7C15ULL;
+    v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    v = (v ^ (v >> 27)) * 0x94D049BB133111EBULL;
+    v ^= v >> 31;
+    first = (first ^ v) * 1099511628211ULL;
+    second = second * 0x9E3779B97F4A7C15ULL + v + 1;
+  }
+  void add(const CacheKey &key) {
+    add(key.first);
+    add(key.second);
+  }
+};
+
+/// Kinds of cached answers, part of the key.
+enum CacheEntryKind : char {
+  TRUTH_ENTRY = 'T',
+  VALIDITY_ENTRY = 'V',
+  INITIAL_VALUES_ENTRY = 'I'
+};
+
+const char CacheMagic[8] = {'K', 'L', 'E', 'E', 'Q', 'C', 'C', 'H'};
+const char IndexMagic[8] = {'K', 'L', 'E', 'E', 'Q', 'C', 'I', 'X'};
+const uint32_t CacheVersion = 3;
+
+/// Header of the cache file. Answers are only shared between runs of the
+/// same build with the same core solvers, which `configHash` identifies.
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint64_t configHash;
+} __attribute__((packed));
+
+/// Header of a record in the cache file, followed by `size` payload bytes.
+struct RecordHeader {
+  uint64_t first;
+  uint64_t second;
+  uint32_t size;
+  uint32_t checksum;
+} __attribute__((packed));
+
+/// Answers are a few bytes, or an assignment of the query's arrays. Larger
+/// sizes only come from corrupt records.
+const uint32_t MaxRecordSize = 1U << 26;
+
+/// Header of the index file, followed by `capacity` slots.
+struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t configHash;
+  /// Number of slots, a power of two.
+  uint64_t capacity;
+  /// Number of occupied slots.
+  uint64_t count;
+  /// Bytes of the cache file whose records are indexed.
+  uint64_t dataSize;
+};
+
+/// A slot of the open-addressed index. The offset of the payload is written
+/// last, and a slot is only read once its offset is seen to be non-zero.
+struct IndexSlot {
+  uint64_t first;
+  uint64_t second;
+  uint64_t offset;
+  uint32_t size;
+  uint32_t checksum;
+};
+
+static_assert(sizeof(IndexHeader) == 48 && sizeof(IndexSlot) == 32,
+              "index layout must not depend on the compiler");
+
+const uint64_t InitialIndexCapacity = 1U << 12;
+const uint64_t MaxIndexCapacity = 1U << 24;
+
+size_t indexFileSize(uint64_t capacity) {
+  return sizeof(IndexHeader) + capacity * sizeof(IndexSlot);
+}
+
+/// Find the slot holding `key`, or the empty slot where it belongs. Returns
+/// null only for a full (corrupt) index.
+IndexSlot *probeSlot(IndexSlot *slots, uint64_t capacity,
+                     const CacheKey &key) {
+  uint64_t i = key.first & (capacity - 1);
+  for (uint64_t probes = 0; probes < capacity; ++probes) {
+    IndexSlot *slot = &slots[i];
+    if (!__atomic_load_n(&slot->offset, __ATOMIC_ACQUIRE) ||
+        (slot->first == key.first && slot->second == key.second))
+      return slot;
+    i = (i + 1) & (capacity - 1);
+  }
+  return nullptr;
+}
+
+/// Computes the digests of the expressions and arrays of a query, visiting
+/// every node of their DAG once.
+class QueryHasher {
+  std::unordered_map<const Expr *, CacheKey> exprs;
+  std::unordered_map<const UpdateNode *, CacheKey> updates;
+  std::unordered_map<const Array *, CacheKey> arrays;
+
+public:
+  CacheKey hash(const ref<Expr> &e);
+  CacheKey hash(const UpdateList &ul);
+  CacheKey hash(const Array *array);
+};
+
+CacheKey QueryHasher::hash(const ref<Expr> &e) {
+  auto it = exprs.find(e.get());
+  if (it != exprs.end())
+    return it->second;
+
+  CacheKey key;
+  key.add(e->getKind());
+  key.add(e->getWidth());
+  switch (e->getKind()) {
+  case Expr::Constant: {
+    const llvm::APInt &value = cast<ConstantExpr>(e)->getAPValue();
+    for (unsigned i = 0; i < value.getNumWords(); ++i)
+      key.add(value.getRawData()[i]);
+    break;
+  }
+  case Expr::Read:
+    key.add(hash(cast<ReadExpr>(e)->updates));
+    break;
+  case Expr::Extract:
+    key.add(cast<ExtractExpr>(e)->offset);
+    break;
+#define ROUNDING_MODE_CASE(_class_kind)                                        \
+  case Expr::_class_kind:                                                      \
+    key.add(static_cast<uint64_t>(                                             \
+        cast<_class_kind##Expr>(e)->roundingMode));                            \
+    break;
+    ROUNDING_MODE_CASE(FAdd)
+    ROUNDING_MODE_CASE(FSub)
+    ROUNDING_MODE_CASE(FMul)
+    ROUNDING_MODE_CASE(FDiv)
+    ROUNDING_MODE_CASE(FRem)
+    ROUNDING_MODE_CASE(FMax)
+    ROUNDING_MODE_CASE(FMin)
+    ROUNDING_MODE_CASE(FPTrunc)
+    ROUNDING_MODE_CASE(FPToUI)
+    ROUNDING_MODE_CASE(FPToSI)
+    ROUNDING_MODE_CASE(UIToFP)
+    ROUNDING_MODE_CASE(SIToFP)
+    ROUNDING_MODE_CASE(FSqrt)
+    ROUNDING_MODE_CASE(FRint)
+#undef ROUNDING_MODE_CASE
+  default:
+    break;
+  }
+  for (unsigned i = 0; i < e->getNumKids(); ++i)
+    key.add(hash(e->getKid(i)));
+  return exprs[e.get()] = key;
+}
+
+CacheKey QueryHasher::hash(const UpdateList &ul) {
+  // Digests of the updates include those of the older ones
+  CacheKey key;
+  key.add(hash(ul.root));
+  if (!ul.head)
+    return key;
+
+  std::vector<const UpdateNode *> pending;
+  for (const UpdateNode *un = ul.head.get(); un && !updates.count(un);
+       un = un->next.get())
+    pending.push_back(un);
+  for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+    CacheKey update;
+    if ((*it)->next)
+      update = updates[(*it)->next.get()];
+    update.add(hash((*it)->index));
+    update.add(hash((*it)->value));
+    updates[*it] = update;
+  }
+  key.add(updates[ul.head.get()]);
+  return key;
+}
+
+CacheKey QueryHasher::hash(const Array *array) {
+  auto it = arrays.find(array);
+  if (it != arrays.end())
+    return it->second;
+
+  CacheKey key;
+  key.add(array->domain);
+  key.add(array->range);
+  key.add(hash(array->size));
+  key.add(array->source->getKind());
+  // Arrays are renamed by the AlphaEquivalenceSolver above this one, other
+  // sources are told apart by their full description
+  if (const AlphaSource *alpha = dyn_cast<AlphaSource>(array->source)) {
+    key.add(alpha->index);
+  } else {
+    for (unsigned char c : array->source->toString())
+      key.add(c);
+  }
+  return arrays[array] = key;
+}
+
+uint32_t computeChecksum(const std::string &data) {
+  uint32_t hash = 2166136261U;
+  for (unsigned char c : data)
+    hash = (hash ^ c) * 16777619U;
+  return hash;
+}
+
+uint64_t computeConfigHash() {
+  std::string config = KLEE_BUILD_REVISION;
+  config += ':';
+  config += std::to_string(static_cast<int>(CoreSolverToUse));
+  for (CoreSolverType type : SolverPortfolio) {
+    config += ',';
+    config += std::to_string(static_cast<int>(type));
+  }
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : config)
+    hash = (hash ^ c) * 1099511628211ULL;
+  return hash;
+}
+} // namespace
+
+/// PersistentCachingSolver - Caches answers of the underlying solver in a
+/// file, so that later (and concurrently running) KLEE processes do not have
+/// to solve the same queries again.
+///
+/// Queries are keyed by a structural hash of their expression DAG. Placed
+/// below the AlphaEquivalenceSolver, arrays are numbered canonically, so
+/// equal queries from different runs map to the same key. The cache file is
+/// a versioned header followed by an append-only sequence of checksummed
+/// records. Next to it, `<path>.index` is an open-addressed hash table from
+/// keys to records, mapped into every process sharing the cache: lookups
+/// read it without locking, while writers append a record and publish its
+/// slot under an exclusive flock() of the cache file. A full index is
+/// replaced by a larger copy, which readers map once they miss.
+class PersistentCachingSolver : public SolverImpl {
+private:
+  std::unique_ptr<Solver> solver;
+  int fd;
+  uint64_t configHash;
+  std::string indexPath;
+  void *index = nullptr;
+  size_t indexLength = 0;
+  ino_t indexInode = 0;
+
+  IndexHeader *indexHeader() const { return static_cast<IndexHeader *>(index); }
+  IndexSlot *indexSlots() const {
+    return reinterpret_cast<IndexSlot *>(indexHeader() + 1);
+  }
+
+  CacheKey computeKey(CacheEntryKind kind, const Query &query,
+                      const std::vector<const Array *> *objects = nullptr);
+
+  /// Map the index file found at `indexPath`, keeping the current mapping if
+  /// it is not a valid index.
+  bool mapIndex();
+  void unmapIndex();
+  bool indexReplaced() const;
+
+  /// Replace the index file by one of `capacity` slots, holding the entries
+  /// of the current index if `keep` is set. Requires the exclusive lock.
+  bool rebuildIndex(uint64_t capacity, bool keep);
+
+  /// Index the records appended to the cache file by other processes, and
+  /// drop a record torn by a failed writer at its end. Requires the
+  /// exclusive lock.
+  bool syncIndex();
+
+  bool addSlot(const CacheKey &key, uint64_t offset, uint32_t size,
+               uint32_t checksum);
+  bool findSlot(const CacheKey &key, IndexSlot &slot) const;
+
+  bool lookup(const CacheKey &key, SolverPayload &payload);
+  void insert(const CacheKey &key, const SolverPayload &payload);
+
+public:
+  PersistentCachingSolver(std::unique_ptr<Solver> solver, int fd,
+                          uint64_t configHash, const std::string &path)
+      : solver(std::move(solver)), fd(fd), configHash(configHash),
+        indexPath(path + ".index") {
+    flock(fd, LOCK_EX);
+    if (!syncIndex())
+      klee_warning("cannot create the persistent query cache index %s - %s",
+                   indexPath.c_str(), llvm::sys::StrError(errno).c_str());
+    flock(fd, LOCK_UN);
+  }
+  ~PersistentCachingSolver() {
+    unmapIndex();
+    close(fd);
+  }
+
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool
+  computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeMinimalUnsignedValue(const Query &query,
+                                   ref<ConstantExpr> &result);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+CacheKey
+PersistentCachingSolver::computeKey(CacheEntryKind kind, const Query &query,
+                                    const std::vector<const Array *> *objects) {
+  QueryHasher hasher;
+  CacheKey key;
+  key.add(kind);
+  key.add(query.constraints.cs().size());
+  for (const auto &constraint : query.constraints.cs())
+    key.add(hasher.hash(constraint));
+  key.add(hasher.hash(query.expr));
+  if (objects) {
+    key.add(objects->size());
+    for (const Array *array : *objects)
+      key.add(hasher.hash(array));
+  }
+  return key;
+}
+
+bool PersistentCachingSolver::mapIndex() {
+  int indexFd = open(indexPath.c_str(), O_RDWR);
+  if (indexFd == -1)
+    return false;
+
+  struct stat st;
+  IndexHeader header;
+  void *mapping = MAP_FAILED;
+  if (fstat(indexFd, &st) == 0 &&
+      klee_read_fully(indexFd, reinterpret_cast<char *>(&header),
+                      sizeof(header), 0) &&
+      std::memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) == 0 &&
+      header.version == CacheVersion && header.configHash == configHash &&
+      header.capacity && header.capacity <= MaxIndexCapacity &&
+      !(header.capacity & (header.capacity - 1)) &&
+      static_cast<uint64_t>(st.st_size) == indexFileSize(header.capacity))
+    mapping = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   indexFd, 0);
+  close(indexFd);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  unmapIndex();
+  index = mapping;
+  indexLength = st.st_size;
+  indexInode = st.st_ino;
+  return true;
+}
+
+void PersistentCachingSolver::unmapIndex() {
+  if (index)
+    munmap(index, indexLength);
+  index = nullptr;
+}
+
+bool PersistentCachingSolver::indexReplaced() const {
+  // The mapped index keeps its inode alive, so it cannot be reused
+  struct stat st;
+  return stat(indexPath.c_str(), &st) != 0 || st.st_ino != indexInode;
+}
+
+bool PersistentCachingSolver::rebuildIndex(uint64_t capacity, bool keep) {
+  if (capacity > MaxIndexCapacity)
+    return false;
+
+  // Readers must only ever see a complete index, so build it aside
+  std::string tempPath = indexPath + ".tmp" + std::to_string(getpid());
+  int tempFd = open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (tempFd == -1)
+    return false;
+  size_t length = indexFileSize(capacity);
+  void *mapping = MAP_FAILED;
+  if (ftruncate(tempFd, length) == 0)
+    mapping =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, tempFd, 0);
+  close(tempFd);
+  if (mapping == MAP_FAILED) {
+    unlink(tempPath.c_str());
+    return false;
+  }
+
+  IndexHeader *header = static_cast<IndexHeader *>(mapping);
+  std::memcpy(header->magic, IndexMagic, sizeof(IndexMagic));
+  header->version = CacheVersion;
+  header->configHash = configHash;
+  header->capacity = capacity;
+  header->dataSize = sizeof(FileHeader);
+  if (keep && index) {
+    IndexSlot *slots = reinterpret_cast<IndexSlot *>(header + 1);
+    for (uint64_t i = 0; i < indexHeader()->capacity; ++i) {
+      const IndexSlot &slot = indexSlots()[i];
+      if (!slot.offset)
+        continue;
+      if (IndexSlot *copy = probeSlot(slots, capacity,
+                                      CacheKey{slot.first, slot.second})) {
+        *copy = slot;
+        ++header->count;
+      }
+    }
+    header->dataSize = indexHeader()->dataSize;
+  }
+  munmap(mapping, length);
+
+  if (rename(tempPath.c_str(), indexPath.c_str()) != 0) {
+    unlink(tempPath.c_str());
+    return false;
+  }
+  return mapIndex();
+}
+
+bool PersistentCachingSolver::syncIndex() {
+  if ((!index || indexReplaced()) && !mapIndex() &&
+      !rebuildIndex(InitialIndexCapacity, false))
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1)
+    return false;
+  uint64_t fileSize = st.st_size;
+  // The cache file was truncated under the index, start over
+  if (indexHeader()->dataSize > fileSize &&
+      !rebuildIndex(InitialIndexCapacity, false))
+    return false;
+
+  uint64_t offset = indexHeader()->dataSize;
+  RecordHeader header;
+  while (offset < fileSize) {
+    if (!klee_read_fully(fd, reinterpret_cast<char *>(&header),
+                         sizeof(header), offset) ||
+        offset + sizeof(header) + header.size > fileSize) {
+      // Appending after a torn record would corrupt every later record
+      if (ftruncate(fd, offset) != 0)
+        return false;
+      klee_warning("dropped a truncated record from the persistent query "
+                   "cache");
+      break;
+    }
+    if (header.size > MaxRecordSize) {
+      // Without a plausible size there is no way to find the next record
+      klee_warning_once(0, "corrupt record in the persistent query cache, "
+                           "ignoring the rest of the file");
+      offset = fileSize;
+      break;
+    }
+    if (!addSlot(CacheKey{header.first, header.second},
+                 offset + sizeof(header), header.size, header.checksum))
+      return false;
+    offset += sizeof(header) + header.size;
+  }
+  indexHeader()->dataSize = offset;
+  return true;
+}
+
+bool PersistentCachingSolver::addSlot(const CacheKey &key, uint64_t offset,
+                                      uint32_t size, uint32_t checksum) {
+  if ((indexHeader()->count + 1) * 2 > indexHeader()->capacity &&
+      !rebuildIndex(indexHeader()->capacity * 2, true))
+    return false;
+
+  IndexSlot *slot = probeSlot(indexSlots(), indexHeader()->capacity, key);
+  if (!slot)
+    return false;
+  // Processes racing on the same query keep the first answer
+  if (slot->offset)
+    return true;
+  slot->first = key.first;
+  slot->second = key.second;
+  slot->size = size;
+  slot->checksum = checksum;
+  __atomic_store_n(&slot->offset, offset, __ATOMIC_RELEASE);
+  ++indexHeader()->count;
+  return true;
+}
+
+bool PersistentCachingSolver::findSlot(const CacheKey &key,
+                                       IndexSlot &slot) const {
+  if (!index)
+    return false;
+  const IndexSlot *found =
+      probeSlot(indexSlots(), indexHeader()->capacity, key);
+  if (!found || !found->offset)
+    return false;
+  slot = *found;
+  return true;
+}
+
+bool PersistentCachingSolver::lookup(const CacheKey &key,
+                                     SolverPayload &payload) {
+  IndexSlot slot;
+  // Another process may have grown the index
+  if (findSlot(key, slot) ||
+      (indexReplaced() && mapIndex() && findSlot(key, slot))) {
+    std::string data(slot.size, '\0');
+    if (klee_read_fully(fd, &data[0], data.size(), slot.offset) &&
+        computeChecksum(data) == slot.checksum) {
+      ++stats::queryPersistentCacheHits;
+      payload = SolverPayload(std::move(data));
+      return true;
+    }
+    klee_warning_once(0, "skipping corrupt records of the persistent query "
+                         "cache");
+  }
+  ++stats::queryPersistentCacheMisses;
+  return false;
+}
+
+void PersistentCachingSolver::insert(const CacheKey &key,
+                                     const SolverPayload &payload) {
+  if (payload.data().size() > MaxRecordSize)
+    return;
+  RecordHeader header = {key.first, key.second,
+                         static_cast<uint32_t>(payload.data().size()),
+                         computeChecksum(payload.data())};
+  std::string record(reinterpret_cast<const char *>(&header), sizeof(header));
+  record += payload.data();
+
+  // Under the lock the file ends with the last complete record once the
+  // index is synced, so the record goes exactly there
+  flock(fd, LOCK_EX);
+  struct stat st;
+  bool written = syncIndex() && fstat(fd, &st) == 0;
+  if (written) {
+    written = klee_write_fully(fd, record);
+    if (written) {
+      if (addSlot(key, st.st_size + sizeof(header), header.size,
+                  header.checksum))
+        indexHeader()->dataSize = st.st_size + record.size();
+    } else {
+      // Drop the torn record, so that the next one is appended after the
+      // last complete record
+      int error = errno;
+      if (ftruncate(fd, st.st_size) != 0)
+        klee_warning_once(0, "cannot drop a torn record from the persistent "
+                             "query cache");
+      errno = error;
+    }
+  }
+  flock(fd, LOCK_UN);
+
+  if (!written)
+    klee_warning_once(0, "failed to write to the persistent query cache - %s",
+                      llvm::sys::StrError(errno).c_str());
+}
+
+bool PersistentCachingSolver::computeValidity(const Query &query,
+                                              PartialValidity &result) {
+  CacheKey key = computeKey(VALIDITY_ENTRY, query);
+  SolverPayload payload;
+  if (lookup(key, payload) && payload.get(result))
+    return true;
+
+  if (!solver->impl->computeValidity(query, result))
+    return false;
+
+  // Partial answers depend on the solver timeout, do not keep them.
+  if (result == PValidity::MustBeTrue || result == PValidity::MustBeFalse ||
+      result == PValidity::TrueOrFalse) {
+    payload = SolverPayload();
+    payload.put(result);
+    insert(key, payload);
+  }
+  return true;
+}
+
+bool PersistentCachingSolver::computeTruth(const Query &query, bool &isValid) {
+  CacheKey key = computeKey(TRUTH_ENTRY, query);
+  SolverPayload payload;
+  if (lookup(key, payload) && payload.get(isValid))
+    return true;
+
+  if (!solver->impl->computeTruth(query, isValid))
+    return false;
+
+  payload = SolverPayload();
+  payload.put<bool>(isValid);
+  insert(key, payload);
+  return true;
+}
+
+bool PersistentCachingSolver::computeValue(const Query &query,
+                                           ref<Expr> &result) {
+  std::vector<const Array *> objects;
+  std::vector<SparseStorageImpl<unsigned char>> values;
+  bool hasSolution;
+
+  // Find the object used in the expression, and compute an assignment
+  // for them.
+  findSymbolicObjects(query.expr, objects);
+  if (!computeInitialValues(query.withFalse(), objects, values, hasSolution))
+    return false;
+  assert(hasSolution && "state has invalid constraint set");
+
+  // Evaluate the expression with the computed assignment.
+  Assignment a(objects, values);
+  result = a.evaluate(query.expr);
+
+  return true;
+}
+
+bool PersistentCachingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  CacheKey key = computeKey(INITIAL_VALUES_ENTRY, query, &objects);
+  SolverPayload payload;
+  if (lookup(key, payload) && payload.get(hasSolution) &&
+      (!hasSolution || payload.getValues(values)))
+    return true;
+
+  values.clear();
+  if (!solver->impl->computeInitialValues(query, objects, values, hasSolution))
+    return false;
+
+  payload = SolverPayload();
+  payload.put<bool>(hasSolution);
+  if (hasSolution)
+    payload.putValues(values);
+  insert(key, payload);
+  return true;
+}
+
+bool PersistentCachingSolver::computeValidityCore(const Query &query,
+                                                  ValidityCore &validityCore,
+                                                  bool &isValid) {
+  return solver->impl->computeValidityCore(query, validityCore, isValid);
+}
+
+bool PersistentCachingSolver::computeMinimalUnsignedValue(
+    const Query &query, ref<ConstantExpr> &result) {
+  return solver->impl->computeMinimalUnsignedValue(query, result);
+}
+
+SolverImpl::SolverRunStatus PersistentCachingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *PersistentCachingSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void PersistentCachingSolver::setCoreSolverTimeout(time::Span timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void PersistentCachingSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+std::unique_ptr<Solver>
+klee::createPersistentCachingSolver(std::unique_ptr<Solver> s,
+                                    const std::string &path) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd == -1) {
+    klee_warning("cannot open persistent query cache %s - %s", path.c_str(),
+                 llvm::sys::StrError(errno).c_str());
+    return s;
+  }
+
+  FileHeader expected;
+  std::memcpy(expected.magic, CacheMagic, sizeof(CacheMagic));
+  expected.version = CacheVersion;
+  uint64_t configHash = computeConfigHash();
+  expected.configHash = configHash;
+
+  // The first process to open a new cache writes its header
+  flock(fd, LOCK_EX);
+  struct stat st;
+  bool valid = fstat(fd, &st) == 0;
+  if (valid && st.st_size == 0) {
+    valid = klee_write_fully(
+        fd, std::string(reinterpret_cast<const char *>(&expected),
+                        sizeof(expected)));
+  } else if (valid) {
+    FileHeader header;
+    valid = klee_read_fully(fd, reinterpret_cast<char *>(&header),
+                            sizeof(header), 0) &&
+            std::memcmp(&header, &expected, sizeof(header)) == 0;
+  }
+  flock(fd, LOCK_UN);
+
+  if (!valid) {
+    klee_warning("persistent query cache %s was written by another build, "
+                 "other solvers or is not a query cache, not using it",
+                 path.c_str());
+    close(fd);
+    return s;
+  }
+  return std::make_unique<Solver>(std::make_unique<PersistentCachingSolver>(
+      std::move(s), fd, configHash, path));
+}
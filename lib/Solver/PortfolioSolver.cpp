@@ -0,0 +1,423 @@
+//===-- PortfolioSolver.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryFeatures.h"
+#include "SolverPayload.h"
+#include "SolverWorker.h"
+
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/ExprUtil.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Support/ErrorHandling.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <poll.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+/// Races a shape must have seen before queries of that shape may skip racing
+const uint64_t WarmupRaces = 8;
+
+/// Every n-th query of a shape which skips racing is raced anyway, so that
+/// a favourite which got worse is noticed
+const uint64_t ExplorationPeriod = 16;
+
+/// Outcomes of the races among queries of one shape.
+struct ShapeRecord {
+  uint64_t races = 0;
+  uint64_t solo = 0;
+  std::vector<uint64_t> wins;
+};
+} // namespace
+
+/// PortfolioSolver - Races several core solvers on every query, each in a
+/// forked process, and takes the first answer. Once one solver has won
+/// nearly every race among queries of some shape, such queries are given to
+/// it alone and answered without forking.
+class PortfolioSolver : public SolverImpl {
+private:
+  using Job = std::function<bool(Solver &, SolverPayload &)>;
+
+  std::vector<std::unique_ptr<Solver>> solvers;
+  std::unordered_map<uint64_t, ShapeRecord> records;
+  time::Span timeout;
+  SolverRunStatus runStatusCode;
+
+  /// The solver which won nearly every race among queries of the given
+  /// shape, if any.
+  int favourite(const ShapeRecord &record) const;
+
+  /// Run `job` with every solver but `excluded` in its own process and
+  /// collect the payload of the first which succeeds.
+  bool race(ShapeRecord &record, const Job &job, SolverPayload &payload,
+            int excluded = -1);
+
+  /// Answer the query with `job`, either by its favourite solver or by a
+  /// race.
+  bool run(const Query &query, const Job &job, SolverPayload &payload);
+
+public:
+  PortfolioSolver(std::vector<std::unique_ptr<Solver>> solvers)
+      : solvers(std::move(solvers)),
+        runStatusCode(SOLVER_RUN_STATUS_FAILURE) {}
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeValidity(const Query &query, ref<SolverResponse> &queryResult,
+                       ref<SolverResponse> &negatedQueryResult);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool
+  computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+/// Encode a response to `query` for the given objects into `payload`.
+static bool putResponse(SolverPayload &payload, const Query &query,
+                        const std::vector<const Array *> &objects,
+                        const ref<SolverResponse> &response) {
+  if (auto valid = dyn_cast<ValidResponse>(response)) {
+    payload.put<unsigned char>(1);
+    return payload.putCore(query.constraints.cs(), valid->validityCore());
+  }
+  std::vector<SparseStorageImpl<unsigned char>> model;
+  if (!isa<InvalidResponse>(response) ||
+      !response->tryGetInitialValuesFor(objects, model)) {
+    payload.put<unsigned char>(0);
+    return true;
+  }
+  payload.put<unsigned char>(2);
+  payload.putValues(model);
+  return true;
+}
+
+/// Decode a response encoded by putResponse() for the same query.
+static bool getResponse(SolverPayload &payload, const Query &query,
+                        const std::vector<const Array *> &objects,
+                        ref<SolverResponse> &response) {
+  unsigned char kind;
+  if (!payload.get(kind))
+    return false;
+  if (kind == 1) {
+    ValidityCore core;
+    if (!payload.getCore(query.constraints.cs(), query.expr, core))
+      return false;
+    response = new ValidResponse(core);
+    return true;
+  }
+  if (kind == 2) {
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    if (!payload.getValues(values))
+      return false;
+    response = new InvalidResponse(objects, values);
+    return true;
+  }
+  response = new UnknownResponse();
+  return kind == 0;
+}
+
+int PortfolioSolver::favourite(const ShapeRecord &record) const {
+  if (record.races < WarmupRaces)
+    return -1;
+  for (unsigned i = 0; i < record.wins.size(); ++i) {
+    // Won at least nine races out of ten
+    if (record.wins[i] * 10 >= record.races * 9)
+      return i;
+  }
+  return -1;
+}
+
+bool PortfolioSolver::race(ShapeRecord &record, const Job &job,
+                           SolverPayload &payload, int excluded) {
+  // A race counts even if nobody wins it, the excluded solver lost it too
+  ++record.races;
+  std::vector<SolverWorker> workers(solvers.size());
+  std::vector<unsigned> running;
+  for (unsigned i = 0; i < solvers.size(); ++i) {
+    if (static_cast<int>(i) == excluded)
+      continue;
+    Solver &solver = *solvers[i];
+    if (workers[i].spawn(
+            [&job, &solver](SolverPayload &payload) {
+              return job(solver, payload);
+            },
+            timeout))
+      running.push_back(i);
+  }
+  if (running.empty()) {
+    runStatusCode = SOLVER_RUN_STATUS_FORK_FAILED;
+    return false;
+  }
+
+  runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+  while (!running.empty()) {
+    std::vector<pollfd> fds;
+    for (unsigned i : running)
+      fds.push_back({workers[i].descriptor(), POLLIN, 0});
+    int ready = poll(fds.data(), fds.size(), -1);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      klee_warning("poll() for solver workers failed");
+      return false;
+    }
+    for (unsigned j = fds.size(); j-- > 0;) {
+      if (!fds[j].revents)
+        continue;
+      unsigned i = running[j];
+      running.erase(running.begin() + j);
+      SolverPayload answer;
+      runStatusCode = workers[i].collect(answer);
+      if (runStatusCode == SOLVER_RUN_STATUS_SUCCESS_SOLVABLE) {
+        // The losers are killed when their workers go out of scope
+        ++record.wins[i];
+        payload = std::move(answer);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool PortfolioSolver::run(const Query &query, const Job &job,
+                          SolverPayload &payload) {
+  ShapeRecord &record = records[QueryFeatures(query).shape()];
+  record.wins.resize(solvers.size());
+  int solver = favourite(record);
+  if (solver >= 0 && ++record.solo % ExplorationPeriod != 0) {
+    if (job(*solvers[solver], payload)) {
+      runStatusCode = SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+      return true;
+    }
+    // Let the others try, the favourite lost this one
+    payload = SolverPayload();
+    return race(record, job, payload, solver);
+  }
+  return race(record, job, payload);
+}
+
+bool PortfolioSolver::computeTruth(const Query &query, bool &isValid) {
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query](Solver &solver, SolverPayload &payload) {
+            bool valid;
+            if (!solver.impl->computeTruth(query, valid))
+              return false;
+            payload.put<bool>(valid);
+            return true;
+          },
+          payload))
+    return false;
+  if (!payload.get(isValid)) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  runStatusCode = isValid ? SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE
+                          : SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  return true;
+}
+
+bool PortfolioSolver::computeValidity(const Query &query,
+                                      PartialValidity &result) {
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query](Solver &solver, SolverPayload &payload) {
+            PartialValidity validity;
+            if (!solver.impl->computeValidity(query, validity))
+              return false;
+            payload.put<PartialValidity>(validity);
+            return true;
+          },
+          payload))
+    return false;
+  if (!payload.get(result)) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  return true;
+}
+
+bool PortfolioSolver::computeValidity(const Query &query,
+                                      ref<SolverResponse> &queryResult,
+                                      ref<SolverResponse> &negatedQueryResult) {
+  std::vector<const Array *> objects;
+  findSymbolicObjects(query, objects);
+  Query negatedQuery = query.negateExpr();
+
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query, &negatedQuery, &objects](Solver &solver,
+                                            SolverPayload &payload) {
+            ref<SolverResponse> queryResult, negatedQueryResult;
+            if (!solver.impl->computeValidity(query, queryResult,
+                                              negatedQueryResult))
+              return false;
+            return putResponse(payload, query, objects, queryResult) &&
+                   putResponse(payload, negatedQuery, objects,
+                               negatedQueryResult);
+          },
+          payload))
+    return false;
+  if (!getResponse(payload, query, objects, queryResult) ||
+      !getResponse(payload, negatedQuery, objects, negatedQueryResult)) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  return true;
+}
+
+bool PortfolioSolver::computeValue(const Query &query, ref<Expr> &result) {
+  std::vector<const Array *> objects;
+  std::vector<SparseStorageImpl<unsigned char>> values;
+  bool hasSolution;
+
+  // Find the object used in the expression, and compute an assignment
+  // for them.
+  findSymbolicObjects(query.expr, objects);
+  if (!computeInitialValues(query.withFalse(), objects, values, hasSolution))
+    return false;
+  assert(hasSolution && "state has invalid constraint set");
+
+  // Evaluate the expression with the computed assignment.
+  Assignment a(objects, values);
+  result = a.evaluate(query.expr);
+
+  return true;
+}
+
+bool PortfolioSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query, &objects](Solver &solver, SolverPayload &payload) {
+            std::vector<SparseStorageImpl<unsigned char>> model;
+            bool solvable;
+            if (!solver.impl->computeInitialValues(query, objects, model,
+                                                   solvable))
+              return false;
+            payload.put<bool>(solvable);
+            if (solvable)
+              payload.putValues(model);
+            return true;
+          },
+          payload))
+    return false;
+  if (!payload.get(hasSolution) ||
+      (hasSolution && !payload.getValues(values))) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  runStatusCode = hasSolution ? SOLVER_RUN_STATUS_SUCCESS_SOLVABLE
+                              : SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE;
+  return true;
+}
+
+bool PortfolioSolver::check(const Query &query, ref<SolverResponse> &result) {
+  std::vector<const Array *> objects;
+  findSymbolicObjects(query, objects);
+
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query, &objects](Solver &solver, SolverPayload &payload) {
+            ref<SolverResponse> response;
+            if (!solver.impl->check(query, response) ||
+                isa<UnknownResponse>(response))
+              return false;
+            return putResponse(payload, query, objects, response);
+          },
+          payload))
+    return false;
+
+  if (!getResponse(payload, query, objects, result) ||
+      isa<UnknownResponse>(result)) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  runStatusCode = isa<ValidResponse>(result)
+                      ? SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE
+                      : SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  return true;
+}
+
+bool PortfolioSolver::computeValidityCore(const Query &query,
+                                          ValidityCore &validityCore,
+                                          bool &isValid) {
+  SolverPayload payload;
+  if (!run(
+          query,
+          [&query](Solver &solver, SolverPayload &payload) {
+            ValidityCore core;
+            bool valid;
+            if (!solver.impl->computeValidityCore(query, core, valid))
+              return false;
+            payload.put<bool>(valid);
+            return !valid || payload.putCore(query.constraints.cs(), core);
+          },
+          payload))
+    return false;
+  if (!payload.get(isValid) ||
+      (isValid &&
+       !payload.getCore(query.constraints.cs(), query.expr, validityCore))) {
+    runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+    return false;
+  }
+  runStatusCode = isValid ? SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE
+                          : SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  return true;
+}
+
+SolverImpl::SolverRunStatus PortfolioSolver::getOperationStatusCode() {
+  return runStatusCode;
+}
+
+char *PortfolioSolver::getConstraintLog(const Query &query) {
+  return solvers.front()->impl->getConstraintLog(query);
+}
+
+void PortfolioSolver::setCoreSolverTimeout(time::Span timeout) {
+  this->timeout = timeout;
+  for (auto &solver : solvers)
+    solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void PortfolioSolver::notifyStateTermination(std::uint32_t id) {
+  for (auto &solver : solvers)
+    solver->impl->notifyStateTermination(id);
+}
+
+std::unique_ptr<Solver>
+klee::createPortfolioSolver(std::vector<std::unique_ptr<Solver>> solvers) {
+  assert(!solvers.empty() && "portfolio without solvers");
+  if (solvers.size() == 1)
+    return std::move(solvers.front());
+  return std::make_unique<Solver>(
+      std::make_unique<PortfolioSolver>(std::move(solvers)));
+}
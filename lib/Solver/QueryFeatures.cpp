@@ -0,0 +1,132 @@
+//===-- QueryFeatures.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryFeatures.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/Solver.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+bool isFloatKind(Expr::Kind kind) {
+  switch (kind) {
+  case Expr::FPExt:
+  case Expr::FPTrunc:
+  case Expr::FPToUI:
+  case Expr::FPToSI:
+  case Expr::UIToFP:
+  case Expr::SIToFP:
+  case Expr::FSqrt:
+  case Expr::FAbs:
+  case Expr::FNeg:
+  case Expr::FRint:
+  case Expr::IsNaN:
+  case Expr::IsInfinite:
+  case Expr::IsNormal:
+  case Expr::IsSubnormal:
+  case Expr::FAdd:
+  case Expr::FSub:
+  case Expr::FMul:
+  case Expr::FDiv:
+  case Expr::FRem:
+  case Expr::FMax:
+  case Expr::FMin:
+  case Expr::FOEq:
+  case Expr::FOLt:
+  case Expr::FOLe:
+  case Expr::FOGt:
+  case Expr::FOGe:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool isNonLinearKind(Expr::Kind kind) {
+  switch (kind) {
+  case Expr::Mul:
+  case Expr::UDiv:
+  case Expr::SDiv:
+  case Expr::URem:
+  case Expr::SRem:
+    return true;
+  default:
+    return false;
+  }
+}
+} // namespace
+
+QueryFeatures::QueryFeatures(const Query &query) {
+  ExprHashSet visited;
+  std::unordered_set<const Array *> readArrays;
+  std::vector<ref<Expr>> stack(query.constraints.cs().begin(),
+                               query.constraints.cs().end());
+  stack.push_back(query.expr);
+  while (!stack.empty()) {
+    ref<Expr> e = stack.back();
+    stack.pop_back();
+    if (!visited.insert(e).second)
+      continue;
+
+    ++nodes;
+    ++kinds[e->getKind()];
+    maxWidth = std::max(maxWidth, e->getWidth());
+    if (auto re = dyn_cast<ReadExpr>(e)) {
+      readArrays.insert(re->updates.root);
+      maxUpdateDepth =
+          std::max<uint64_t>(maxUpdateDepth, re->updates.getSize());
+    } else if (isNonLinearKind(e->getKind())) {
+      if (!isa<ConstantExpr>(e->getKid(0)) && !isa<ConstantExpr>(e->getKid(1)))
+        ++nonLinear;
+    } else if (isFloatKind(e->getKind())) {
+      ++floats;
+    }
+
+    for (unsigned i = 0; i < e->getNumKids(); ++i)
+      stack.push_back(e->getKid(i));
+  }
+  arrays = readArrays.size();
+}
+
+uint64_t QueryFeatures::shape() const {
+  uint64_t sizeClass = 0;
+  for (uint64_t n = nodes; n >>= 2;)
+    ++sizeClass;
+  return (sizeClass << 3) | (uint64_t(arrays != 0) << 2) |
+         (uint64_t(nonLinear != 0) << 1) | uint64_t(floats != 0);
+}
+
+void QueryFeatures::print(llvm::raw_ostream &os) const {
+  os << shape() << ',' << nodes << ',' << arrays << ',' << maxUpdateDepth
+     << ',' << maxWidth << ',' << nonLinear << ',' << floats;
+  for (uint32_t count : kinds)
+    os << ',' << count;
+}
+
+void QueryFeatures::printHeader(llvm::raw_ostream &os) {
+  os << "shape,nodes,arrays,max_update_depth,max_width,non_linear,floats";
+  for (unsigned kind = 0; kind < std::tuple_size<decltype(kinds)>::value;
+       ++kind) {
+    os << ',';
+    if (kind == Expr::NotOptimized + 1) {
+      // Unused kind number
+      os << "Unused";
+      continue;
+    }
+    Expr::printKind(os, static_cast<Expr::Kind>(kind));
+  }
+}
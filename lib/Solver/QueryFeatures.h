@@ -0,0 +1,56 @@
+//===-- QueryFeatures.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_QUERYFEATURES_H
+#define KLEE_QUERYFEATURES_H
+
+#include "klee/Expr/Expr.h"
+
+#include <array>
+#include <cstdint>
+
+namespace llvm {
+class raw_ostream;
+} // namespace llvm
+
+namespace klee {
+struct Query;
+
+/// QueryFeatures - Cheap syntactic measures of a query, used to predict how
+/// hard it is to solve.
+struct QueryFeatures {
+  /// Number of distinct nodes of each kind
+  std::array<uint32_t, Expr::ConstantPointer + 1> kinds{};
+  uint64_t nodes = 0;
+  /// Number of distinct arrays read
+  uint64_t arrays = 0;
+  /// Length of the longest update list read through
+  uint64_t maxUpdateDepth = 0;
+  Expr::Width maxWidth = 0;
+  /// Multiplications, divisions and remainders of two non-constants
+  uint64_t nonLinear = 0;
+  /// Floating point operations and predicates
+  uint64_t floats = 0;
+
+  explicit QueryFeatures(const Query &query);
+
+  /// A coarse class of queries of similar difficulty, made of the magnitude
+  /// of the query size and of whether it reads arrays, has non-linear
+  /// arithmetic or floating point.
+  uint64_t shape() const;
+
+  /// Print the features as comma-separated values, in the order of the
+  /// columns named by printHeader.
+  void print(llvm::raw_ostream &os) const;
+  static void printHeader(llvm::raw_ostream &os);
+};
+
+} // namespace klee
+
+#endif /* KLEE_QUERYFEATURES_H */
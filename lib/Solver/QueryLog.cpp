@@ -0,0 +1,752 @@
+//===-- QueryLog.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver/QueryLog.h"
+
+#include "klee/ADT/SparseStorage.h"
+#include "klee/Config/config.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/SourceBuilder.h"
+#include "klee/Expr/SymbolicSource.h"
+#include "klee/Solver/SolverUtil.h"
+
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+
+#ifdef HAVE_ZLIB_H
+#include "zlib.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+using namespace klee;
+
+namespace {
+const char Magic[] = {'K', 'Q', 'L', 'O', 'G'};
+const uint64_t Version = 1;
+
+/// Once this many expressions and update nodes are retained, the writer
+/// starts afresh, so that logging does not keep every expression of the run
+/// alive
+const size_t MaxLoggedNodes = 1 << 18;
+
+enum RecordTag : char {
+  ResetRecord = 'R',
+  ArrayRecord = 'A',
+  ExprRecord = 'E',
+  UpdateRecord = 'U',
+  QueryRecord = 'Q'
+};
+
+enum ArrayKind : uint8_t { SymbolicArray, ConstantArray, OpaqueArray };
+
+void putVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+bool getRoundingMode(const Expr *e, llvm::APFloat::roundingMode &rm) {
+  switch (e->getKind()) {
+#define ROUNDING_MODE_CASE(T)                                                  \
+  case Expr::T:                                                                \
+    rm = static_cast<const T##Expr *>(e)->roundingMode;                        \
+    return true;
+    ROUNDING_MODE_CASE(FPTrunc)
+    ROUNDING_MODE_CASE(FPToUI)
+    ROUNDING_MODE_CASE(FPToSI)
+    ROUNDING_MODE_CASE(UIToFP)
+    ROUNDING_MODE_CASE(SIToFP)
+    ROUNDING_MODE_CASE(FSqrt)
+    ROUNDING_MODE_CASE(FRint)
+    ROUNDING_MODE_CASE(FAdd)
+    ROUNDING_MODE_CASE(FSub)
+    ROUNDING_MODE_CASE(FMul)
+    ROUNDING_MODE_CASE(FDiv)
+    ROUNDING_MODE_CASE(FRem)
+    ROUNDING_MODE_CASE(FMax)
+    ROUNDING_MODE_CASE(FMin)
+#undef ROUNDING_MODE_CASE
+  default:
+    return false;
+  }
+}
+} // namespace
+
+const char *klee::getQueryLogOperationName(QueryLogOperation operation) {
+  switch (operation) {
+  case QueryLogOperation::Truth:
+    return "Truth";
+  case QueryLogOperation::Validity:
+    return "Validity";
+  case QueryLogOperation::Value:
+    return "Value";
+  case QueryLogOperation::InitialValues:
+    return "InitialValues";
+  case QueryLogOperation::Check:
+    return "Check";
+  case QueryLogOperation::ValidityCore:
+    return "ValidityCore";
+  case QueryLogOperation::Feasibility:
+    return "Feasibility";
+  }
+  return "Unknown";
+}
+
+/***/
+
+QueryLogWriter::QueryLogWriter(llvm::raw_ostream &os) : os(os) {
+  record.append(Magic, sizeof(Magic));
+  putVarint(record, Version);
+  os << record;
+  record.clear();
+}
+
+void QueryLogWriter::reset() {
+  record.push_back(ResetRecord);
+  exprIds.clear();
+  loggedExprs.clear();
+  updateIds.clear();
+  loggedUpdates.clear();
+  arrayIds.clear();
+}
+
+uint64_t QueryLogWriter::encode(const Array *array) {
+  auto it = arrayIds.find(array);
+  if (it != arrayIds.end())
+    return it->second;
+
+  uint64_t size = encode(array->size);
+  uint8_t kind = SymbolicArray;
+  uint64_t defaultValue = 0;
+  std::vector<std::pair<uint64_t, uint64_t>> values;
+  if (auto constant = dyn_cast<ConstantSource>(array->source)) {
+    kind = ConstantArray;
+    if (constant->constantValues->defaultV())
+      defaultValue = encode(constant->constantValues->defaultV());
+    for (const auto &value :
+         constant->constantValues->calculateOrderedStorage())
+      values.emplace_back(value.first, encode(value.second));
+  } else if (isa<MockDeterministicSource>(array->source)) {
+    // Its contents are a function of the mocked function, known only to
+    // the module
+    kind = OpaqueArray;
+  }
+
+  record.push_back(ArrayRecord);
+  putVarint(record, kind);
+  putVarint(record, size);
+  putVarint(record, array->domain);
+  putVarint(record, array->range);
+  if (kind == ConstantArray) {
+    putVarint(record, defaultValue);
+    putVarint(record, values.size());
+    for (const auto &value : values) {
+      putVarint(record, value.first);
+      putVarint(record, value.second);
+    }
+  } else if (kind == SymbolicArray) {
+    std::string name = array->getIdentifier();
+    unsigned version = 0;
+    if (auto symbolic = dyn_cast<MakeSymbolicSource>(array->source)) {
+      name = symbolic->name;
+      version = symbolic->version;
+    }
+    putVarint(record, name.size());
+    record.append(name);
+    putVarint(record, version);
+  }
+
+  uint64_t id = arrayIds.size() + 1;
+  arrayIds.emplace(array, id);
+  return id;
+}
+
+uint64_t QueryLogWriter::encode(const UpdateList &updates) {
+  // Update lists can be thousands of writes long, so walk back to the
+  // newest node logged before instead of recursing
+  std::vector<const UpdateNode *> unlogged;
+  uint64_t next = 0;
+  for (const UpdateNode *un = updates.head.get(); un; un = un->next.get()) {
+    auto it = updateIds.find(un);
+    if (it != updateIds.end()) {
+      next = it->second;
+      break;
+    }
+    unlogged.push_back(un);
+  }
+
+  for (auto it = unlogged.rbegin(), ie = unlogged.rend(); it != ie; ++it) {
+    const UpdateNode *un = *it;
+    uint64_t index = encode(un->index);
+    uint64_t value = encode(un->value);
+    record.push_back(UpdateRecord);
+    putVarint(record, next);
+    putVarint(record, index);
+    putVarint(record, value);
+    loggedUpdates.push_back(ref<UpdateNode>(const_cast<UpdateNode *>(un)));
+    next = loggedUpdates.size();
+    updateIds.emplace(un, next);
+  }
+  return next;
+}
+
+uint64_t QueryLogWriter::encode(const ref<Expr> &e) {
+  auto it = exprIds.find(e);
+  if (it != exprIds.end())
+    return it->second;
+
+  llvm::SmallVector<uint64_t, 4> operands;
+  switch (e->getKind()) {
+  case Expr::Constant: {
+    const ConstantExpr *ce = cast<ConstantExpr>(e);
+    const llvm::APInt &value = ce->getAPValue();
+    operands.push_back(ce->isFloat());
+    operands.append(value.getRawData(),
+                    value.getRawData() + value.getNumWords());
+    break;
+  }
+  case Expr::Read: {
+    const ReadExpr *re = cast<ReadExpr>(e);
+    operands.push_back(encode(re->updates.root));
+    operands.push_back(encode(re->updates));
+    operands.push_back(encode(re->index));
+    break;
+  }
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    operands.push_back(encode(ee->expr));
+    operands.push_back(ee->offset);
+    break;
+  }
+  default: {
+    for (unsigned i = 0; i < e->getNumKids(); ++i)
+      operands.push_back(encode(e->getKid(i)));
+    llvm::APFloat::roundingMode rm;
+    if (getRoundingMode(e.get(), rm))
+      operands.push_back(static_cast<uint8_t>(rm));
+    break;
+  }
+  }
+
+  record.push_back(ExprRecord);
+  putVarint(record, e->getKind());
+  putVarint(record, e->getWidth());
+  putVarint(record, operands.size());
+  for (uint64_t operand : operands)
+    putVarint(record, operand);
+
+  loggedExprs.push_back(e);
+  uint64_t id = loggedExprs.size();
+  exprIds.emplace(e, id);
+  return id;
+}
+
+void QueryLogWriter::write(QueryLogOperation operation, const Query &query,
+                           const std::vector<ref<Expr>> &conditions,
+                           const std::vector<const Array *> &objects,
+                           const QueryLogOutcome &outcome) {
+  if (loggedExprs.size() + loggedUpdates.size() > MaxLoggedNodes)
+    reset();
+
+  std::vector<uint64_t> constraintIds;
+  constraintIds.reserve(query.constraints.cs().size());
+  for (const auto &constraint : query.constraints.cs())
+    constraintIds.push_back(encode(constraint));
+  uint64_t exprId = encode(query.expr);
+  std::vector<uint64_t> conditionIds;
+  for (const auto &condition : conditions)
+    conditionIds.push_back(encode(condition));
+  std::vector<uint64_t> objectIds;
+  for (const Array *object : objects)
+    objectIds.push_back(encode(object));
+
+  record.push_back(QueryRecord);
+  record.push_back(static_cast<char>(operation));
+  putVarint(record, constraintIds.size());
+  for (uint64_t id : constraintIds)
+    putVarint(record, id);
+  putVarint(record, exprId);
+  putVarint(record, conditionIds.size());
+  for (uint64_t id : conditionIds)
+    putVarint(record, id);
+  putVarint(record, objectIds.size());
+  for (uint64_t id : objectIds)
+    putVarint(record, id);
+  putVarint(record, outcome.success | (outcome.hasAnswer << 1));
+  putVarint(record, outcome.status);
+  if (outcome.hasAnswer)
+    putVarint(record, zigzag(outcome.answer));
+  putVarint(record, outcome.elapsed.toMicroseconds());
+
+  os << record;
+  record.clear();
+}
+
+/***/
+
+/// The bytes of a log, inflated on the fly when it is compressed.
+class QueryLogReader::Input {
+  const char *cursor;
+  const char *end;
+  bool compressed = false;
+#ifdef HAVE_ZLIB_H
+  z_stream stream;
+  std::string chunk;
+  bool finished = false;
+#endif
+
+  bool refill() {
+#ifdef HAVE_ZLIB_H
+    if (!compressed || finished)
+      return false;
+    chunk.resize(1 << 16);
+    stream.next_out = reinterpret_cast<Bytef *>(&chunk[0]);
+    stream.avail_out = chunk.size();
+    // A log cut short by a crash ends at the last point its writer synced
+    // the compressed stream, which is always a record boundary
+    if (inflate(&stream, Z_NO_FLUSH) != Z_OK)
+      finished = true;
+    cursor = chunk.data();
+    end = cursor + chunk.size() - stream.avail_out;
+    return cursor != end;
+#else
+    return false;
+#endif
+  }
+
+public:
+  std::string error;
+
+  explicit Input(llvm::StringRef data)
+      : cursor(data.begin()), end(data.end()) {
+    if (data.size() < 2 || static_cast<unsigned char>(data[0]) != 0x1f ||
+        static_cast<unsigned char>(data[1]) != 0x8b)
+      return;
+#ifdef HAVE_ZLIB_H
+    compressed = true;
+    cursor = end = nullptr;
+    std::memset(&stream, 0, sizeof(stream));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = data.size();
+    // Expect the gzip header written by compressed_fd_ostream
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+      error = "cannot initialise decompression";
+      compressed = false;
+    }
+#else
+    error = "the log is compressed, but KLEE was built without zlib";
+#endif
+  }
+
+  ~Input() {
+#ifdef HAVE_ZLIB_H
+    if (compressed)
+      inflateEnd(&stream);
+#endif
+  }
+
+  bool atEnd() { return cursor == end && !refill(); }
+
+  bool getByte(uint8_t &byte) {
+    if (atEnd())
+      return false;
+    byte = static_cast<uint8_t>(*cursor++);
+    return true;
+  }
+
+  bool getVarint(uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!getByte(byte))
+        return false;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool getBytes(std::string &bytes, size_t size) {
+    bytes.clear();
+    while (bytes.size() < size) {
+      if (atEnd())
+        return false;
+      size_t available = std::min<size_t>(end - cursor, size - bytes.size());
+      bytes.append(cursor, available);
+      cursor += available;
+    }
+    return true;
+  }
+};
+
+QueryLogReader::QueryLogReader(llvm::StringRef data)
+    : input(std::make_unique<Input>(data)) {
+  if (!input->error.empty()) {
+    fail(input->error);
+    return;
+  }
+  std::string magic;
+  uint64_t version;
+  if (!input->getBytes(magic, sizeof(Magic)) ||
+      std::memcmp(magic.data(), Magic, sizeof(Magic)) ||
+      !input->getVarint(version)) {
+    fail("not a binary query log");
+    return;
+  }
+  if (version != Version)
+    fail("unsupported query log version " + std::to_string(version));
+}
+
+QueryLogReader::~QueryLogReader() = default;
+
+bool QueryLogReader::fail(const std::string &message) {
+  if (error.empty())
+    error = message;
+  return false;
+}
+
+bool QueryLogReader::readArray() {
+  uint64_t kind, sizeId, domain, range;
+  if (!input->getVarint(kind) || !input->getVarint(sizeId) ||
+      !input->getVarint(domain) || !input->getVarint(range) || !sizeId ||
+      sizeId > exprs.size())
+    return fail("malformed array record");
+  ref<Expr> size = exprs[sizeId - 1];
+
+  ref<SymbolicSource> source;
+  switch (kind) {
+  case ConstantArray: {
+    uint64_t defaultId, count;
+    if (!input->getVarint(defaultId) || !input->getVarint(count) ||
+        defaultId > exprs.size())
+      return fail("malformed constant array record");
+    ref<ConstantExpr> defaultValue;
+    if (defaultId)
+      defaultValue = dyn_cast_or_null<ConstantExpr>(exprs[defaultId - 1]);
+    std::unordered_map<size_t, ref<ConstantExpr>> storage;
+    for (uint64_t i = 0; i < count; ++i) {
+      uint64_t index, valueId;
+      if (!input->getVarint(index) || !input->getVarint(valueId) ||
+          !valueId || valueId > exprs.size())
+        return fail("malformed constant array record");
+      storage.emplace(index,
+                      dyn_cast_or_null<ConstantExpr>(exprs[valueId - 1]));
+    }
+    SparseStorageImpl<ref<ConstantExpr>> values(storage, defaultValue);
+    source = SourceBuilder::constant(values.clone());
+    break;
+  }
+  case SymbolicArray: {
+    uint64_t length, version;
+    std::string name;
+    if (!input->getVarint(length) || !input->getBytes(name, length) ||
+        !input->getVarint(version))
+      return fail("malformed symbolic array record");
+    source = SourceBuilder::makeSymbolic(name, version);
+    break;
+  }
+  case OpaqueArray:
+    break;
+  default:
+    return fail("unknown array kind");
+  }
+
+  if (source && size)
+    arrays.push_back(Array::create(size, source, domain, range));
+  else
+    arrays.push_back(nullptr);
+  return true;
+}
+
+bool QueryLogReader::readUpdate() {
+  uint64_t nextId, indexId, valueId;
+  if (!input->getVarint(nextId) || !input->getVarint(indexId) ||
+      !input->getVarint(valueId) || nextId > updates.size() || !indexId ||
+      indexId > exprs.size() || !valueId || valueId > exprs.size())
+    return fail("malformed update record");
+
+  ref<UpdateNode> next = nextId ? updates[nextId - 1] : nullptr;
+  ref<Expr> index = exprs[indexId - 1];
+  ref<Expr> value = exprs[valueId - 1];
+  if ((nextId && !next) || !index || !value)
+    updates.push_back(nullptr);
+  else
+    updates.push_back(new UpdateNode(next, index, value));
+  return true;
+}
+
+bool QueryLogReader::readExpr() {
+  uint64_t kindValue, width, count;
+  // No expression has more operands than the words of a constant, or than
+  // the kids and rounding mode of a rounded operation
+  if (!input->getVarint(kindValue) || !input->getVarint(width) ||
+      !input->getVarint(count) || count > width / 64 + 4)
+    return fail("malformed expression record");
+  llvm::SmallVector<uint64_t, 4> operands(count);
+  for (uint64_t &operand : operands)
+    if (!input->getVarint(operand))
+      return fail("malformed expression record");
+
+  Expr::Kind kind = static_cast<Expr::Kind>(kindValue);
+  if (kind == Expr::Constant) {
+    if (operands.empty())
+      return fail("malformed constant");
+    llvm::APInt value(width, llvm::makeArrayRef(operands).drop_front());
+    if (operands[0])
+      exprs.push_back(ConstantExpr::alloc(
+          llvm::APFloat(ConstantExpr::widthToFloatSemantics(width), value)));
+    else
+      exprs.push_back(ConstantExpr::alloc(value));
+    return true;
+  }
+
+  // Operands naming expressions, and whether all of them could be rebuilt
+  auto kid = [&](unsigned i, ref<Expr> &e) {
+    if (i >= operands.size() || !operands[i] || operands[i] > exprs.size())
+      return fail("malformed expression operand");
+    e = exprs[operands[i] - 1];
+    return true;
+  };
+  auto roundingMode = [&](unsigned i) {
+    return static_cast<llvm::APFloat::roundingMode>(
+        static_cast<int8_t>(operands[i]));
+  };
+
+  ref<Expr> result;
+  bool complete = true;
+  std::vector<Expr::CreateArg> args;
+  switch (kind) {
+  case Expr::Read: {
+    ref<Expr> index;
+    if (operands.size() != 3 || !operands[0] ||
+        operands[0] > arrays.size() || operands[1] > updates.size() ||
+        !kid(2, index))
+      return fail("malformed read");
+    const Array *array = arrays[operands[0] - 1];
+    ref<UpdateNode> head = operands[1] ? updates[operands[1] - 1] : nullptr;
+    if (!array || (operands[1] && !head) || !index)
+      complete = false;
+    else
+      result = ReadExpr::create(UpdateList(array, head), index);
+    break;
+  }
+  case Expr::Extract: {
+    ref<Expr> e;
+    if (operands.size() != 2 || !kid(0, e))
+      return fail("malformed extract");
+    if (e)
+      result = ExtractExpr::create(e, operands[1], width);
+    else
+      complete = false;
+    break;
+  }
+  case Expr::Pointer:
+  case Expr::ConstantPointer: {
+    ref<Expr> base, value;
+    if (operands.size() != 2 || !kid(0, base) || !kid(1, value))
+      return fail("malformed pointer");
+    if (base && value)
+      result = PointerExpr::create(base, value);
+    else
+      complete = false;
+    break;
+  }
+  case Expr::FPExt: {
+    ref<Expr> e;
+    if (operands.size() != 1 || !kid(0, e))
+      return fail("malformed cast");
+    if (e)
+      result = FPExtExpr::create(e, width);
+    else
+      complete = false;
+    break;
+  }
+  case Expr::ZExt:
+  case Expr::SExt:
+  case Expr::FPTrunc:
+  case Expr::FPToUI:
+  case Expr::FPToSI:
+  case Expr::UIToFP:
+  case Expr::SIToFP: {
+    ref<Expr> e;
+    bool rounded = kind != Expr::ZExt && kind != Expr::SExt;
+    if (operands.size() != 1u + rounded || !kid(0, e))
+      return fail("malformed cast");
+    args.push_back(e);
+    args.push_back(static_cast<Expr::Width>(width));
+    if (rounded)
+      args.push_back(roundingMode(1));
+    complete = e.get() != nullptr;
+    break;
+  }
+  default: {
+    if (kind == Expr::InvalidKind || kind > Expr::ConstantPointer ||
+        kind == Expr::NotOptimized + 1)
+      return fail("unknown expression kind");
+    llvm::APFloat::roundingMode rm = llvm::APFloat::rmNearestTiesToEven;
+    unsigned kids = operands.size();
+    // The operands of a rounded operation end with its rounding mode
+    switch (kind) {
+    case Expr::FSqrt:
+    case Expr::FRint:
+    case Expr::FAdd:
+    case Expr::FSub:
+    case Expr::FMul:
+    case Expr::FDiv:
+    case Expr::FRem:
+    case Expr::FMax:
+    case Expr::FMin:
+      if (!kids)
+        return fail("malformed rounded expression");
+      --kids;
+      rm = roundingMode(kids);
+      break;
+    default:
+      break;
+    }
+    for (unsigned i = 0; i < kids; ++i) {
+      ref<Expr> e;
+      if (!kid(i, e))
+        return false;
+      complete &= e.get() != nullptr;
+      args.push_back(e);
+    }
+    if (kids != operands.size())
+      args.push_back(rm);
+    break;
+  }
+  }
+
+  if (!result && complete)
+    result = Expr::createFromKind(kind, args);
+  exprs.push_back(result);
+  return true;
+}
+
+bool QueryLogReader::readExprs(std::vector<ref<Expr>> &result,
+                               bool &complete) {
+  uint64_t count;
+  if (!input->getVarint(count))
+    return fail("malformed query record");
+  result.clear();
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t id;
+    if (!input->getVarint(id) || !id || id > exprs.size())
+      return fail("malformed query record");
+    complete &= exprs[id - 1].get() != nullptr;
+    result.push_back(exprs[id - 1]);
+  }
+  return true;
+}
+
+bool QueryLogReader::readQuery(LoggedQuery &query, bool &complete) {
+  uint8_t operation;
+  if (!input->getByte(operation) || operation >= QueryLogOperationCount)
+    return fail("malformed query record");
+  query.operation = static_cast<QueryLogOperation>(operation);
+
+  std::vector<ref<Expr>> constraints;
+  if (!readExprs(constraints, complete))
+    return false;
+  query.constraints = constraints_ty(constraints.begin(), constraints.end());
+
+  uint64_t exprId;
+  if (!input->getVarint(exprId) || !exprId || exprId > exprs.size())
+    return fail("malformed query record");
+  query.expr = exprs[exprId - 1];
+  complete &= query.expr.get() != nullptr;
+
+  if (!readExprs(query.conditions, complete))
+    return false;
+
+  uint64_t count;
+  if (!input->getVarint(count))
+    return fail("malformed query record");
+  query.objects.clear();
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t id;
+    if (!input->getVarint(id) || !id || id > arrays.size())
+      return fail("malformed query record");
+    complete &= arrays[id - 1] != nullptr;
+    query.objects.push_back(arrays[id - 1]);
+  }
+
+  uint64_t flags, status, answer = 0, elapsed;
+  if (!input->getVarint(flags) || !input->getVarint(status) ||
+      ((flags & 2) && !input->getVarint(answer)) ||
+      !input->getVarint(elapsed))
+    return fail("malformed query record");
+  query.outcome.success = flags & 1;
+  query.outcome.hasAnswer = flags & 2;
+  query.outcome.status = static_cast<SolverImpl::SolverRunStatus>(status);
+  query.outcome.answer = unzigzag(answer);
+  query.outcome.elapsed = time::microseconds(elapsed);
+  return true;
+}
+
+bool QueryLogReader::next(LoggedQuery &query) {
+  if (!error.empty())
+    return false;
+
+  while (!input->atEnd()) {
+    uint8_t tag;
+    if (!input->getByte(tag))
+      break;
+    switch (tag) {
+    case ResetRecord:
+      exprs.clear();
+      updates.clear();
+      arrays.clear();
+      break;
+    case ArrayRecord:
+      if (!readArray())
+        return false;
+      break;
+    case ExprRecord:
+      if (!readExpr())
+        return false;
+      break;
+    case UpdateRecord:
+      if (!readUpdate())
+        return false;
+      break;
+    case QueryRecord: {
+      bool complete = true;
+      if (!readQuery(query, complete))
+        return false;
+      if (complete)
+        return true;
+      ++unreadable;
+      break;
+    }
+    default:
+      return fail("unknown record in query log");
+    }
+  }
+  return false;
+}
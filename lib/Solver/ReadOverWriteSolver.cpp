@@ -0,0 +1,576 @@
+//===-- ReadOverWriteSolver.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/Bits.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Expr/ExprVisitor.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Solver/SolverUtil.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// IndexRange - The unsigned values an expression of at most 64 bits can
+/// take. An empty range (min > max) means no value satisfies the bounds.
+struct IndexRange {
+  uint64_t min, max;
+
+  IndexRange(uint64_t min, uint64_t max) : min(min), max(max) {}
+  static IndexRange full(Expr::Width width) {
+    return IndexRange(0, bits64::maxValueOfNBits(width));
+  }
+
+  bool isEmpty() const { return min > max; }
+  bool isFixed() const { return min == max; }
+  bool intersects(const IndexRange &b) const {
+    return min <= b.max && b.min <= max;
+  }
+  IndexRange intersect(const IndexRange &b) const {
+    return IndexRange(std::max(min, b.min), std::min(max, b.max));
+  }
+};
+
+/// ReadOverWritePruner - Rewrites reads so that their update lists keep only
+/// the writes which may alias the read index. A write is dropped when its
+/// index provably differs from the read index, either because the two only
+/// differ by a non-zero constant or because the ranges implied by the known
+/// bounds do not overlap. Writes older than one whose index must equal the
+/// read index are dropped as well, as they can never be read.
+class ReadOverWritePruner : public ExprVisitor {
+  enum class Alias { No, May, Must };
+
+  /// Bounds on (sub)expressions implied by the constraints
+  ExprHashMap<IndexRange> bounds;
+  ExprHashMap<IndexRange> ranges;
+
+  IndexRange computeRange(const ref<Expr> &e);
+  IndexRange getRange(const ref<Expr> &e);
+  Alias alias(const ref<Expr> &a, const ref<Expr> &b);
+  void addBound(const ref<Expr> &e, IndexRange range);
+
+protected:
+  Action visitRead(const ReadExpr &re) override;
+
+public:
+  /// The number of writes dropped so far
+  uint64_t pruned = 0;
+
+  /// Learn the bounds implied by a constraint. Returns whether it implied
+  /// any, in which case the constraint has to be kept as it is: the reads
+  /// rewritten with its bounds are only equivalent under it.
+  bool learn(const ref<Expr> &constraint);
+
+  ref<Expr> prune(const ref<Expr> &e) { return visit(e); }
+};
+
+void ReadOverWritePruner::addBound(const ref<Expr> &e, IndexRange range) {
+  auto it = bounds.find(e);
+  if (it != bounds.end())
+    range = range.intersect(it->second);
+  bounds.insert_or_assign(e, range);
+}
+
+bool ReadOverWritePruner::learn(const ref<Expr> &constraint) {
+  std::vector<ref<Expr>> atoms;
+  Expr::splitAnds(constraint, atoms);
+
+  bool learned = false;
+  for (ref<Expr> atom : atoms) {
+    bool negated = false;
+    if (auto eq = dyn_cast<EqExpr>(atom)) {
+      auto value = dyn_cast<ConstantExpr>(eq->left);
+      if (!value)
+        continue;
+      if (value->getWidth() != Expr::Bool) {
+        if (value->getWidth() <= 64) {
+          uint64_t v = value->getZExtValue();
+          addBound(eq->right, IndexRange(v, v));
+          learned = true;
+        }
+        continue;
+      }
+      if (!value->isFalse())
+        continue;
+      atom = eq->right;
+      negated = true;
+    }
+
+    // Canonical comparisons are Ult and Ule, with the constant on either side
+    if (!isa<UltExpr>(atom) && !isa<UleExpr>(atom))
+      continue;
+    const BinaryExpr *cmp = cast<BinaryExpr>(atom);
+    Expr::Width width = cmp->left->getWidth();
+    if (width > 64)
+      continue;
+    uint64_t max = bits64::maxValueOfNBits(width);
+    bool strict = isa<UltExpr>(atom);
+    // A negated comparison flips both its direction and its strictness
+    if (negated)
+      strict = !strict;
+
+    if (auto c = dyn_cast<ConstantExpr>(cmp->right)) {
+      // e < c, e <= c, or negated: e >= c, e > c
+      uint64_t v = c->getZExtValue();
+      if (!negated) {
+        if (strict && v == 0)
+          continue;
+        addBound(cmp->left, IndexRange(0, strict ? v - 1 : v));
+      } else {
+        if (strict && v == max)
+          continue;
+        addBound(cmp->left, IndexRange(strict ? v + 1 : v, max));
+      }
+      learned = true;
+    } else if (auto c = dyn_cast<ConstantExpr>(cmp->left)) {
+      // c < e, c <= e, or negated: e <= c, e < c
+      uint64_t v = c->getZExtValue();
+      if (!negated) {
+        if (strict && v == max)
+          continue;
+        addBound(cmp->right, IndexRange(strict ? v + 1 : v, max));
+      } else {
+        if (strict && v == 0)
+          continue;
+        addBound(cmp->right, IndexRange(0, strict ? v - 1 : v));
+      }
+      learned = true;
+    }
+  }
+
+  if (learned)
+    ranges.clear();
+  return learned;
+}
+
+IndexRange ReadOverWritePruner::getRange(const ref<Expr> &e) {
+  auto it = ranges.find(e);
+  if (it != ranges.end())
+    return it->second;
+
+  IndexRange range = computeRange(e);
+  auto bound = bounds.find(e);
+  if (bound != bounds.end()) {
+    IndexRange bounded = range.intersect(bound->second);
+    // Contradicting bounds make the query unsatisfiable anyway, in which
+    // case the unbounded range is just as good an answer
+    if (!bounded.isEmpty())
+      range = bounded;
+  }
+  ranges.insert({e, range});
+  return range;
+}
+
+IndexRange ReadOverWritePruner::computeRange(const ref<Expr> &e) {
+  Expr::Width width = e->getWidth();
+  IndexRange full = IndexRange::full(width);
+  uint64_t max = full.max;
+
+  switch (e->getKind()) {
+  case Expr::Constant: {
+    uint64_t v = cast<ConstantExpr>(e)->getZExtValue();
+    return IndexRange(v, v);
+  }
+
+  case Expr::ZExt: {
+    const ref<Expr> &kid = cast<ZExtExpr>(e)->src;
+    if (kid->getWidth() <= 64)
+      return getRange(kid);
+    break;
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    if (ee->offset == 0 && ee->expr->getWidth() <= 64) {
+      IndexRange kid = getRange(ee->expr);
+      if (kid.max <= max)
+        return kid;
+    }
+    break;
+  }
+
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    IndexRange t = getRange(se->trueExpr), f = getRange(se->falseExpr);
+    return IndexRange(std::min(t.min, f.min), std::max(t.max, f.max));
+  }
+
+  case Expr::Add: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    IndexRange l = getRange(be->left), r = getRange(be->right);
+    if (l.max <= max - r.max)
+      return IndexRange(l.min + r.min, l.max + r.max);
+    break;
+  }
+
+  case Expr::Mul: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (auto c = dyn_cast<ConstantExpr>(be->left)) {
+      uint64_t k = c->getZExtValue();
+      IndexRange r = getRange(be->right);
+      if (k == 0 || r.max <= max / k)
+        return IndexRange(r.min * k, r.max * k);
+    }
+    break;
+  }
+
+  case Expr::Shl: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (auto c = dyn_cast<ConstantExpr>(be->right)) {
+      uint64_t s = c->getZExtValue();
+      IndexRange l = getRange(be->left);
+      if (s < width && l.max <= (max >> s))
+        return IndexRange(l.min << s, l.max << s);
+    }
+    break;
+  }
+
+  case Expr::LShr: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (auto c = dyn_cast<ConstantExpr>(be->right)) {
+      uint64_t s = c->getZExtValue();
+      IndexRange l = getRange(be->left);
+      if (s < width)
+        return IndexRange(l.min >> s, l.max >> s);
+    }
+    break;
+  }
+
+  case Expr::UDiv: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (auto c = dyn_cast<ConstantExpr>(be->right)) {
+      uint64_t k = c->getZExtValue();
+      IndexRange l = getRange(be->left);
+      if (k != 0)
+        return IndexRange(l.min / k, l.max / k);
+    }
+    break;
+  }
+
+  case Expr::URem: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (auto c = dyn_cast<ConstantExpr>(be->right)) {
+      uint64_t k = c->getZExtValue();
+      IndexRange l = getRange(be->left);
+      if (k != 0)
+        return l.max < k ? l : IndexRange(0, k - 1);
+    }
+    break;
+  }
+
+  case Expr::And: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    IndexRange l = getRange(be->left), r = getRange(be->right);
+    return IndexRange(0, std::min(l.max, r.max));
+  }
+
+  default:
+    break;
+  }
+
+  return full;
+}
+
+ReadOverWritePruner::Alias ReadOverWritePruner::alias(const ref<Expr> &a,
+                                                      const ref<Expr> &b) {
+  if (a == b)
+    return Alias::Must;
+  if (a->getWidth() != b->getWidth())
+    return Alias::May;
+
+  // Indices which only differ by a constant, e.g. base + 1 and base + 2
+  if (auto diff = dyn_cast<ConstantExpr>(SubExpr::create(a, b)))
+    return diff->isZero() ? Alias::Must : Alias::No;
+
+  if (a->getWidth() > 64)
+    return Alias::May;
+  IndexRange ra = getRange(a), rb = getRange(b);
+  if (!ra.intersects(rb))
+    return Alias::No;
+  if (ra.isFixed() && rb.isFixed())
+    return Alias::Must;
+  return Alias::May;
+}
+
+ExprVisitor::Action ReadOverWritePruner::visitRead(const ReadExpr &re) {
+  ref<Expr> index = visit(re.index);
+
+  std::vector<const UpdateNode *> nodes;
+  for (const UpdateNode *un = re.updates.head.get(); un; un = un->next.get())
+    nodes.push_back(un);
+
+  // The writes to keep, newest first, and how many of the oldest writes
+  // are kept unchanged, so that their nodes can be shared
+  std::vector<std::pair<ref<Expr>, ref<Expr>>> kept;
+  size_t unchangedTail = 0;
+  bool changed = index != re.index;
+  bool truncated = false;
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const UpdateNode *un = nodes[i];
+    ref<Expr> writeIndex = visit(un->index);
+    Alias a = alias(writeIndex, index);
+    if (a == Alias::No) {
+      ++pruned;
+      changed = true;
+      unchangedTail = 0;
+      continue;
+    }
+
+    ref<Expr> value = visit(un->value);
+    if (writeIndex == un->index && value == un->value) {
+      ++unchangedTail;
+    } else {
+      changed = true;
+      unchangedTail = 0;
+    }
+    kept.emplace_back(writeIndex, value);
+
+    if (a == Alias::Must) {
+      // The older writes are overwritten before they could be read
+      pruned += nodes.size() - i - 1;
+      truncated = i + 1 < nodes.size();
+      changed |= truncated;
+      break;
+    }
+  }
+
+  if (!changed)
+    return Action::skipChildren();
+
+  if (truncated)
+    unchangedTail = 0;
+  // Share the unchanged oldest writes, which are the tail of the original
+  // list, and rebuild the newer ones on top of them
+  size_t rebuilt = kept.size() - unchangedTail;
+  ref<UpdateNode> tail;
+  if (unchangedTail == nodes.size())
+    tail = re.updates.head;
+  else if (unchangedTail)
+    tail = nodes[nodes.size() - unchangedTail - 1]->next;
+  UpdateList updates(re.updates.root, tail);
+  for (size_t i = rebuilt; i > 0; --i)
+    updates.extend(kept[i - 1].first, kept[i - 1].second);
+
+  return Action::changeTo(ReadExpr::create(updates, index));
+}
+
+/// PrunedQuery - What a query was pruned to, and how to map the validity
+/// cores of the pruned query back to the original one.
+struct PrunedQuery {
+  Query query;
+  /// The original constraints each rewritten constraint stands for. Several
+  /// originals may be pruned to the same constraint.
+  std::unordered_multimap<ref<Expr>, ref<Expr>, util::ExprHash, util::ExprCmp>
+      originals;
+  /// The constraints which supplied the bounds the rewriting relied on
+  std::vector<ref<Expr>> bounds;
+  ref<Expr> originalExpr;
+
+  PrunedQuery(const Query &query, ref<Expr> originalExpr)
+      : query(query), originalExpr(originalExpr) {}
+};
+
+class ReadOverWriteSolver : public SolverImpl {
+private:
+  std::unique_ptr<Solver> solver;
+
+  /// Prune the reads of a query, and of the given conditions if any.
+  PrunedQuery prune(const Query &query,
+                    std::vector<ref<Expr>> *conditions = nullptr);
+  /// Map a validity core of the pruned query back to the original one. A
+  /// rewritten constraint or expression only holds under the bounds, so a
+  /// core containing one also gets every bound-supplying constraint.
+  void restore(ValidityCore &core, const PrunedQuery &pruned);
+
+public:
+  ReadOverWriteSolver(std::unique_ptr<Solver> solver)
+      : solver(std::move(solver)) {}
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool computeInitialValues(
+      const Query &query, const std::vector<const Array *> &objects,
+      std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+PrunedQuery ReadOverWriteSolver::prune(const Query &query,
+                                       std::vector<ref<Expr>> *conditions) {
+  ReadOverWritePruner pruner;
+  constraints_ty constraints;
+  std::vector<ref<Expr>> bounds, rest;
+  for (const auto &constraint : query.constraints.cs()) {
+    if (pruner.learn(constraint)) {
+      constraints.insert(constraint);
+      bounds.push_back(constraint);
+    } else {
+      rest.push_back(constraint);
+    }
+  }
+
+  bool changed = false;
+  std::vector<std::pair<ref<Expr>, ref<Expr>>> originals;
+  for (const auto &constraint : rest) {
+    ref<Expr> pruned = pruner.prune(constraint);
+    if (pruned != constraint) {
+      changed = true;
+      originals.emplace_back(pruned, constraint);
+    }
+    if (!pruned->isTrue())
+      constraints.insert(pruned);
+  }
+
+  ref<Expr> expr = pruner.prune(query.expr);
+  changed |= expr != query.expr;
+
+  if (conditions) {
+    for (auto &condition : *conditions)
+      condition = pruner.prune(condition);
+  }
+
+  stats::queryPrunedWrites += pruner.pruned;
+  if (!changed)
+    return PrunedQuery(query, query.expr);
+  PrunedQuery result(Query(ConstraintSet(constraints,
+                                         query.constraints.symcretes(),
+                                         query.constraints.concretization()),
+                           expr, query.id),
+                     query.expr);
+  for (const auto &original : originals) {
+    result.originals.insert(original);
+    // A constraint may also be pruned to one the query has already
+    if (query.constraints.cs().count(original.first))
+      result.originals.insert({original.first, original.first});
+  }
+  result.bounds = std::move(bounds);
+  return result;
+}
+
+void ReadOverWriteSolver::restore(ValidityCore &core,
+                                  const PrunedQuery &pruned) {
+  bool rewritten = false;
+  constraints_ty constraints;
+  for (const auto &constraint : core.constraints) {
+    auto range = pruned.originals.equal_range(constraint);
+    if (range.first == range.second) {
+      constraints.insert(constraint);
+      continue;
+    }
+    rewritten = true;
+    for (auto it = range.first; it != range.second; ++it)
+      constraints.insert(it->second);
+  }
+  if (core.expr == pruned.query.expr && core.expr != pruned.originalExpr) {
+    rewritten = true;
+    core.expr = pruned.originalExpr;
+  }
+  if (rewritten)
+    constraints.insert(pruned.bounds.begin(), pruned.bounds.end());
+  core.constraints = constraints;
+}
+
+bool ReadOverWriteSolver::computeTruth(const Query &query, bool &isValid) {
+  return solver->impl->computeTruth(prune(query).query, isValid);
+}
+
+bool ReadOverWriteSolver::computeValidity(const Query &query,
+                                          PartialValidity &result) {
+  return solver->impl->computeValidity(prune(query).query, result);
+}
+
+bool ReadOverWriteSolver::computeValue(const Query &query, ref<Expr> &result) {
+  return solver->impl->computeValue(prune(query).query, result);
+}
+
+bool ReadOverWriteSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  return solver->impl->computeInitialValues(prune(query).query, objects,
+                                            values, hasSolution);
+}
+
+bool ReadOverWriteSolver::check(const Query &query,
+                                ref<SolverResponse> &result) {
+  PrunedQuery pruned = prune(query);
+  if (!solver->impl->check(pruned.query, result))
+    return false;
+
+  ValidityCore core;
+  if (result->tryGetValidityCore(core)) {
+    restore(core, pruned);
+    result = new ValidResponse(core);
+  }
+  return true;
+}
+
+bool ReadOverWriteSolver::computeValidityCore(const Query &query,
+                                              ValidityCore &validityCore,
+                                              bool &isValid) {
+  PrunedQuery pruned = prune(query);
+  if (!solver->impl->computeValidityCore(pruned.query, validityCore, isValid))
+    return false;
+  if (isValid)
+    restore(validityCore, pruned);
+  return true;
+}
+
+bool ReadOverWriteSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  std::vector<ref<Expr>> prunedConditions = conditions;
+  PrunedQuery pruned = prune(query, &prunedConditions);
+  return solver->impl->computeFeasibility(pruned.query, prunedConditions,
+                                          feasible);
+}
+
+SolverImpl::SolverRunStatus ReadOverWriteSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *ReadOverWriteSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void ReadOverWriteSolver::setCoreSolverTimeout(time::Span timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void ReadOverWriteSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+} // namespace
+
+std::unique_ptr<Solver>
+klee::createReadOverWriteSolver(std::unique_ptr<Solver> s) {
+  return std::make_unique<Solver>(
+      std::make_unique<ReadOverWriteSolver>(std::move(s)));
+}
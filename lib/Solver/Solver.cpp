@@ -17,6 +17,7 @@
 #include "klee/Solver/SolverUtil.h"
 
 #include <utility>
+#include <vector>
 
 using namespace klee;
 
@@ -79,6 +80,35 @@ bool Solver::mayBeTrue(const Query &query, bool &result) {
   return true;
 }
 
+bool Solver::mayBeTrue(const Query &query,
+                       const std::vector<ref<Expr>> &conditions,
+                       std::vector<bool> &result) {
+  result.assign(conditions.size(), false);
+
+  // Maintain invariants implementations expect.
+  std::vector<ref<Expr>> symbolic;
+  std::vector<unsigned> positions;
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    assert(conditions[i]->getWidth() == Expr::Bool &&
+           "Invalid expression type!");
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(conditions[i])) {
+      result[i] = CE->isTrue();
+    } else {
+      symbolic.push_back(conditions[i]);
+      positions.push_back(i);
+    }
+  }
+  if (symbolic.empty())
+    return true;
+
+  std::vector<bool> feasible;
+  if (!impl->computeFeasibility(query, symbolic, feasible))
+    return false;
+  for (unsigned i = 0; i < positions.size(); ++i)
+    result[positions[i]] = feasible[i];
+  return true;
+}
+
 bool Solver::mayBeFalse(const Query &query, bool &result) {
   bool res;
   if (!mustBeTrue(query, res))
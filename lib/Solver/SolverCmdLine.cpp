@@ -52,6 +52,19 @@ cl::opt<bool> UseBranchCache("use-branch-cache", cl::init(true),
                              cl::desc("Use the branch cache (default=true)"),
                              cl::cat(SolvingCat));
 
+cl::opt<bool> UseConflictCache(
+    "use-conflict-cache", cl::init(false),
+    cl::desc("Remember the validity cores of valid queries and answer every "
+             "query containing one of them without the solver "
+             "(default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> ConflictCacheSize(
+    "conflict-cache-size",
+    cl::desc("Keep at most N conflicts in the conflict cache, dropping the "
+             "least recently used ones (default=16384)"),
+    cl::init(1 << 14), cl::cat(SolvingCat));
+
 cl::opt<bool>
     UseAlphaEquivalence("use-alpha-equivalence", cl::init(true),
                         cl::desc("Use the alpha version builder(default=true)"),
@@ -67,6 +80,12 @@ cl::opt<bool>
                          cl::desc("Use constraint independence (default=true)"),
                          cl::cat(SolvingCat));
 
+cl::opt<unsigned> IndependentFactorCacheSize(
+    "independent-factor-cache-size",
+    cl::desc("Keep the models of at most N independent factors, dropping the "
+             "least recently used ones (default=16384)"),
+    cl::init(1 << 14), cl::cat(SolvingCat));
+
 cl::opt<bool> DebugValidateSolver(
     "debug-validate-solver", cl::init(false),
     cl::desc("Crosscheck the results of the solver chain above the core solver "
@@ -96,6 +115,63 @@ cl::opt<bool> UseForkedCoreSolver(
     cl::desc("Run the core SMT solver in a forked process (default=true)"),
     cl::init(true), cl::cat(SolvingCat));
 
+cl::list<CoreSolverType> SolverPortfolio(
+    "solver-portfolio",
+    cl::desc("Race the given core solvers along with --solver-backend on "
+             "every query, each in a forked process, and take the first "
+             "answer (comma-separated)"),
+    cl::values(clEnumValN(BITWUZLA_SOLVER, "bitwuzla", "Bitwuzla"),
+               clEnumValN(STP_SOLVER, "stp", "STP"),
+               clEnumValN(METASMT_SOLVER, "metasmt", "metaSMT"),
+               clEnumValN(Z3_SOLVER, "z3", "Z3")),
+    cl::CommaSeparated, cl::cat(SolvingCat));
+
+cl::opt<std::string> QueryCacheFile(
+    "query-cache-file",
+    cl::desc("Cache answers of the core solver in the given file and reuse "
+             "them in later or concurrent runs (default=off)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> PredictSolverTimeout(
+    "predict-solver-timeout",
+    cl::desc("Give up on a query once it took several times longer than "
+             "any earlier query of its shape, instead of only after "
+             "--max-solver-time (default=false)"),
+    cl::init(false), cl::cat(SolvingCat));
+
+cl::opt<std::string> SolverTimingLog(
+    "solver-timing-log",
+    cl::desc("Log the features, solve time and status of every query to "
+             "the given CSV file, and predict timeouts from the timings "
+             "already in it (default=off)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> PruneReadOverWrite(
+    "prune-read-over-write",
+    cl::desc("Drop from the update lists of array reads the writes which "
+             "cannot alias the read index, using the index ranges implied by "
+             "the constraints, before passing queries to the core solver "
+             "(default=false)"),
+    cl::init(false), cl::cat(SolvingCat));
+
+cl::opt<bool> TraceSolverChain(
+    "trace-solver-chain",
+    cl::desc("Record when each layer of the solver chain is entered and "
+             "left, and whether it answered the query itself, in "
+             "solver-trace.json (Chrome trace format) (default=false)"),
+    cl::init(false), cl::cat(SolvingCat));
+
+cl::opt<unsigned> SolverTraceEvents(
+    "solver-trace-events",
+    cl::desc("Keep only the latest N events of the solver trace "
+             "(default=262144)"),
+    cl::init(1 << 18), cl::cat(SolvingCat));
+
+cl::opt<unsigned> SolverTraceSampleRate(
+    "solver-trace-sample-rate",
+    cl::desc("Trace only one of every N queries (default=1)"),
+    cl::init(1), cl::cat(SolvingCat));
+
 cl::opt<bool> CoreSolverOptimizeDivides(
     "solver-optimize-divides",
     cl::desc("Optimize constant divides into add/shift/multiplies before "
@@ -111,12 +187,18 @@ cl::bits<QueryLoggingSolverType> QueryLoggingOptions(
                    "All queries in .kquery (KQuery) format"),
         clEnumValN(ALL_SMTLIB, "all:smt2",
                    "All queries in .smt2 (SMT-LIBv2) format"),
+        clEnumValN(ALL_BINARY, "all:binary",
+                   "All queries in the compact binary format replayed by "
+                   "kleaver -replay-query-log"),
         clEnumValN(
             SOLVER_KQUERY, "solver:kquery",
             "All queries reaching the solver in .kquery (KQuery) format"),
         clEnumValN(
             SOLVER_SMTLIB, "solver:smt2",
-            "All queries reaching the solver in .smt2 (SMT-LIBv2) format")),
+            "All queries reaching the solver in .smt2 (SMT-LIBv2) format"),
+        clEnumValN(SOLVER_BINARY, "solver:binary",
+                   "All queries reaching the solver in the compact binary "
+                   "format")),
     cl::CommaSeparated, cl::cat(SolvingCat));
 
 cl::opt<bool> UseAssignmentValidatingSolver(
@@ -93,6 +93,20 @@ bool SolverImpl::computeValidityCore(const Query &query,
   return true;
 }
 
+bool SolverImpl::computeFeasibility(const Query &query,
+                                    const std::vector<ref<Expr>> &conditions,
+                                    std::vector<bool> &feasible) {
+  feasible.resize(conditions.size());
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    bool mustBeFalse;
+    if (!computeTruth(query.withExpr(Expr::createIsZero(conditions[i])),
+                      mustBeFalse))
+      return false;
+    feasible[i] = !mustBeFalse;
+  }
+  return true;
+}
+
 bool SolverImpl::computeMinimalUnsignedValue(const Query &query,
                                              ref<ConstantExpr> &result) {
   bool mustBeTrue;
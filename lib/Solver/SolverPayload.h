@@ -0,0 +1,145 @@
+//===-- SolverPayload.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERPAYLOAD_H
+#define KLEE_SOLVERPAYLOAD_H
+
+#include "klee/ADT/SparseStorage.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/SolverUtil.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace klee {
+
+/// SolverPayload - A flat binary encoding of solver answers (truth values,
+/// validities, validity cores and assignments), used to move them between
+/// processes and to store them on disk.
+class SolverPayload {
+  std::string buffer;
+  size_t position = 0;
+
+public:
+  SolverPayload() = default;
+  explicit SolverPayload(std::string data) : buffer(std::move(data)) {}
+
+  std::string &data() { return buffer; }
+  const std::string &data() const { return buffer; }
+
+  template <typename T> void put(const T &value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> bool get(T &value) {
+    if (position + sizeof(T) > buffer.size())
+      return false;
+    std::memcpy(&value, buffer.data() + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+  }
+
+  void putString(const std::string &value) {
+    put<uint64_t>(value.size());
+    buffer.append(value);
+  }
+
+  bool getString(std::string &value) {
+    uint64_t size;
+    if (!get(size) || size > buffer.size() - position)
+      return false;
+    value.assign(buffer, position, size);
+    position += size;
+    return true;
+  }
+
+  void putValues(const std::vector<SparseStorageImpl<unsigned char>> &values) {
+    put<uint64_t>(values.size());
+    for (const auto &value : values) {
+      put<unsigned char>(value.defaultV());
+      put<uint64_t>(value.storage().size());
+      for (const auto &element : value.storage()) {
+        put<uint64_t>(element.first);
+        put<unsigned char>(element.second);
+      }
+    }
+  }
+
+  bool getValues(std::vector<SparseStorageImpl<unsigned char>> &values) {
+    uint64_t count;
+    // Every value and element takes at least nine bytes, larger counts only
+    // come from corrupt payloads
+    if (!get(count) || count > (buffer.size() - position) / 9)
+      return false;
+    values.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+      unsigned char defaultValue;
+      uint64_t elements;
+      if (!get(defaultValue) || !get(elements) ||
+          elements > (buffer.size() - position) / 9)
+        return false;
+      values.emplace_back(defaultValue);
+      for (uint64_t j = 0; j < elements; ++j) {
+        uint64_t index;
+        unsigned char byte;
+        if (!get(index) || !get(byte))
+          return false;
+        values.back().store(index, byte);
+      }
+    }
+    return true;
+  }
+
+  /// Encode the constraints of `core` by their positions in `constraints`,
+  /// which the decoding side must know as well. Fails if the core contains
+  /// a constraint which is not among them.
+  bool putCore(const constraints_ty &constraints, const ValidityCore &core) {
+    std::vector<uint64_t> positions;
+    uint64_t position = 0;
+    for (const auto &constraint : constraints) {
+      if (core.constraints.count(constraint))
+        positions.push_back(position);
+      ++position;
+    }
+    if (positions.size() != core.constraints.size())
+      return false;
+    put<uint64_t>(positions.size());
+    for (uint64_t position : positions)
+      put<uint64_t>(position);
+    return true;
+  }
+
+  /// Decode a core encoded by putCore() for the same constraints. The core
+  /// is stated for `expr`, the expression of the query it was computed for.
+  bool getCore(const constraints_ty &constraints, ref<Expr> expr,
+               ValidityCore &core) {
+    uint64_t count;
+    if (!get(count) || count > constraints.size())
+      return false;
+    core = ValidityCore(ValidityCore::constraints_typ(), expr);
+    auto it = constraints.begin();
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+      uint64_t position;
+      if (!get(position) || position < next || position >= constraints.size())
+        return false;
+      std::advance(it, position - next);
+      core.constraints.insert(*it);
+      next = position;
+    }
+    return true;
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_SOLVERPAYLOAD_H */
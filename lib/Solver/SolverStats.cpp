@@ -20,12 +20,28 @@ Statistic stats::queryCacheHits("QueryCacheHits", "QChits");
 Statistic stats::queryCacheMisses("QueryCacheMisses", "QCmisses");
 Statistic stats::queryCexCacheHits("QueryCexCacheHits", "QCexHits");
 Statistic stats::queryCexCacheMisses("QueryCexCacheMisses", "QCexMisses");
+Statistic stats::queryPersistentCacheHits("QueryPersistentCacheHits",
+                                          "QPChits");
+Statistic stats::queryPersistentCacheMisses("QueryPersistentCacheMisses",
+                                            "QPCmisses");
+Statistic stats::queryFactorCacheHits("QueryFactorCacheHits", "QFChits");
+Statistic stats::queryFactorCacheMisses("QueryFactorCacheMisses",
+                                        "QFCmisses");
+Statistic stats::queryConflictCacheHits("QueryConflictCacheHits", "QCChits");
+Statistic stats::queryConflictCacheMisses("QueryConflictCacheMisses",
+                                          "QCCmisses");
+Statistic stats::queryPredictedTimeouts("QueryPredictedTimeouts", "QPTimeouts");
 Statistic stats::queryConstructs("QueryConstructs", "QB");
 Statistic stats::queryCounterexamples("QueriesCEX", "Qcex");
 Statistic stats::validQueriesSize("ValidQueriesSize", "VQsize");
 Statistic stats::validityCoresSize("ValidityCoresSize", "VCsize");
 Statistic stats::queryValidityCores("QueryValidityCores", "QVcores");
 Statistic stats::queryTime("QueryTime", "Qtime");
+Statistic stats::queryTranslationTime("QueryTranslationTime", "QTtime");
+Statistic stats::querySolveTime("QuerySolveTime", "QStime");
+Statistic stats::queryTermCacheHits("QueryTermCacheHits", "QTChits");
+Statistic stats::queryPrunedWrites("QueryPrunedWrites", "QPwrites");
+Statistic stats::queryReusedSolvers("QueryReusedSolvers", "QRsolvers");
 
 #ifdef KLEE_ARRAY_DEBUG
 Statistic stats::arrayHashTime("ArrayHashTime", "AHtime");
@@ -0,0 +1,124 @@
+//===-- SolverTracer.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERTRACER_H
+#define KLEE_SOLVERTRACER_H
+
+#include "SolverPayload.h"
+
+#include "klee/System/Time.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace klee {
+
+struct Query;
+
+/// SolverTracer - Records when every traced layer of the solver chain was
+/// entered and left by a sample of the queries, and whether the layer
+/// answered them itself. Only the latest events are kept, in a ring buffer,
+/// which is written as a Chrome trace (also read by Perfetto) now and then
+/// and once the chain is destroyed.
+///
+/// Layers below a forked solver worker record their events in the worker.
+/// The worker sends them back along with its answer (see exportEvents and
+/// importEvents), so they are kept as the events of the worker's process.
+class SolverTracer {
+public:
+  struct Event {
+    const char *layer;
+    const char *operation;
+    std::uint64_t start;
+    std::uint64_t duration;
+    std::uint64_t translation;
+    std::uint64_t solving;
+    std::uint32_t constraints;
+    /// The traced layer instance which recorded the event
+    unsigned instance;
+    /// The process which recorded the event
+    pid_t pid;
+    /// Whether the layer answered without calling any traced layer below
+    bool answered;
+    bool success;
+  };
+
+  /// Span - A call of one traced layer, recorded when it ends
+  class Span {
+    SolverTracer &tracer;
+    const char *layer;
+    const char *operation;
+    unsigned instance;
+    std::uint32_t constraints;
+    bool traced;
+    time::Point start;
+    std::uint64_t eventsBefore = 0;
+    std::uint64_t translationBefore = 0;
+    std::uint64_t solvingBefore = 0;
+
+  public:
+    bool success = false;
+
+    Span(SolverTracer &tracer, const char *layer, unsigned instance,
+         const char *operation, const Query &query);
+    ~Span();
+  };
+
+private:
+  std::string path;
+  std::vector<Event> events;
+  std::size_t capacity;
+  /// The number of events recorded so far, the next one going to
+  /// `events[recorded % capacity]`
+  std::uint64_t recorded = 0;
+  unsigned sampleRate;
+  std::uint64_t queries = 0;
+  unsigned depth = 0;
+  bool sampling = false;
+  time::Point origin;
+  /// The process which writes the trace
+  pid_t owner;
+  time::Point lastWrite;
+  unsigned instances = 0;
+  /// The names of the layers and operations received from workers
+  std::set<std::string> names;
+
+  void record(const Event &event);
+  void write(llvm::raw_ostream &os) const;
+  /// Write the trace to `path`, replacing the previous one at once
+  void writeTrace();
+  const char *intern(const std::string &name) {
+    return names.insert(name).first->c_str();
+  }
+
+public:
+  SolverTracer(std::string path, unsigned capacity, unsigned sampleRate);
+  ~SolverTracer();
+
+  /// A new identifier for a traced layer instance
+  unsigned addInstance() { return ++instances; }
+
+  /// The number of events recorded so far by every tracer of the process,
+  /// taken by a solver worker before it starts its job
+  static std::vector<std::uint64_t> mark();
+  /// Append the events recorded since `marks` to the answer of a worker
+  static void exportEvents(const std::vector<std::uint64_t> &marks,
+                           SolverPayload &payload);
+  /// Record the events a worker appended to its answer
+  static void importEvents(SolverPayload &payload);
+};
+
+} // namespace klee
+
+#endif /* KLEE_SOLVERTRACER_H */
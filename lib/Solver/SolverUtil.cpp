@@ -49,6 +49,32 @@ PartialValidity toPartial(Validity v) {
   }
 }
 
+PartialValidity toPartial(const ref<SolverResponse> &queryResult,
+                          const ref<SolverResponse> &negatedQueryResult) {
+  if (isa<ValidResponse>(queryResult) &&
+      isa<InvalidResponse>(negatedQueryResult)) {
+    return PValidity::MustBeTrue;
+  } else if (isa<InvalidResponse>(queryResult) &&
+             isa<ValidResponse>(negatedQueryResult)) {
+    return PValidity::MustBeFalse;
+  } else if (isa<InvalidResponse>(queryResult) &&
+             isa<InvalidResponse>(negatedQueryResult)) {
+    return PValidity::TrueOrFalse;
+  } else if (isa<InvalidResponse>(queryResult) &&
+             isa<UnknownResponse>(negatedQueryResult)) {
+    return PValidity::MayBeFalse;
+  } else if (isa<UnknownResponse>(queryResult) &&
+             isa<InvalidResponse>(negatedQueryResult)) {
+    return PValidity::MayBeTrue;
+  } else if (isa<UnknownResponse>(queryResult) &&
+             isa<UnknownResponse>(negatedQueryResult)) {
+    return PValidity::None;
+  } else {
+    assert(0 && "unreachable");
+    return PValidity::None;
+  }
+}
+
 PartialValidity negatePartialValidity(PartialValidity pv) {
   switch (pv) {
   case PValidity::MustBeTrue:
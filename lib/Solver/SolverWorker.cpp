@@ -0,0 +1,175 @@
+//===-- SolverWorker.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverWorker.h"
+
+#include "SolverTracer.h"
+
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/OptionCategories.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Errno.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+llvm::cl::opt<unsigned> SolverWorkerMemoryLimit(
+    "solver-worker-memory-limit",
+    llvm::cl::desc("Maximum address space (in MB) of a single forked solver "
+                   "worker process, see --solver-portfolio (default=0 "
+                   "(off))"),
+    llvm::cl::init(0), llvm::cl::cat(klee::SolvingCat));
+
+/// Exit codes of a solver worker process
+enum WorkerExitCode {
+  WORKER_SUCCESS = 0,
+  WORKER_FAILURE = 1,
+  WORKER_TIMEOUT = 52
+};
+
+void workerTimeoutHandler(int) { _exit(WORKER_TIMEOUT); }
+} // namespace
+
+bool SolverWorker::spawn(const std::function<bool(SolverPayload &)> &job,
+                         time::Span timeout) {
+  int fds[2];
+  if (pipe(fds) == -1) {
+    klee_warning("pipe failed (for solver worker) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    return false;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+
+  pid = fork();
+  // - error
+  if (pid == -1) {
+    klee_warning("fork failed (for solver worker) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  // - child (solver)
+  if (pid == 0) {
+    close(fds[0]);
+    if (SolverWorkerMemoryLimit) {
+      struct rlimit limit;
+      limit.rlim_cur = limit.rlim_max =
+          static_cast<rlim_t>(SolverWorkerMemoryLimit) << 20;
+      setrlimit(RLIMIT_AS, &limit);
+    }
+    if (timeout) {
+      ::alarm(0); /* Turn off alarm so we can safely set signal handler */
+      ::signal(SIGALRM, workerTimeoutHandler);
+      ::alarm(std::max(1u, static_cast<unsigned>(timeout.toSeconds())));
+    }
+    std::vector<std::uint64_t> marks = SolverTracer::mark();
+    SolverPayload answer;
+    if (!job(answer))
+      _exit(WORKER_FAILURE);
+    // The answer is followed by the spans traced while computing it
+    SolverPayload payload;
+    payload.putString(answer.data());
+    SolverTracer::exportEvents(marks, payload);
+    const char *data = payload.data().data();
+    size_t left = payload.data().size();
+    while (left) {
+      ssize_t written = write(fds[1], data, left);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        _exit(WORKER_FAILURE);
+      data += written;
+      left -= written;
+    }
+    _exit(WORKER_SUCCESS);
+  }
+  // - parent
+  close(fds[1]);
+  fd = fds[0];
+  return true;
+}
+
+SolverImpl::SolverRunStatus SolverWorker::collect(SolverPayload &payload) {
+  SolverPayload received;
+  char chunk[4096];
+  ssize_t size;
+  while ((size = read(fd, chunk, sizeof(chunk))) != 0) {
+    if (size < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    received.data().append(chunk, size);
+  }
+  close(fd);
+  fd = -1;
+
+  int status;
+  pid_t res;
+  do {
+    res = waitpid(pid, &status, 0);
+  } while (res < 0 && errno == EINTR);
+  pid = -1;
+
+  if (res < 0) {
+    klee_warning("waitpid() for solver worker failed");
+    return SolverImpl::SOLVER_RUN_STATUS_WAITPID_FAILED;
+  }
+
+  // A worker killed by a signal most likely ran out of the memory granted
+  // by --solver-worker-memory-limit.
+  if (WIFSIGNALED(status) || !WIFEXITED(status)) {
+    klee_warning("solver worker did not return successfully");
+    return SolverImpl::SOLVER_RUN_STATUS_INTERRUPTED;
+  }
+
+  switch (WEXITSTATUS(status)) {
+  case WORKER_SUCCESS:
+    if (!received.getString(payload.data()))
+      return SolverImpl::SOLVER_RUN_STATUS_FAILURE;
+    SolverTracer::importEvents(received);
+    return SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  case WORKER_FAILURE:
+    return SolverImpl::SOLVER_RUN_STATUS_FAILURE;
+  case WORKER_TIMEOUT:
+    klee_warning("solver worker timed out");
+    return SolverImpl::SOLVER_RUN_STATUS_TIMEOUT;
+  default:
+    klee_warning("solver worker did not return a recognized code");
+    return SolverImpl::SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+  }
+}
+
+void SolverWorker::kill() {
+  if (fd != -1) {
+    close(fd);
+    fd = -1;
+  }
+  if (pid > 0) {
+    ::kill(pid, SIGKILL);
+    pid_t res;
+    do {
+      res = waitpid(pid, nullptr, 0);
+    } while (res < 0 && errno == EINTR);
+    pid = -1;
+  }
+}
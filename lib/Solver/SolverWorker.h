@@ -0,0 +1,58 @@
+//===-- SolverWorker.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERWORKER_H
+#define KLEE_SOLVERWORKER_H
+
+#include "SolverPayload.h"
+
+#include "klee/Solver/SolverImpl.h"
+#include "klee/System/Time.h"
+
+#include <functional>
+#include <sys/types.h>
+
+namespace klee {
+
+/// SolverWorker - A forked process answering a single query.
+class SolverWorker {
+  pid_t pid = -1;
+  int fd = -1;
+
+public:
+  SolverWorker() = default;
+  SolverWorker(const SolverWorker &) = delete;
+  SolverWorker &operator=(const SolverWorker &) = delete;
+  SolverWorker(SolverWorker &&other) : pid(other.pid), fd(other.fd) {
+    other.pid = -1;
+    other.fd = -1;
+  }
+  ~SolverWorker() { kill(); }
+
+  /// Fork a process which runs `job` and sends back the payload it produced,
+  /// along with the solver calls traced meanwhile.
+  /// The process gives up once `timeout` (if any) has elapsed.
+  ///
+  /// \return False iff the process could not be started.
+  bool spawn(const std::function<bool(SolverPayload &)> &job,
+             time::Span timeout);
+
+  /// Wait for the process to finish and receive its payload.
+  SolverImpl::SolverRunStatus collect(SolverPayload &payload);
+
+  /// Terminate the process without waiting for its answer.
+  void kill();
+
+  /// The descriptor which becomes readable once the process answers.
+  int descriptor() const { return fd; }
+};
+
+} // namespace klee
+
+#endif /* KLEE_SOLVERWORKER_H */
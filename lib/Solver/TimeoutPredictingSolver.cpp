@@ -0,0 +1,364 @@
+//===-- TimeoutPredictingSolver.cpp ---------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryFeatures.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+#include "klee/System/Time.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+/// Queries of a shape which must have been solved before the timeout for
+/// that shape is predicted
+const uint64_t WarmupSamples = 16;
+
+/// The predicted timeout is this many times the longest time any query of
+/// the same shape took to solve
+const unsigned SafetyFactor = 4;
+
+/// The first line of a timing log, changed whenever the meaning of its
+/// columns changes
+const char TimingLogVersion[] = "# klee solver timing log, version 2";
+
+/// Names of the run statuses in the status column, indexed by status
+const char *const StatusNames[] = {
+    "solvable",    "unsolvable",  "failure",         "timeout",
+    "fork_failed", "interrupted", "unexpected_exit", "waitpid_failed"};
+static_assert(std::size(StatusNames) ==
+                  SolverImpl::SOLVER_RUN_STATUS_WAITPID_FAILED + 1,
+              "every run status needs a name");
+
+/// Solve times of the queries of one shape.
+struct ShapeTimes {
+  uint64_t solved = 0;
+  time::Span slowest;
+};
+
+/// The two lines every timing log starts with.
+std::string timingLogHeader() {
+  std::string header;
+  llvm::raw_string_ostream os(header);
+  os << TimingLogVersion << '\n';
+  QueryFeatures::printHeader(os);
+  os << ",time_us,status\n";
+  return os.str();
+}
+
+bool parseStatus(llvm::StringRef name, unsigned &status) {
+  for (status = 0; status < std::size(StatusNames); ++status)
+    if (name == StatusNames[status])
+      return true;
+  return false;
+}
+} // namespace
+
+/// TimeoutPredictingSolver - Gives every query a timeout predicted from the
+/// solve times of earlier queries of the same shape, so that a query far
+/// harder than its peers is given up long before the global timeout.
+class TimeoutPredictingSolver : public SolverImpl {
+private:
+  std::unique_ptr<Solver> solver;
+  std::unordered_map<uint64_t, ShapeTimes> shapes;
+  /// Whether to shorten timeouts, or only to log the timings
+  bool predictTimeouts;
+  /// The timeout requested by the client, which no prediction exceeds
+  time::Span timeout;
+  /// The timing log, shared with concurrent runs: every row is appended with
+  /// a single write() under an exclusive flock()
+  int timingLog = -1;
+
+  time::Span predict(const ShapeTimes &times) const;
+  void record(ShapeTimes &times, time::Span elapsed, SolverRunStatus status);
+
+  /// Open the timing log at `path`, writing its header if it is new.
+  /// Returns false only if the file exists but is not a timing log of this
+  /// version.
+  bool openTimingLog(const std::string &path);
+
+  /// Read the timings logged by earlier runs.
+  void loadTimingLog(const std::string &path);
+
+  /// Run `solve` under the timeout predicted for `query` and learn from how
+  /// long it took.
+  bool run(const Query &query, const std::function<bool()> &solve);
+
+public:
+  TimeoutPredictingSolver(std::unique_ptr<Solver> solver,
+                          bool predictTimeouts,
+                          const std::string &timingLogPath);
+  ~TimeoutPredictingSolver() {
+    if (timingLog != -1)
+      close(timingLog);
+  }
+
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool
+  computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+TimeoutPredictingSolver::TimeoutPredictingSolver(
+    std::unique_ptr<Solver> solver, bool predictTimeouts,
+    const std::string &timingLogPath)
+    : solver(std::move(solver)), predictTimeouts(predictTimeouts) {
+  if (timingLogPath.empty())
+    return;
+
+  if (!openTimingLog(timingLogPath)) {
+    klee_warning("solver timing log %s was written by another version or is "
+                 "not a timing log, not using it",
+                 timingLogPath.c_str());
+    return;
+  }
+  loadTimingLog(timingLogPath);
+}
+
+bool TimeoutPredictingSolver::openTimingLog(const std::string &path) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd == -1) {
+    klee_warning("cannot open solver timing log %s - %s", path.c_str(),
+                 llvm::sys::StrError(errno).c_str());
+    return true;
+  }
+
+  // The first process to open a new log writes its header
+  std::string header = timingLogHeader();
+  flock(fd, LOCK_EX);
+  struct stat st;
+  bool valid = fstat(fd, &st) == 0;
+  if (valid && st.st_size == 0) {
+    valid = klee_write_fully(fd, header);
+  } else if (valid) {
+    std::string existing(header.size(), '\0');
+    valid = pread(fd, &existing[0], existing.size(), 0) ==
+                static_cast<ssize_t>(existing.size()) &&
+            existing == header;
+  }
+  flock(fd, LOCK_UN);
+
+  if (!valid) {
+    close(fd);
+    return false;
+  }
+  timingLog = fd;
+  return true;
+}
+
+void TimeoutPredictingSolver::loadTimingLog(const std::string &path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer)
+    return;
+
+  uint64_t samples = 0;
+  // Skip the version and the line naming the columns
+  llvm::StringRef rest = (*buffer)->getBuffer();
+  rest = rest.split('\n').second.split('\n').second;
+  while (!rest.empty()) {
+    llvm::StringRef line;
+    std::tie(line, rest) = rest.split('\n');
+    llvm::SmallVector<llvm::StringRef, 64> columns;
+    line.split(columns, ',');
+    uint64_t shape, elapsed;
+    unsigned status;
+    if (columns.size() < 3 || columns.front().getAsInteger(10, shape) ||
+        columns[columns.size() - 2].getAsInteger(10, elapsed) ||
+        !parseStatus(columns.back(), status))
+      continue;
+    record(shapes[shape], time::microseconds(elapsed),
+           static_cast<SolverRunStatus>(status));
+    ++samples;
+  }
+  klee_message("Read %lu solver timings from %s", samples, path.c_str());
+}
+
+time::Span TimeoutPredictingSolver::predict(const ShapeTimes &times) const {
+  // Without a global timeout there is nothing to shorten
+  if (!predictTimeouts || !timeout || times.solved < WarmupSamples)
+    return timeout;
+  time::Span predicted = times.slowest * SafetyFactor;
+  if (predicted < time::milliseconds(100))
+    predicted = time::milliseconds(100);
+  return predicted < timeout ? predicted : timeout;
+}
+
+void TimeoutPredictingSolver::record(ShapeTimes &times, time::Span elapsed,
+                                     SolverRunStatus status) {
+  switch (status) {
+  case SOLVER_RUN_STATUS_SUCCESS_SOLVABLE:
+  case SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE:
+    ++times.solved;
+    if (elapsed > times.slowest)
+      times.slowest = elapsed;
+    break;
+  case SOLVER_RUN_STATUS_TIMEOUT:
+    // The query may well have been solvable in the time it was allowed, so
+    // allow the next ones of its shape more
+    if (elapsed > times.slowest)
+      times.slowest = elapsed;
+    break;
+  default:
+    break;
+  }
+}
+
+bool TimeoutPredictingSolver::run(const Query &query,
+                                  const std::function<bool()> &solve) {
+  QueryFeatures features(query);
+  ShapeTimes &times = shapes[features.shape()];
+  time::Span predicted = predict(times);
+  bool shortened = predicted < timeout;
+  if (shortened)
+    solver->impl->setCoreSolverTimeout(predicted);
+
+  time::Point start = time::getWallTime();
+  bool success = solve();
+  time::Span elapsed = time::getWallTime() - start;
+
+  if (shortened)
+    solver->impl->setCoreSolverTimeout(timeout);
+
+  SolverRunStatus status = solver->impl->getOperationStatusCode();
+  if (status == SOLVER_RUN_STATUS_TIMEOUT && shortened)
+    ++stats::queryPredictedTimeouts;
+  record(times, elapsed, status);
+
+  if (timingLog != -1) {
+    std::string row;
+    llvm::raw_string_ostream os(row);
+    features.print(os);
+    os << ',' << elapsed.toMicroseconds() << ','
+       << (static_cast<size_t>(status) < std::size(StatusNames)
+               ? StatusNames[status]
+               : "unknown")
+       << '\n';
+    flock(timingLog, LOCK_EX);
+    klee_write_fully(timingLog, os.str());
+    flock(timingLog, LOCK_UN);
+  }
+  return success;
+}
+
+bool TimeoutPredictingSolver::computeValidity(const Query &query,
+                                              PartialValidity &result) {
+  return run(query, [&]() {
+    return solver->impl->computeValidity(query, result);
+  });
+}
+
+bool TimeoutPredictingSolver::computeTruth(const Query &query,
+                                           bool &isValid) {
+  return run(query,
+             [&]() { return solver->impl->computeTruth(query, isValid); });
+}
+
+bool TimeoutPredictingSolver::computeValue(const Query &query,
+                                           ref<Expr> &result) {
+  return run(query,
+             [&]() { return solver->impl->computeValue(query, result); });
+}
+
+bool TimeoutPredictingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  return run(query, [&]() {
+    return solver->impl->computeInitialValues(query, objects, values,
+                                              hasSolution);
+  });
+}
+
+bool TimeoutPredictingSolver::check(const Query &query,
+                                    ref<SolverResponse> &result) {
+  return run(query, [&]() { return solver->impl->check(query, result); });
+}
+
+bool TimeoutPredictingSolver::computeValidityCore(const Query &query,
+                                                  ValidityCore &validityCore,
+                                                  bool &isValid) {
+  return run(query, [&]() {
+    return solver->impl->computeValidityCore(query, validityCore, isValid);
+  });
+}
+
+bool TimeoutPredictingSolver::computeFeasibility(
+    const Query &query, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible) {
+  // The conditions are timed as a whole, by the features of the query
+  // asking whether any of them holds
+  ref<Expr> anyCondition = Expr::createFalse();
+  for (const auto &condition : conditions)
+    anyCondition = OrExpr::create(anyCondition, condition);
+  return run(query.withExpr(anyCondition), [&]() {
+    return solver->impl->computeFeasibility(query, conditions, feasible);
+  });
+}
+
+SolverImpl::SolverRunStatus TimeoutPredictingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *TimeoutPredictingSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void TimeoutPredictingSolver::setCoreSolverTimeout(time::Span timeout) {
+  this->timeout = timeout;
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void TimeoutPredictingSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+std::unique_ptr<Solver>
+klee::createTimeoutPredictingSolver(std::unique_ptr<Solver> s,
+                                    bool predictTimeouts,
+                                    const std::string &timingLogPath) {
+  return std::make_unique<Solver>(std::make_unique<TimeoutPredictingSolver>(
+      std::move(s), predictTimeouts, timingLogPath));
+}
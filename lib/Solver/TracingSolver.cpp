@@ -0,0 +1,337 @@
+//===-- TracingSolver.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverTracer.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+#include "klee/System/Time.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+/// How often the trace is written while the chain is in use
+const time::Span TraceWriteInterval("10s");
+
+/// Every tracer of the process, in the order they were created
+std::vector<SolverTracer *> &liveTracers() {
+  static std::vector<SolverTracer *> tracers;
+  return tracers;
+}
+} // namespace
+
+SolverTracer::SolverTracer(std::string path, unsigned capacity,
+                           unsigned sampleRate)
+    : path(std::move(path)), capacity(std::max(capacity, 1u)),
+      sampleRate(std::max(sampleRate, 1u)), origin(time::getWallTime()),
+      owner(getpid()), lastWrite(origin) {
+  liveTracers().push_back(this);
+}
+
+SolverTracer::Span::Span(SolverTracer &tracer, const char *layer,
+                         unsigned instance, const char *operation,
+                         const Query &query)
+    : tracer(tracer), layer(layer), operation(operation), instance(instance),
+      constraints(query.constraints.cs().size()) {
+  // The outermost layer decides whether the whole query is traced
+  if (tracer.depth++ == 0)
+    tracer.sampling = tracer.queries++ % tracer.sampleRate == 0;
+  traced = tracer.sampling;
+  if (!traced)
+    return;
+  eventsBefore = tracer.recorded;
+  translationBefore = stats::queryTranslationTime.getValue();
+  solvingBefore = stats::querySolveTime.getValue();
+  start = time::getWallTime();
+}
+
+SolverTracer::Span::~Span() {
+  --tracer.depth;
+  if (!traced)
+    return;
+
+  time::Point end = time::getWallTime();
+  Event event;
+  event.layer = layer;
+  event.operation = operation;
+  event.start = (start - tracer.origin).toMicroseconds();
+  event.duration = (end - start).toMicroseconds();
+  event.translation =
+      stats::queryTranslationTime.getValue() - translationBefore;
+  event.solving = stats::querySolveTime.getValue() - solvingBefore;
+  event.constraints = constraints;
+  event.instance = instance;
+  event.pid = getpid();
+  event.answered = tracer.recorded == eventsBefore;
+  event.success = success;
+  tracer.record(event);
+
+  // A crash should not lose the whole trace
+  if (tracer.depth == 0 && event.pid == tracer.owner &&
+      end - tracer.lastWrite > TraceWriteInterval) {
+    tracer.writeTrace();
+    tracer.lastWrite = end;
+  }
+}
+
+void SolverTracer::record(const Event &event) {
+  if (events.size() < capacity)
+    events.push_back(event);
+  else
+    events[recorded % capacity] = event;
+  ++recorded;
+}
+
+std::vector<std::uint64_t> SolverTracer::mark() {
+  std::vector<std::uint64_t> marks;
+  for (const SolverTracer *tracer : liveTracers())
+    marks.push_back(tracer->recorded);
+  return marks;
+}
+
+void SolverTracer::exportEvents(const std::vector<std::uint64_t> &marks,
+                                SolverPayload &payload) {
+  const std::vector<SolverTracer *> &tracers = liveTracers();
+  payload.put<std::uint64_t>(std::min(marks.size(), tracers.size()));
+  for (std::size_t t = 0; t < marks.size() && t < tracers.size(); ++t) {
+    const SolverTracer &tracer = *tracers[t];
+    // Only the latest events are still in the ring buffer
+    std::uint64_t first =
+        std::max(marks[t], tracer.recorded -
+                               std::min<std::uint64_t>(tracer.recorded,
+                                                       tracer.capacity));
+    payload.put<std::uint64_t>(tracer.recorded - first);
+    for (std::uint64_t i = first; i < tracer.recorded; ++i) {
+      const Event &e = tracer.events[i % tracer.capacity];
+      payload.putString(e.layer);
+      payload.putString(e.operation);
+      payload.put(e.start);
+      payload.put(e.duration);
+      payload.put(e.translation);
+      payload.put(e.solving);
+      payload.put(e.constraints);
+      payload.put(e.instance);
+      payload.put(e.pid);
+      payload.put(e.answered);
+      payload.put(e.success);
+    }
+  }
+}
+
+void SolverTracer::importEvents(SolverPayload &payload) {
+  const std::vector<SolverTracer *> &tracers = liveTracers();
+  std::uint64_t count;
+  if (!payload.get(count) || count > tracers.size())
+    return;
+  for (std::uint64_t t = 0; t < count; ++t) {
+    SolverTracer &tracer = *tracers[t];
+    std::uint64_t size;
+    if (!payload.get(size))
+      return;
+    for (std::uint64_t i = 0; i < size; ++i) {
+      Event e;
+      std::string layer, operation;
+      if (!payload.getString(layer) || !payload.getString(operation) ||
+          !payload.get(e.start) || !payload.get(e.duration) ||
+          !payload.get(e.translation) || !payload.get(e.solving) ||
+          !payload.get(e.constraints) || !payload.get(e.instance) ||
+          !payload.get(e.pid) || !payload.get(e.answered) ||
+          !payload.get(e.success))
+        return;
+      e.layer = tracer.intern(layer);
+      e.operation = tracer.intern(operation);
+      tracer.record(e);
+    }
+  }
+}
+
+void SolverTracer::write(llvm::raw_ostream &os) const {
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  // Oldest first, starting after the slot written last once the buffer
+  // has wrapped around
+  std::size_t first =
+      events.size() < recorded ? recorded % events.size() : 0;
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    const Event &e = events[(first + i) % events.size()];
+    if (i)
+      os << ',';
+    os << "\n{\"name\":\"" << e.layer << "\",\"cat\":\"solver\",\"ph\":\"X\""
+       << ",\"ts\":" << e.start << ",\"dur\":" << e.duration
+       << ",\"pid\":" << e.pid << ",\"tid\":0,\"args\":{\"operation\":\""
+       << e.operation << "\",\"instance\":" << e.instance
+       << ",\"constraints\":" << e.constraints
+       << ",\"answered\":" << (e.answered ? "true" : "false")
+       << ",\"success\":" << (e.success ? "true" : "false");
+    if (e.translation)
+      os << ",\"translation_us\":" << e.translation;
+    if (e.solving)
+      os << ",\"solving_us\":" << e.solving;
+    os << "}}";
+  }
+  os << "\n],\"otherData\":{\"recordedEvents\":" << recorded
+     << ",\"keptEvents\":" << events.size() << ",\"sampleRate\":" << sampleRate
+     << "}}\n";
+}
+
+void SolverTracer::writeTrace() {
+  // Written next to the trace and renamed over it, so that the trace is
+  // complete whenever KLEE stops
+  std::string partial = path + ".part";
+  std::string error;
+  {
+    std::unique_ptr<llvm::raw_fd_ostream> os =
+        klee_open_output_file(partial, error);
+    if (!os) {
+      klee_warning("Could not write solver trace %s: %s", partial.c_str(),
+                   error.c_str());
+      return;
+    }
+    write(*os);
+  }
+  if (std::rename(partial.c_str(), path.c_str()))
+    klee_warning("Could not write solver trace %s", path.c_str());
+}
+
+SolverTracer::~SolverTracer() {
+  auto &tracers = liveTracers();
+  tracers.erase(std::remove(tracers.begin(), tracers.end(), this),
+                tracers.end());
+  if (getpid() == owner)
+    writeTrace();
+}
+
+namespace {
+
+/// TracingSolver - Records every call of the solver it wraps as a span
+/// named after that solver's layer of the chain.
+class TracingSolver : public SolverImpl {
+private:
+  std::unique_ptr<Solver> solver;
+  std::shared_ptr<SolverTracer> tracer;
+  const char *layer;
+  /// Tells apart the layers of the same kind, e.g. the caches in front of
+  /// and behind the concretizing solver
+  unsigned instance;
+
+public:
+  TracingSolver(std::unique_ptr<Solver> solver,
+                std::shared_ptr<SolverTracer> tracer, const char *layer)
+      : solver(std::move(solver)), tracer(std::move(tracer)), layer(layer),
+        instance(this->tracer->addInstance()) {}
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValidity(const Query &, PartialValidity &result);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool computeInitialValues(
+      const Query &query, const std::vector<const Array *> &objects,
+      std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution);
+  bool check(const Query &query, ref<SolverResponse> &result);
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid);
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(time::Span timeout);
+  void notifyStateTermination(std::uint32_t id);
+};
+
+bool TracingSolver::computeTruth(const Query &query, bool &isValid) {
+  SolverTracer::Span span(*tracer, layer, instance, "truth", query);
+  return span.success = solver->impl->computeTruth(query, isValid);
+}
+
+bool TracingSolver::computeValidity(const Query &query,
+                                    PartialValidity &result) {
+  SolverTracer::Span span(*tracer, layer, instance, "validity", query);
+  return span.success = solver->impl->computeValidity(query, result);
+}
+
+bool TracingSolver::computeValue(const Query &query, ref<Expr> &result) {
+  SolverTracer::Span span(*tracer, layer, instance, "value", query);
+  return span.success = solver->impl->computeValue(query, result);
+}
+
+bool TracingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  SolverTracer::Span span(*tracer, layer, instance, "initialValues", query);
+  return span.success = solver->impl->computeInitialValues(query, objects,
+                                                           values, hasSolution);
+}
+
+bool TracingSolver::check(const Query &query, ref<SolverResponse> &result) {
+  SolverTracer::Span span(*tracer, layer, instance, "check", query);
+  return span.success = solver->impl->check(query, result);
+}
+
+bool TracingSolver::computeValidityCore(const Query &query,
+                                        ValidityCore &validityCore,
+                                        bool &isValid) {
+  SolverTracer::Span span(*tracer, layer, instance, "validityCore", query);
+  return span.success =
+             solver->impl->computeValidityCore(query, validityCore, isValid);
+}
+
+bool TracingSolver::computeFeasibility(const Query &query,
+                                       const std::vector<ref<Expr>> &conditions,
+                                       std::vector<bool> &feasible) {
+  SolverTracer::Span span(*tracer, layer, instance, "feasibility", query);
+  return span.success =
+             solver->impl->computeFeasibility(query, conditions, feasible);
+}
+
+SolverImpl::SolverRunStatus TracingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *TracingSolver::getConstraintLog(const Query &query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void TracingSolver::setCoreSolverTimeout(time::Span timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+void TracingSolver::notifyStateTermination(std::uint32_t id) {
+  solver->impl->notifyStateTermination(id);
+}
+
+} // namespace
+
+std::shared_ptr<SolverTracer> klee::createSolverTracer(std::string path,
+                                                       unsigned capacity,
+                                                       unsigned sampleRate) {
+  return std::make_shared<SolverTracer>(std::move(path), capacity, sampleRate);
+}
+
+std::unique_ptr<Solver>
+klee::createTracingSolver(std::unique_ptr<Solver> s,
+                          std::shared_ptr<SolverTracer> tracer,
+                          const char *layer) {
+  return std::make_unique<Solver>(
+      std::make_unique<TracingSolver>(std::move(s), std::move(tracer), layer));
+}
@@ -21,8 +21,15 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/iterator_range.h"
 
+#include <algorithm>
+
 using namespace klee;
 
+namespace {
+/// Size of the construct cache below which it is not swept
+const size_t MinTermCacheSweep = 1 << 14;
+} // namespace
+
 namespace klee {
 
 // Declared here rather than `Z3Builder.h` so they can be called in gdb.
@@ -75,7 +82,8 @@ void Z3ArrayExprHash::clearUpdates() { _update_node_hash.clear(); }
 
 Z3Builder::Z3Builder(bool autoClearConstructCache,
                      const char *z3LogInteractionFileArg)
-    : autoClearConstructCache(autoClearConstructCache),
+    : nextSweep(MinTermCacheSweep),
+      autoClearConstructCache(autoClearConstructCache),
       z3LogInteractionFile("") {
   if (z3LogInteractionFileArg)
     this->z3LogInteractionFile = std::string(z3LogInteractionFileArg);
@@ -366,23 +374,62 @@ Z3ASTHandle Z3Builder::construct(ref<Expr> e, int *width_out) {
   if (!Z3HashConfig::UseConstructHashZ3 || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Z3ASTHandle, unsigned>>::iterator it =
-        constructed.find(e);
+    ExprHashMap<ConstructedTerm>::iterator it = constructed.find(e);
     if (it != constructed.end()) {
+      ++stats::queryTermCacheHits;
+      it->second.lastUse = generation;
+      if (it->second.local)
+        ++localUses;
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = it->second.width;
+      return it->second.term;
     } else {
       int width;
       if (!width_out)
         width_out = &width;
+      size_t sides = sideConstraints.size();
+      uint64_t uses = localUses;
       Z3ASTHandle res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      localUses += sideConstraints.size() - sides;
+      bool local = localUses != uses;
+      constructed.insert(std::make_pair(
+          e, ConstructedTerm{res, static_cast<unsigned>(*width_out),
+                             generation, local}));
+      if (local)
+        queryLocal.push_back(e);
       return res;
     }
   }
 }
 
+void Z3Builder::finishQuery() {
+  clearSideConstraints();
+  ++generation;
+  if (!Z3HashConfig::Z3TermCacheIdleQueries) {
+    clearConstructCache();
+    return;
+  }
+
+  for (const auto &e : queryLocal)
+    constructed.erase(e);
+  queryLocal.clear();
+
+  // Sweeping visits every term, so it is done only when the cache has
+  // doubled since the last sweep
+  if (constructed.size() < nextSweep)
+    return;
+  for (auto it = constructed.begin(); it != constructed.end();) {
+    // Referenced only by the cache, so only a query which rebuilds the
+    // same expression would use the term again
+    if (it->first->_refCount.getCount() == 1 &&
+        generation - it->second.lastUse > Z3HashConfig::Z3TermCacheIdleQueries)
+      it = constructed.erase(it);
+    else
+      ++it;
+  }
+  nextSweep = std::max<size_t>(2 * constructed.size(), MinTermCacheSweep);
+}
+
 /** if *width_out!=1 then result is a bitvector,
     otherwise it is a bool */
 Z3ASTHandle Z3Builder::constructActual(ref<Expr> e, int *width_out) {
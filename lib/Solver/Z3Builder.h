@@ -197,7 +197,25 @@ protected:
   Z3SortHandle getBvSort(unsigned width);
   Z3SortHandle getArraySort(Z3SortHandle domainSort, Z3SortHandle rangeSort);
 
-  ExprHashMap<std::pair<Z3ASTHandle, unsigned>> constructed;
+  struct ConstructedTerm {
+    Z3ASTHandle term;
+    unsigned width;
+    /// The last query which used the term
+    uint64_t lastUse;
+    /// Whether the term relies on side constraints of the current query
+    bool local;
+  };
+  ExprHashMap<ConstructedTerm> constructed;
+  /// Expressions whose terms rely on side constraints of the current query,
+  /// which are not asserted again for later queries
+  std::vector<ref<Expr>> queryLocal;
+  /// Number of side constraints plus uses of query-local terms so far, to
+  /// tell whether building a term relied on any
+  uint64_t localUses = 0;
+  /// Number of queries finished
+  uint64_t generation = 0;
+  /// Size of the construct cache at which it is next swept
+  size_t nextSweep;
   Z3ArrayExprHash _arr_hash;
   bool autoClearConstructCache;
   std::string z3LogInteractionFile;
@@ -225,8 +243,15 @@ public:
       clearConstructCache();
     return res;
   }
-  void clearConstructCache() { constructed.clear(); }
+  void clearConstructCache() {
+    constructed.clear();
+    queryLocal.clear();
+  }
   void clearSideConstraints() { sideConstraints.clear(); }
+
+  /// Called after every query. Drops the terms not worth keeping for later
+  /// queries and the side constraints of the query.
+  void finishQuery();
 };
 } // namespace klee
 
@@ -17,5 +17,14 @@ llvm::cl::opt<bool> UseConstructHashZ3(
         "Use hash-consing during Z3 query construction (default=true)"),
     llvm::cl::init(true), llvm::cl::cat(klee::ExprCat));
 
+llvm::cl::opt<unsigned> Z3TermCacheIdleQueries(
+    "z3-term-cache-idle-queries",
+    llvm::cl::desc("Keep Z3 terms built for a query to reuse them in later "
+                   "queries. A term is dropped once its expression is no "
+                   "longer referenced elsewhere and no query used it for "
+                   "this many queries; 0 drops all terms after every query "
+                   "(default=8)"),
+    llvm::cl::init(8), llvm::cl::cat(klee::ExprCat));
+
 std::atomic<bool> Z3InteractionLogOpen(false);
 } // namespace Z3HashConfig
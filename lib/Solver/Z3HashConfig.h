@@ -16,6 +16,7 @@
 
 namespace Z3HashConfig {
 extern llvm::cl::opt<bool> UseConstructHashZ3;
+extern llvm::cl::opt<unsigned> Z3TermCacheIdleQueries;
 extern std::atomic<bool> Z3InteractionLogOpen;
 } // namespace Z3HashConfig
 #endif // KLEE_Z3HASHCONFIG_H
@@ -19,6 +19,7 @@
 #include "Z3Solver.h"
 
 #include "klee/ADT/Incremental.h"
+#include "klee/ADT/PrefixTrie.h"
 #include "klee/ADT/SparseStorage.h"
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/Constraints.h"
@@ -31,7 +32,11 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <csignal>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace {
 // NOTE: Very useful for debugging Z3 behaviour. These files can be given to
@@ -255,6 +260,9 @@ protected:
              ref<SolverResponse> &result);
   bool computeValidityCore(const ConstraintQuery &query, Z3SolverEnv &env,
                            ValidityCore &validityCore, bool &isValid);
+  bool computeFeasibility(const ConstraintQuery &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible);
 
 public:
   char *getConstraintLog(const Query &) final;
@@ -282,6 +290,7 @@ public:
   using SolverImpl::check;
   using SolverImpl::computeInitialValues;
   using SolverImpl::computeTruth;
+  using SolverImpl::computeFeasibility;
   using SolverImpl::computeValidityCore;
   using SolverImpl::computeValue;
 };
@@ -489,6 +498,102 @@ bool Z3SolverImpl::computeValidityCore(const ConstraintQuery &query,
   return status;
 }
 
+bool Z3SolverImpl::computeFeasibility(const ConstraintQuery &query,
+                                      const std::vector<ref<Expr>> &conditions,
+                                      std::vector<bool> &feasible) {
+  disableUnsatCore();
+
+  TimerStatIncrementer t(stats::queryTime);
+  runStatusCode = SolverImpl::SOLVER_RUN_STATUS_FAILURE;
+
+  // The constraints are translated and asserted only once. Each condition
+  // is guarded by a fresh constant and checked by assuming its guard.
+  Z3ASTIncSet exprs;
+  WallTimer translationTimer;
+  ConstantArrayFinder constant_arrays_in_query;
+  for (const auto &constraint : query.constraints.v) {
+    exprs.insert(builder->construct(constraint));
+    constant_arrays_in_query.visit(constraint);
+  }
+  std::vector<Z3ASTHandle> guards, z3Conditions;
+  for (const auto &condition : conditions) {
+    Z3ASTHandle guard = builder->buildFreshBoolConst();
+    Z3ASTHandle z3Condition = builder->construct(condition);
+    exprs.insert(Z3ASTHandle(Z3_mk_implies(builder->ctx, guard, z3Condition),
+                             builder->ctx));
+    guards.push_back(guard);
+    z3Conditions.push_back(z3Condition);
+    constant_arrays_in_query.visit(condition);
+  }
+  for (auto constant_array : constant_arrays_in_query.results) {
+    const auto &cas = builder->constant_array_assertions[constant_array];
+    exprs.insert(cas.begin(), cas.end());
+  }
+  exprs.insert(builder->sideConstraints.begin(),
+               builder->sideConstraints.end());
+  stats::queryTranslationTime += translationTimer.delta().toMicroseconds();
+
+  Z3_solver theSolver = initNativeZ3(query, exprs);
+  for (auto expr : exprs)
+    Z3_solver_assert(builder->ctx, theSolver, expr);
+
+  Z3SolverEnv env;
+  feasible.assign(conditions.size(), false);
+  std::vector<bool> decided(conditions.size(), false);
+  bool success = true;
+  for (unsigned i = 0; i < conditions.size(); ++i) {
+    if (decided[i])
+      continue;
+
+    ++stats::solverQueries;
+    ::Z3_ast guard = guards[i];
+    ::Z3_lbool satisfiable;
+    {
+      TimerStatIncrementer solveTimer(stats::querySolveTime);
+      satisfiable =
+          Z3_solver_check_assumptions(builder->ctx, theSolver, 1, &guard);
+    }
+    bool hasSolution = false;
+    runStatusCode =
+        handleSolverResponse(theSolver, satisfiable, env,
+                             ObjectAssignment::NotNeeded, nullptr, hasSolution);
+    if (runStatusCode != SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE &&
+        runStatusCode != SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
+      success = false;
+      break;
+    }
+    decided[i] = true;
+    feasible[i] = hasSolution;
+    if (!hasSolution) {
+      ++stats::queriesValid;
+      continue;
+    }
+    ++stats::queriesInvalid;
+
+    // The model may satisfy some of the remaining conditions as well
+    ::Z3_model theModel = Z3_solver_get_model(builder->ctx, theSolver);
+    Z3_model_inc_ref(builder->ctx, theModel);
+    for (unsigned j = i + 1; j < conditions.size(); ++j) {
+      ::Z3_ast value;
+      if (decided[j] || !Z3_model_eval(builder->ctx, theModel,
+                                       z3Conditions[j], Z3_TRUE, &value))
+        continue;
+      if (Z3_get_bool_value(builder->ctx, Z3ASTHandle(value, builder->ctx)) ==
+          Z3_L_TRUE)
+        decided[j] = feasible[j] = true;
+    }
+    Z3_model_dec_ref(builder->ctx, theModel);
+  }
+
+  deinitNativeZ3(theSolver);
+
+  builder->finishQuery();
+  if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_INTERRUPTED) {
+    raise(SIGINT);
+  }
+  return success;
+}
+
 bool Z3SolverImpl::internalRunSolver(
     const ConstraintQuery &query, Z3SolverEnv &env,
     ObjectAssignment needObjects,
@@ -513,6 +618,7 @@ bool Z3SolverImpl::internalRunSolver(
 
   std::unordered_set<const Array *> all_constant_arrays_in_query;
   Z3ASTIncSet exprs;
+  WallTimer translationTimer;
 
   for (size_t i = 0; i < query.constraints.framesSize();
        i++, env.push(), exprs.push()) {
@@ -567,6 +673,7 @@ bool Z3SolverImpl::internalRunSolver(
                  builder->sideConstraints.end());
   }
   exprs.pop(1); // drop last empty frame
+  stats::queryTranslationTime += translationTimer.delta().toMicroseconds();
 
   ++stats::solverQueries;
   if (!env.objects.v.empty())
@@ -601,7 +708,11 @@ bool Z3SolverImpl::internalRunSolver(
     dumpedQueriesFile->flush();
   }
 
-  ::Z3_lbool satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  ::Z3_lbool satisfiable;
+  {
+    TimerStatIncrementer solveTimer(stats::querySolveTime);
+    satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  }
   runStatusCode = handleSolverResponse(theSolver, satisfiable, env, needObjects,
                                        values, hasSolution);
   if (ProduceUnsatCore && validityCore && satisfiable == Z3_L_FALSE) {
@@ -647,13 +758,11 @@ bool Z3SolverImpl::internalRunSolver(
 
   deinitNativeZ3(theSolver);
 
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
-  // we allow Z3_ast expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
-  // ``builder->construct()``.
-  builder->clearConstructCache();
-  builder->clearSideConstraints();
+  // Drop the builder's cached terms not worth keeping, to prevent memory
+  // usage exploding. By using ``autoClearConstructCache=false`` we allow
+  // Z3_ast expressions to be shared from an entire ``Query``, and those
+  // kept here with later queries.
+  builder->finishQuery();
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
     if (hasSolution) {
@@ -938,6 +1047,12 @@ public:
     return Z3SolverImpl::computeValidityCore(ConstraintQuery(query, false), env,
                                              validityCore, isValid);
   }
+  bool computeFeasibility(const Query &query,
+                          const std::vector<ref<Expr>> &conditions,
+                          std::vector<bool> &feasible) override {
+    return Z3SolverImpl::computeFeasibility(
+        ConstraintQuery(query.withFalse(), false), conditions, feasible);
+  }
   void notifyStateTermination(std::uint32_t) override {}
 };
 
@@ -992,6 +1107,9 @@ public:
 
   Z3_solver getOrInit();
 
+  /// The constraints asserted in the underlying solver, in order
+  const ConstraintFrames::vec &constraints() const { return frames.v; }
+
   bool isConsistent() const {
     auto num_scopes =
         nativeSolver ? Z3_solver_get_num_scopes(ctx, nativeSolver) : 0;
@@ -1075,16 +1193,22 @@ void Z3IncNativeSolver::distance(const ConstraintQuery &query,
 
 class Z3TreeSolverImpl final : public Z3SolverImpl {
 private:
-  using solvers_ty = std::vector<std::unique_ptr<Z3IncNativeSolver>>;
-  using solvers_it = solvers_ty::iterator;
+  using solvers_ty = std::unordered_map<const Z3IncNativeSolver *,
+                                        std::unique_ptr<Z3IncNativeSolver>>;
 
   const size_t maxSolvers;
   std::unique_ptr<Z3IncNativeSolver> currentSolver = nullptr;
+  /// Pooled solvers, owned by their address
   solvers_ty solvers;
+  /// Pooled solvers whose state has terminated
+  std::unordered_set<Z3IncNativeSolver *> recycled;
+  /// Pooled solvers indexed by their asserted constraints
+  PrefixTrie<ref<Expr>, Z3IncNativeSolver *, util::ExprHash, util::ExprCmp>
+      solversIndex;
 
   void findSuitableSolver(const ConstraintQuery &query,
                           ConstraintDistance &delta);
-  void setSolver(solvers_it &it, bool recycle = false);
+  void setSolver(Z3IncNativeSolver *solver, bool recycle = false);
   ConstraintQuery prepare(const Query &q);
 
 public:
@@ -1097,7 +1221,11 @@ public:
   }
   void deinitNativeZ3(Z3_solver) override {
     assert(currentSolver->isConsistent());
-    solvers.push_back(std::move(currentSolver));
+    solversIndex.insert(currentSolver->constraints().begin(),
+                        currentSolver->constraints().end(),
+                        currentSolver.get());
+    const auto *solver = currentSolver.get();
+    solvers.emplace(solver, std::move(currentSolver));
   }
   void push(Z3_context c, Z3_solver s) override { Z3_solver_push(c, s); }
 
@@ -1116,9 +1244,12 @@ public:
   void notifyStateTermination(std::uint32_t id) override;
 };
 
-void Z3TreeSolverImpl::setSolver(solvers_it &it, bool recycle) {
+void Z3TreeSolverImpl::setSolver(Z3IncNativeSolver *solver, bool recycle) {
+  auto it = solvers.find(solver);
   assert(it != solvers.end());
-  currentSolver = std::move(*it);
+  solversIndex.erase(solver);
+  recycled.erase(solver);
+  currentSolver = std::move(it->second);
   solvers.erase(it);
   currentSolver->isRecycled = false;
   if (recycle)
@@ -1127,40 +1258,45 @@ void Z3TreeSolverImpl::setSolver(solvers_it &it, bool recycle) {
 
 void Z3TreeSolverImpl::findSuitableSolver(const ConstraintQuery &query,
                                           ConstraintDistance &delta) {
+  // Score the solvers sharing a prefix with the query by the constraints they
+  // have to pop and push. A live state's solver gets its popped constraints
+  // pushed back once that state queries again, so they count twice; the
+  // constraints of a recycled solver are of no use to anyone. A state forked
+  // from the state which last used a solver thus gets that solver back.
+  std::vector<Z3IncNativeSolver *> candidates;
+  solversIndex.candidates(query.constraints.v.begin(),
+                          query.constraints.v.end(), candidates);
+  Z3IncNativeSolver *closest = nullptr;
   ConstraintDistance min_delta;
   auto min_distance = std::numeric_limits<size_t>::max();
-  auto min_it = solvers.end();
-  auto free_it = solvers.end();
-  for (auto it = solvers.begin(), ite = min_it; it != ite; it++) {
-    if ((*it)->isRecycled)
-      free_it = it;
-    (*it)->distance(query, delta);
-    if (delta.isOnlyPush()) {
-      setSolver(it);
-      return;
-    }
-    auto distance = delta.getDistance();
+  for (auto *solver : candidates) {
+    ConstraintDistance d;
+    solver->distance(query, d);
+    auto distance = d.getDistance() + (solver->isRecycled ? 0 : d.toPopSize);
     if (distance < min_distance) {
-      min_delta = delta;
+      closest = solver;
+      min_delta = std::move(d);
       min_distance = distance;
-      min_it = it;
     }
   }
-  if (solvers.size() < maxSolvers) {
-    delta = ConstraintDistance(query);
-    if (delta.getDistance() < min_distance) {
-      // it is cheaper to create new solver
-      if (free_it == solvers.end())
-        currentSolver =
-            std::make_unique<Z3IncNativeSolver>(builder->ctx, solverParameters);
-      else
-        setSolver(free_it, /*recycle=*/true);
+  if (query.size() < min_distance) {
+    // it is cheaper to start from an empty solver
+    if (!recycled.empty()) {
+      delta = ConstraintDistance(query);
+      setSolver(*recycled.begin(), /*recycle=*/true);
+      return;
+    }
+    if (solvers.size() < maxSolvers) {
+      delta = ConstraintDistance(query);
+      currentSolver =
+          std::make_unique<Z3IncNativeSolver>(builder->ctx, solverParameters);
       return;
     }
   }
-  assert(min_it != solvers.end());
+  assert(closest);
+  ++stats::queryReusedSolvers;
   delta = min_delta;
-  setSolver(min_it);
+  setSolver(closest);
 }
 
 ConstraintQuery Z3TreeSolverImpl::prepare(const Query &q) {
@@ -1206,9 +1342,12 @@ bool Z3TreeSolverImpl::computeValidityCore(const Query &query,
 }
 
 void Z3TreeSolverImpl::notifyStateTermination(std::uint32_t id) {
-  for (auto &s : solvers)
-    if (s->stateID == id)
-      s->isRecycled = true;
+  for (auto &s : solvers) {
+    if (s.second->stateID == id) {
+      s.second->isRecycled = true;
+      recycled.insert(s.second.get());
+    }
+  }
 }
 
 Z3TreeSolver::Z3TreeSolver(Z3BuilderType type, unsigned maxSolvers)
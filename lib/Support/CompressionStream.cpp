@@ -72,6 +72,23 @@ void compressed_fd_ostream::flush_compressed_data() {
   write_file(reinterpret_cast<const char *>(buffer), BUFSIZE - strm.avail_out);
 }
 
+void compressed_fd_ostream::sync() {
+  // flush data from the raw buffer
+  flush();
+
+  // deflate is done with the flush once it leaves output space unused
+  while (true) {
+    const auto res __attribute__((unused)) = deflate(&strm, Z_SYNC_FLUSH);
+    assert(res == Z_OK || res == Z_BUF_ERROR);
+    if (strm.avail_out != 0)
+      break;
+    writeFullCompressedData();
+  }
+  write_file(reinterpret_cast<const char *>(buffer), BUFSIZE - strm.avail_out);
+  strm.next_out = buffer;
+  strm.avail_out = BUFSIZE;
+}
+
 compressed_fd_ostream::~compressed_fd_ostream() {
   if (FD >= 0) {
     // write the remaining data
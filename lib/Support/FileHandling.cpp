@@ -12,6 +12,9 @@
 
 #include "llvm/Support/FileSystem.h"
 
+#include <cerrno>
+#include <unistd.h>
+
 #ifdef HAVE_ZLIB_H
 #include "klee/Support/CompressionStream.h"
 #endif
@@ -44,4 +47,33 @@ klee_open_compressed_output_file(const std::string &path, std::string &error) {
   return f;
 }
 #endif
+
+bool klee_write_fully(int fd, const std::string &data) {
+  const char *buffer = data.data();
+  size_t size = data.size();
+  while (size) {
+    ssize_t written = write(fd, buffer, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    buffer += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool klee_read_fully(int fd, char *buffer, size_t size, off_t offset) {
+  while (size) {
+    ssize_t received = pread(fd, buffer, size, offset);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      return false;
+    buffer += received;
+    size -= received;
+    offset += received;
+  }
+  return true;
+}
 } // namespace klee
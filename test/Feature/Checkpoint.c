@@ -0,0 +1,27 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out %t.resumed-out
+// RUN: %klee --output-dir=%t.klee-out --search=dfs --max-tests=3 --dump-states-on-halt=none --write-checkpoint %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-HALT %s
+// RUN: %klee --output-dir=%t.resumed-out --search=dfs --resume-from=%t.klee-out/checkpoint.paths %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-RESUME %s
+
+#include "klee/klee.h"
+
+int main() {
+  char a[3];
+  klee_make_symbolic(a, sizeof(a), "a");
+
+  // Eight paths, three of which complete before the first run halts
+  unsigned n = 0;
+  if (a[0] > 0)
+    n |= 1;
+  if (a[1] > 0)
+    n |= 2;
+  if (a[2] > 0)
+    n |= 4;
+  return n;
+}
+
+// CHECK-HALT: KLEE: wrote a checkpoint of {{[0-9]+}} states
+// CHECK-HALT: KLEE: done: completed paths = 3
+
+// The resumed run explores exactly the paths the first one did not complete
+// CHECK-RESUME: KLEE: done: completed paths = 5
@@ -0,0 +1,36 @@
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --write-no-tests --fork-models --output-dir=%t.klee-out %t.bc 2> %t.log
+// RUN: FileCheck -check-prefix=CHECK-LOG -input-file=%t.log %s
+// RUN: %klee-stats --print-columns 'ForkModelHits' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=CHECK-STATS -input-file=%t.stats %s
+// RUN: rm -rf %t.klee-out-default
+// RUN: %klee --write-no-tests --output-dir=%t.klee-out-default %t.bc 2> %t.default.log
+// RUN: FileCheck -check-prefix=CHECK-LOG -input-file=%t.default.log %s
+// RUN: %klee-stats --print-columns 'ForkModelHits' --table-format=csv %t.klee-out-default > %t.default.stats
+// RUN: FileCheck -check-prefix=CHECK-DEFAULT -input-file=%t.default.stats %s
+
+#include "klee/klee.h"
+
+int main(void) {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+
+  // With --fork-models, after the fork on x > 10 the model of each state
+  // decides one direction of the branches below
+  if (x > 10) {
+    if (x < 5)
+      return 1;
+    if (x > 20)
+      return 2;
+  }
+  return 0;
+}
+
+// CHECK-LOG: KLEE: done: completed paths = 3
+
+// CHECK-STATS: ForkModelHits
+// CHECK-STATS-NEXT: {{[1-9][0-9]*}}
+
+// CHECK-DEFAULT: ForkModelHits
+// CHECK-DEFAULT-NEXT: {{^}}0{{$}}
@@ -0,0 +1,47 @@
+// REQUIRES: not-msan
+// MSan adds additional memory that overflows the counter
+//
+// Check that exceeding the memory cap terminates states early: both forked
+// states are killed with "Memory limit exceeded." and neither reaches the end
+// of main. The order in which victims are chosen is unit-tested in
+// ExecutionStateTest.
+
+// RUN: %clang %s -emit-llvm -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --max-memory=20 --max-cycles-before-stuck=0 --search=dfs %t.bc > %t.log
+// RUN: FileCheck -check-prefix=CHECK-LOG -allow-empty -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-WRN -input-file=%t.klee-out/warnings.txt %s
+// RUN: cat %t.klee-out/*.early | FileCheck -check-prefix=CHECK-EARLY %s
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main() {
+  int i, j, c, malloc_failed = 0;
+
+  klee_make_symbolic(&c, sizeof(c), "c");
+  if (c)
+    c = 1;
+
+  // 200 MB per state (in 1 KB chunks)
+  for (i = 0; i < 100 && !malloc_failed; i++) {
+    for (j = 0; j < (1 << 11); j++) {
+      void *p = malloc(1 << 10);
+      malloc_failed |= (p == 0);
+    }
+  }
+
+  // CHECK-WRN: WARNING: killing 2 states (over memory cap
+  // CHECK-EARLY: Memory limit exceeded.
+  // CHECK-EARLY: Memory limit exceeded.
+
+  if (malloc_failed)
+    printf("MALLOC FAILED\n");
+  // CHECK-LOG-NOT: MALLOC FAILED
+  printf("DONE!\n");
+  // CHECK-LOG-NOT: DONE!
+
+  return c;
+}
@@ -0,0 +1,73 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --optimize --native-concrete-calls %t1.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'NativeCalls' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=CHECK-STATS -input-file=%t.stats %s
+
+#include "klee/klee.h"
+
+#include <assert.h>
+
+// Accesses no memory once optimized, so it is run natively when concrete
+__attribute__((noinline)) unsigned mix(unsigned h, unsigned k) {
+  k *= 0xcc9e2d51u;
+  k = (k << 15) | (k >> 17);
+  k *= 0x1b873593u;
+  h ^= k;
+  h = (h << 13) | (h >> 19);
+  return h * 5 + 0xe6546b64u;
+}
+
+// The same function, always interpreted as it accesses memory
+__attribute__((noinline)) unsigned mixInterpreted(unsigned h, unsigned k) {
+  volatile unsigned v = k;
+  v *= 0xcc9e2d51u;
+  v = (v << 15) | (v >> 17);
+  v *= 0x1b873593u;
+  h ^= v;
+  h = (h << 13) | (h >> 19);
+  return h * 5 + 0xe6546b64u;
+}
+
+// Always interpreted as native shifts mask the amount, which is not constant
+__attribute__((noinline)) unsigned shift(unsigned h, unsigned k) {
+  return h << k;
+}
+
+// Always interpreted as it loops, for as long as the interpreter is allowed
+__attribute__((noinline)) unsigned collatz(unsigned n) {
+  unsigned steps = 0;
+  while (n != 1) {
+    n = n % 2 ? 3 * n + 1 : n / 2;
+    ++steps;
+  }
+  return steps;
+}
+
+int main() {
+  unsigned h = 0, g = 0, s = 0;
+  for (unsigned i = 0; i < 100; ++i) {
+    h = mix(h, i);
+    g = mixInterpreted(g, i);
+    s += shift(1, i % 32);
+  }
+  assert(h == 0xf2d62156u);
+  assert(h == g);
+  assert(s == 12);
+  assert(collatz(27) == 111);
+
+  // Symbolic arguments are interpreted
+  unsigned x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (mix(h, x) == mix(h, 7))
+    assert(x == 7);
+
+  // CHECK-NOT: failed to run
+  // CHECK-NOT: ASSERTION FAIL
+  // CHECK: KLEE: done: completed paths = 2
+  return 0;
+}
+
+// The hundred calls in the loop and mix(h, 7)
+// CHECK-STATS: NativeCalls
+// CHECK-STATS-NEXT: {{^}}101{{$}}
@@ -18,12 +18,14 @@
 #include "klee/Expr/Parser/Lexer.h"
 #include "klee/Expr/Parser/Parser.h"
 #include "klee/Solver/Common.h"
+#include "klee/Solver/QueryLog.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Support/OptionCategories.h"
 #include "klee/Support/PrintVersion.h"
+#include "klee/System/Time.h"
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
@@ -32,9 +34,14 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace klee;
 using namespace klee::expr;
@@ -44,7 +51,13 @@ llvm::cl::opt<std::string> InputFile(llvm::cl::desc("<input query log>"),
                                      llvm::cl::Positional, llvm::cl::init("-"),
                                      llvm::cl::cat(klee::ExprCat));
 
-enum ToolActions { PrintTokens, PrintAST, PrintSMTLIBv2, Evaluate };
+enum ToolActions {
+  PrintTokens,
+  PrintAST,
+  PrintSMTLIBv2,
+  Evaluate,
+  ReplayQueryLog
+};
 
 static llvm::cl::opt<ToolActions> ToolAction(
     llvm::cl::desc("Tool actions:"), llvm::cl::init(Evaluate),
@@ -56,7 +69,10 @@ static llvm::cl::opt<ToolActions> ToolAction(
         clEnumValN(PrintAST, "print-ast",
                    "Print parsed AST nodes from the input file."),
         clEnumValN(Evaluate, "evaluate",
-                   "Evaluate parsed AST nodes from the input file.")),
+                   "Evaluate parsed AST nodes from the input file."),
+        clEnumValN(ReplayQueryLog, "replay-query-log",
+                   "Replay the queries of a binary query log against the "
+                   "solver chain and report their latencies.")),
     llvm::cl::cat(klee::SolvingCat));
 
 enum BuilderKinds {
@@ -82,6 +98,12 @@ llvm::cl::opt<std::string> DirectoryToWriteQueryLogs(
         "The folder to write query logs to (default=current directory)"),
     llvm::cl::init("."), llvm::cl::cat(klee::ExprCat));
 
+llvm::cl::opt<unsigned> ReplayJobs(
+    "replay-jobs",
+    llvm::cl::desc("Number of processes replaying a query log in parallel, "
+                   "each with its own solver chain (default=1)"),
+    llvm::cl::init(1), llvm::cl::cat(klee::SolvingCat));
+
 llvm::cl::opt<bool> ClearArrayAfterQuery(
     "clear-array-decls-after-query",
     llvm::cl::desc("Discard the previous array declarations after a query "
@@ -176,6 +198,26 @@ static bool PrintInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
   return success;
 }
 
+static std::unique_ptr<Solver> createSolverChain() {
+  std::unique_ptr<Solver> coreSolver = klee::createCoreSolver(CoreSolverToUse);
+
+  if (CoreSolverToUse != DUMMY_SOLVER) {
+    const time::Span maxCoreSolverTime(MaxCoreSolverTime);
+    if (maxCoreSolverTime) {
+      coreSolver->setCoreSolverTimeout(maxCoreSolverTime);
+    }
+  }
+
+  return constructSolverChain(
+      std::move(coreSolver), getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
+      getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME),
+      getQueryLogPath(ALL_QUERIES_BINARY_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_BINARY_FILE_NAME),
+      getQueryLogPath(SOLVER_TRACE_FILE_NAME));
+}
+
 static bool EvaluateInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
                              ExprBuilder *Builder) {
   std::vector<Decl *> Decls;
@@ -194,20 +236,7 @@ static bool EvaluateInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
   if (!success)
     return false;
 
-  std::unique_ptr<Solver> coreSolver = klee::createCoreSolver(CoreSolverToUse);
-
-  if (CoreSolverToUse != DUMMY_SOLVER) {
-    const time::Span maxCoreSolverTime(MaxCoreSolverTime);
-    if (maxCoreSolverTime) {
-      coreSolver->setCoreSolverTimeout(maxCoreSolverTime);
-    }
-  }
-
-  std::unique_ptr<Solver> S = constructSolverChain(
-      std::move(coreSolver), getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME),
-      getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
-      getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
-      getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME));
+  std::unique_ptr<Solver> S = createSolverChain();
 
   unsigned Index = 0;
   for (std::vector<Decl *>::iterator it = Decls.begin(), ie = Decls.end();
@@ -385,6 +414,278 @@ static bool printInputAsSMTLIBv2(const char *Filename,
   return true;
 }
 
+namespace {
+/// What replaying (a share of) a query log measured. Latencies are counted
+/// in buckets of powers of two microseconds.
+struct ReplaySummary {
+  static const unsigned Buckets = 40;
+
+  uint64_t queries = 0;
+  uint64_t unreadable = 0;
+  uint64_t failures = 0;
+  /// Queries answered differently than when they were logged
+  uint64_t disagreements = 0;
+  uint64_t loggedMicroseconds = 0;
+  uint64_t replayedMicroseconds = 0;
+  uint64_t slowestMicroseconds = 0;
+  uint64_t histogram[Buckets] = {};
+  uint64_t operations[QueryLogOperationCount] = {};
+  uint64_t operationMicroseconds[QueryLogOperationCount] = {};
+  bool malformed = false;
+
+  void record(const LoggedQuery &logged, const QueryLogOutcome &replayed) {
+    uint64_t micros = replayed.elapsed.toMicroseconds();
+    unsigned bucket = 0;
+    while (bucket + 1 < Buckets && (micros >> (bucket + 1)))
+      ++bucket;
+    ++queries;
+    ++histogram[bucket];
+    unsigned operation = static_cast<unsigned>(logged.operation);
+    ++operations[operation];
+    operationMicroseconds[operation] += micros;
+    loggedMicroseconds += logged.outcome.elapsed.toMicroseconds();
+    replayedMicroseconds += micros;
+    slowestMicroseconds = std::max(slowestMicroseconds, micros);
+    if (!replayed.success)
+      ++failures;
+    else if (logged.outcome.hasAnswer && replayed.hasAnswer &&
+             logged.outcome.answer != replayed.answer)
+      ++disagreements;
+  }
+
+  void add(const ReplaySummary &other) {
+    queries += other.queries;
+    unreadable += other.unreadable;
+    failures += other.failures;
+    disagreements += other.disagreements;
+    loggedMicroseconds += other.loggedMicroseconds;
+    replayedMicroseconds += other.replayedMicroseconds;
+    slowestMicroseconds =
+        std::max(slowestMicroseconds, other.slowestMicroseconds);
+    for (unsigned i = 0; i < Buckets; ++i)
+      histogram[i] += other.histogram[i];
+    for (unsigned i = 0; i < QueryLogOperationCount; ++i) {
+      operations[i] += other.operations[i];
+      operationMicroseconds[i] += other.operationMicroseconds[i];
+    }
+    malformed |= other.malformed;
+  }
+
+  /// The upper bound of the bucket holding the given fraction of queries
+  uint64_t percentile(double fraction) const {
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < Buckets; ++i) {
+      seen += histogram[i];
+      if (seen && seen >= fraction * queries)
+        return uint64_t(1) << (i + 1);
+    }
+    return 0;
+  }
+};
+} // namespace
+
+static QueryLogOutcome replayQuery(Solver &solver, const LoggedQuery &logged) {
+  Query query(logged.constraints, logged.expr);
+  QueryLogOutcome outcome;
+  outcome.hasAnswer = true;
+  time::Point start = time::getWallTime();
+  switch (logged.operation) {
+  case QueryLogOperation::Truth: {
+    bool isValid;
+    outcome.success = solver.impl->computeTruth(query, isValid);
+    outcome.answer = outcome.success && isValid;
+    break;
+  }
+  case QueryLogOperation::Validity: {
+    PartialValidity result;
+    outcome.success = solver.impl->computeValidity(query, result);
+    outcome.answer = outcome.success ? static_cast<int64_t>(result) : 0;
+    break;
+  }
+  case QueryLogOperation::Value: {
+    ref<Expr> result;
+    outcome.success = solver.impl->computeValue(query, result);
+    outcome.hasAnswer = false;
+    break;
+  }
+  case QueryLogOperation::InitialValues: {
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    bool hasSolution;
+    outcome.success = solver.impl->computeInitialValues(query, logged.objects,
+                                                        values, hasSolution);
+    outcome.answer = outcome.success && hasSolution;
+    break;
+  }
+  case QueryLogOperation::Check: {
+    ref<SolverResponse> result;
+    outcome.success = solver.impl->check(query, result);
+    outcome.answer = outcome.success ? result->getResponseKind() : 0;
+    break;
+  }
+  case QueryLogOperation::ValidityCore: {
+    ValidityCore core;
+    bool isValid;
+    outcome.success = solver.impl->computeValidityCore(query, core, isValid);
+    outcome.answer = outcome.success && isValid;
+    break;
+  }
+  case QueryLogOperation::Feasibility: {
+    std::vector<bool> feasible;
+    outcome.success =
+        solver.impl->computeFeasibility(query, logged.conditions, feasible);
+    outcome.answer =
+        outcome.success ? std::count(feasible.begin(), feasible.end(), true)
+                        : 0;
+    break;
+  }
+  }
+  outcome.elapsed = time::getWallTime() - start;
+  outcome.status = solver.impl->getOperationStatusCode();
+  return outcome;
+}
+
+/// Replay every `jobs`-th query of the log, starting with the `job`-th.
+/// Every job reads the whole log, as the queries it replays refer to
+/// expressions introduced by the others.
+static ReplaySummary replayShare(const char *Filename,
+                                 const llvm::MemoryBuffer *MB, unsigned job,
+                                 unsigned jobs) {
+  ReplaySummary summary;
+  std::unique_ptr<Solver> S = createSolverChain();
+  QueryLogReader reader(MB->getBuffer());
+  LoggedQuery logged;
+  for (uint64_t index = 0; reader.next(logged); ++index)
+    if (index % jobs == job)
+      summary.record(logged, replayQuery(*S, logged));
+
+  if (!reader.getError().empty()) {
+    if (job == 0)
+      llvm::errs() << Filename << ": " << reader.getError() << "\n";
+    summary.malformed = true;
+  }
+  if (job == 0)
+    summary.unreadable = reader.getUnreadable();
+  return summary;
+}
+
+/// Replay the log in `jobs` forked processes, which have their own
+/// expressions and solvers, and merge what they measured.
+static bool replayInParallel(const char *Filename, const llvm::MemoryBuffer *MB,
+                             unsigned jobs, ReplaySummary &summary) {
+  std::vector<std::pair<pid_t, int>> workers;
+  for (unsigned job = 0; job < jobs; ++job) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      llvm::errs() << "kleaver: cannot create pipe: " << strerror(errno)
+                   << "\n";
+      break;
+    }
+    llvm::outs().flush();
+    llvm::errs().flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      ReplaySummary share = replayShare(Filename, MB, job, jobs);
+      const char *data = reinterpret_cast<const char *>(&share);
+      size_t left = sizeof(share);
+      while (left) {
+        ssize_t written = write(fds[1], data, left);
+        if (written < 0 && errno == EINTR)
+          continue;
+        if (written <= 0)
+          _exit(1);
+        data += written;
+        left -= written;
+      }
+      _exit(0);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+      llvm::errs() << "kleaver: cannot fork: " << strerror(errno) << "\n";
+      close(fds[0]);
+      break;
+    }
+    workers.emplace_back(pid, fds[0]);
+  }
+
+  bool success = workers.size() == jobs;
+  for (const auto &worker : workers) {
+    ReplaySummary share;
+    char *data = reinterpret_cast<char *>(&share);
+    size_t left = sizeof(share);
+    while (left) {
+      ssize_t received = read(worker.second, data, left);
+      if (received < 0 && errno == EINTR)
+        continue;
+      if (received <= 0)
+        break;
+      data += received;
+      left -= received;
+    }
+    close(worker.second);
+    int status;
+    while (waitpid(worker.first, &status, 0) < 0 && errno == EINTR)
+      ;
+    if (left) {
+      llvm::errs() << "kleaver: a replay process died\n";
+      success = false;
+      continue;
+    }
+    summary.add(share);
+  }
+  return success;
+}
+
+static bool replayInputLog(const char *Filename,
+                           const llvm::MemoryBuffer *MB) {
+  unsigned jobs = std::max(1u, unsigned(ReplayJobs));
+  ReplaySummary summary;
+  bool success = true;
+  if (jobs == 1)
+    summary = replayShare(Filename, MB, 0, 1);
+  else
+    success = replayInParallel(Filename, MB, jobs, summary);
+
+  llvm::outs() << "replayed queries = " << summary.queries << '\n'
+               << "unreadable queries = " << summary.unreadable << '\n'
+               << "failed queries = " << summary.failures << '\n'
+               << "disagreeing answers = " << summary.disagreements << '\n'
+               << "logged solver time (us) = " << summary.loggedMicroseconds
+               << '\n'
+               << "replayed solver time (us) = "
+               << summary.replayedMicroseconds << '\n';
+  if (summary.queries) {
+    llvm::outs() << "mean latency (us) = "
+                 << summary.replayedMicroseconds / summary.queries << '\n'
+                 << "p50 latency (us) < " << summary.percentile(0.5) << '\n'
+                 << "p90 latency (us) < " << summary.percentile(0.9) << '\n'
+                 << "p99 latency (us) < " << summary.percentile(0.99) << '\n'
+                 << "max latency (us) = " << summary.slowestMicroseconds
+                 << '\n';
+
+    llvm::outs() << "--\nqueries by operation:\n";
+    for (unsigned i = 0; i < QueryLogOperationCount; ++i) {
+      if (!summary.operations[i])
+        continue;
+      llvm::outs() << "  "
+                   << getQueryLogOperationName(
+                          static_cast<QueryLogOperation>(i))
+                   << ": " << summary.operations[i] << " queries, "
+                   << summary.operationMicroseconds[i] << " us\n";
+    }
+
+    llvm::outs() << "--\nlatency histogram (us):\n";
+    for (unsigned i = 0; i < ReplaySummary::Buckets; ++i) {
+      if (!summary.histogram[i])
+        continue;
+      uint64_t low = i ? uint64_t(1) << i : 0;
+      llvm::outs() << "  [" << low << ", " << (uint64_t(1) << (i + 1))
+                   << "): " << summary.histogram[i] << '\n';
+    }
+  }
+  return success && !summary.malformed;
+}
+
 int main(int argc, char **argv) {
 #if LLVM_VERSION_CODE >= LLVM_VERSION(13, 0)
   KCommandLine::HideOptions(llvm::cl::getGeneralCategory());
@@ -440,6 +741,10 @@ int main(int argc, char **argv) {
     success = printInputAsSMTLIBv2(
         InputFile == "-" ? "<stdin>" : InputFile.c_str(), MB.get(), Builder);
     break;
+  case ReplayQueryLog:
+    success = replayInputLog(InputFile == "-" ? "<stdin>" : InputFile.c_str(),
+                             MB.get());
+    break;
   default:
     llvm::errs() << argv[0] << ": error: Unknown program action!\n";
   }
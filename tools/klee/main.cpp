@@ -15,6 +15,7 @@
 #include "klee/Core/Context.h"
 #include "klee/Core/Interpreter.h"
 #include "klee/Core/TargetedExecutionReporter.h"
+#include "klee/Expr/Expr.h"
 #include "klee/Module/LocationInfo.h"
 #include "klee/Module/SarifReport.h"
 #include "klee/Solver/SolverCmdLine.h"
@@ -2467,6 +2468,7 @@ int main(int argc, char **argv, char **envp) {
                            << "\n"
                            << "KLEE: done: query cex = " << queryCounterexamples
                            << "\n";
+  Expr::printAllocationStats(handler->getInfoStream());
 
   std::stringstream stats;
   stats << '\n'
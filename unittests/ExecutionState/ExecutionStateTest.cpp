@@ -0,0 +1,107 @@
+//===-- ExecutionStateTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "Core/ExecutionState.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Module/Cell.h"
+#include "klee/Module/KModule.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+TEST(ExecutionStateTest, MemoryLimitVictims) {
+  ExecutionState cold, recent, covering, warm;
+  cold.lastSelected = 1;
+  covering.lastSelected = 2;
+  warm.lastSelected = 3;
+  recent.lastSelected = 5;
+  covering.coverNew();
+
+  std::vector<ExecutionState *> states{&recent, &covering, &warm, &cold};
+  std::sort(states.begin(), states.end(), ExecutionStateColdCompare());
+  std::vector<ExecutionState *> expected{&cold, &warm, &recent, &covering};
+  EXPECT_EQ(expected, states);
+
+  // Killing two of them, as checkMemoryUsage does, spares the recently
+  // selected state and the one which covered new code
+  std::vector<ExecutionState *> victims{&covering, &recent, &cold, &warm};
+  std::nth_element(victims.begin(), victims.begin() + 1, victims.end(),
+                   ExecutionStateColdCompare());
+  victims.resize(2);
+  EXPECT_EQ(1, std::count(victims.begin(), victims.end(), &cold));
+  EXPECT_EQ(1, std::count(victims.begin(), victims.end(), &warm));
+}
+
+TEST(ExecutionStateTest, CopiesDoNotShareWrites) {
+  // void f(i32, i32), whose frame has a register per argument
+  llvm::LLVMContext context;
+  llvm::Module module("copies", context);
+  llvm::Type *int32 = llvm::Type::getInt32Ty(context);
+  llvm::Function *f = llvm::Function::Create(
+      llvm::FunctionType::get(llvm::Type::getVoidTy(context), {int32, int32},
+                              false),
+      llvm::Function::ExternalLinkage, "f", module);
+  llvm::ReturnInst::Create(context, llvm::BasicBlock::Create(context, "", f));
+  unsigned globalIndex = 0;
+  KFunction kf(f, nullptr, globalIndex);
+
+  ref<Expr> one = ConstantExpr::create(1, Expr::Int32);
+  ref<Expr> two = ConstantExpr::create(2, Expr::Int32);
+  ExecutionState state;
+  state.pushFrame(KInstIterator(), &kf);
+  state.stack.valueStack().back().setLocal(0, Cell(one));
+  state.coveredLines.replace({"f.c", PersistentSet<unsigned>()});
+  state.arrayNames.replace({"x", 1});
+
+  std::unique_ptr<ExecutionState> copy(state.copy());
+  StackFrame &frame = state.stack.valueStack().back();
+  StackFrame &copyFrame = copy->stack.valueStack().back();
+  // Until one of them writes, the registers are shared
+  EXPECT_EQ(frame.locals, copyFrame.locals);
+
+  copyFrame.setLocal(0, Cell(two));
+  copyFrame.setLocal(1, Cell(one));
+  EXPECT_EQ(one, frame.locals->at(0).value);
+  EXPECT_TRUE(frame.locals->at(1).value.isNull());
+  EXPECT_EQ(two, copyFrame.locals->at(0).value);
+  EXPECT_EQ(one, copyFrame.locals->at(1).value);
+
+  // The original writing after the copy leaves the copy alone as well
+  frame.setLocal(1, Cell(two));
+  EXPECT_EQ(one, copyFrame.locals->at(1).value);
+
+  PersistentSet<unsigned> lines;
+  lines.insert(3);
+  copy->coveredLines.replace({"f.c", lines});
+  copy->coveredLines.replace({"g.c", lines});
+  copy->arrayNames.replace({"x", 2});
+  copy->arrayNames.replace({"y", 1});
+  EXPECT_TRUE(state.coveredLines.at("f.c").empty());
+  EXPECT_EQ(0u, state.coveredLines.count("g.c"));
+  EXPECT_EQ(1u, state.arrayNames.at("x"));
+  EXPECT_EQ(0u, state.arrayNames.count("y"));
+  EXPECT_EQ(1u, copy->coveredLines.at("f.c").count(3));
+  EXPECT_EQ(2u, copy->arrayNames.at("x"));
+}
+
+} // namespace
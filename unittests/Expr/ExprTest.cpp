@@ -9,10 +9,13 @@
 
 #include "gtest/gtest.h"
 
+#include "klee/ADT/Bits.h"
 #include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/SourceBuilder.h"
 
+#include <vector>
+
 using namespace klee;
 
 namespace {
@@ -287,4 +290,149 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+TEST(ExprTest, AllocationStats) {
+  const Array *array =
+      Array::create(ConstantExpr::create(4, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("alloc_arr", 0));
+  ref<Expr> read = Expr::createTempRead(array, Expr::Int8);
+  ref<Expr> sum = AddExpr::create(read, getConstant(3, Expr::Int8));
+  UpdateList ul(array, nullptr);
+  ul.extend(getConstant(0, Expr::Int32), getConstant(1, Expr::Int8));
+
+  std::string stats;
+  llvm::raw_string_ostream os(stats);
+  Expr::printAllocationStats(os);
+  os.flush();
+  EXPECT_NE(std::string::npos, stats.find("expr bytes allocated (Add) = "));
+  EXPECT_NE(std::string::npos,
+            stats.find("expr bytes allocated (UpdateNode) = "));
+  EXPECT_LT(0u, UpdateNode::allocatedBytes());
+}
+
+TEST(ExprTest, SmallConstantInterning) {
+  ref<ConstantExpr> a = ConstantExpr::create(42, Expr::Int32);
+  EXPECT_EQ(a.get(), ConstantExpr::create(42, Expr::Int32).get());
+  EXPECT_EQ(a.get(), ConstantExpr::alloc(llvm::APInt(32, 42)).get());
+  // Equal values of other widths are distinct constants
+  EXPECT_NE(a.get(), ConstantExpr::create(42, Expr::Int64).get());
+  EXPECT_EQ(a.get(), ConstantExpr::create(40, Expr::Int32)
+                         ->Add(ConstantExpr::create(2, Expr::Int32))
+                         .get());
+
+  // A released constant is rebuilt rather than found in a stale slot
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ref<ConstantExpr> value = ConstantExpr::create(i, Expr::Int64);
+    EXPECT_EQ(i, value->getZExtValue());
+    EXPECT_EQ(Expr::Int64, value->getWidth());
+  }
+  ref<ConstantExpr> wide = ConstantExpr::alloc(llvm::APInt(128, 42));
+  EXPECT_EQ(Expr::Int128, wide->getWidth());
+}
+
+const Expr::Kind evaluatedKinds[] = {
+    Expr::Add, Expr::Sub,  Expr::Mul,  Expr::UDiv, Expr::SDiv, Expr::URem,
+    Expr::SRem, Expr::And, Expr::Or,   Expr::Xor,  Expr::Shl,  Expr::LShr,
+    Expr::AShr, Expr::Eq,  Expr::Ne,   Expr::Ult,  Expr::Ule,  Expr::Ugt,
+    Expr::Uge,  Expr::Slt, Expr::Sle,  Expr::Sgt,  Expr::Sge};
+
+ref<ConstantExpr> build(Expr::Kind kind, const ref<ConstantExpr> &left,
+                        const ref<ConstantExpr> &right) {
+  switch (kind) {
+  case Expr::Add:
+    return left->Add(right);
+  case Expr::Sub:
+    return left->Sub(right);
+  case Expr::Mul:
+    return left->Mul(right);
+  case Expr::UDiv:
+    return left->UDiv(right);
+  case Expr::SDiv:
+    return left->SDiv(right);
+  case Expr::URem:
+    return left->URem(right);
+  case Expr::SRem:
+    return left->SRem(right);
+  case Expr::And:
+    return left->And(right);
+  case Expr::Or:
+    return left->Or(right);
+  case Expr::Xor:
+    return left->Xor(right);
+  case Expr::Shl:
+    return left->Shl(right);
+  case Expr::LShr:
+    return left->LShr(right);
+  case Expr::AShr:
+    return left->AShr(right);
+  case Expr::Eq:
+    return left->Eq(right);
+  case Expr::Ne:
+    return left->Ne(right);
+  case Expr::Ult:
+    return left->Ult(right);
+  case Expr::Ule:
+    return left->Ule(right);
+  case Expr::Ugt:
+    return left->Ugt(right);
+  case Expr::Uge:
+    return left->Uge(right);
+  case Expr::Slt:
+    return left->Slt(right);
+  case Expr::Sle:
+    return left->Sle(right);
+  case Expr::Sgt:
+    return left->Sgt(right);
+  case Expr::Sge:
+    return left->Sge(right);
+  default:
+    return nullptr;
+  }
+}
+
+TEST(ExprTest, EvaluateMatchesBuilders) {
+  for (Expr::Width width : {1u, 3u, 8u, 16u, 32u, 33u, 64u}) {
+    uint64_t mask = bits64::maxValueOfNBits(width);
+    uint64_t signBit = 1ULL << (width - 1);
+    // Shift amounts around the width, and the signed and unsigned extremes
+    std::vector<uint64_t> values{0,
+                                 1,
+                                 2,
+                                 width - 1,
+                                 width,
+                                 width + 1,
+                                 signBit - 1,
+                                 signBit,
+                                 signBit + 1,
+                                 mask - 1,
+                                 mask,
+                                 0x5a5a5a5a5a5a5a5aULL};
+    for (uint64_t &value : values)
+      value &= mask;
+
+    for (Expr::Kind kind : evaluatedKinds) {
+      for (uint64_t a : values) {
+        for (uint64_t b : values) {
+          ref<ConstantExpr> result = ConstantExpr::evaluate(kind, width, a, b);
+          bool divides = kind == Expr::UDiv || kind == Expr::SDiv ||
+                         kind == Expr::URem || kind == Expr::SRem;
+          if (divides && !b) {
+            EXPECT_TRUE(result.isNull()) << kind << " by zero";
+            continue;
+          }
+          ref<ConstantExpr> expected =
+              build(kind, ConstantExpr::create(a, width),
+                    ConstantExpr::create(b, width));
+          ASSERT_FALSE(result.isNull()) << kind;
+          EXPECT_EQ(expected->getWidth(), result->getWidth()) << kind;
+          EXPECT_EQ(expected->getZExtValue(), result->getZExtValue())
+              << "kind " << kind << ", width " << width << ": " << a << ", "
+              << b;
+        }
+      }
+    }
+  }
+
+  EXPECT_TRUE(ConstantExpr::evaluate(Expr::Concat, 8, 1, 2).isNull());
+  EXPECT_TRUE(ConstantExpr::evaluate(Expr::FAdd, 32, 1, 2).isNull());
+}
 } // namespace
@@ -0,0 +1,73 @@
+//===-- InterningTableTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/InterningTable.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+struct InternedItem {
+  unsigned hash;
+  uint64_t value;
+};
+
+struct InternedItemHash {
+  unsigned operator()(const InternedItem *item) const { return item->hash; }
+};
+
+struct InternedItemCmp {
+  bool operator()(const InternedItem *a, const InternedItem *b) const {
+    return a->value == b->value;
+  }
+};
+
+using ItemTable =
+    InterningTable<InternedItem, InternedItemHash, InternedItemCmp>;
+
+TEST(InterningTableTest, InsertEraseClear) {
+  ItemTable table;
+  // Few distinct hashes force long probe sequences
+  std::vector<InternedItem> items, duplicates;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    items.push_back({static_cast<unsigned>(i % 7), i});
+    duplicates.push_back({static_cast<unsigned>(i % 7), i});
+  }
+
+  for (auto &item : items)
+    EXPECT_TRUE(table.insert(&item).second);
+  EXPECT_EQ(items.size(), table.size());
+  for (size_t i = 0; i < duplicates.size(); ++i) {
+    auto interned = table.insert(&duplicates[i]);
+    EXPECT_FALSE(interned.second);
+    EXPECT_EQ(&items[i], interned.first);
+  }
+
+  // Removal is by identity, so equal but different objects stay
+  EXPECT_FALSE(table.erase(&duplicates[0]));
+  for (size_t i = 0; i < items.size(); i += 2)
+    EXPECT_TRUE(table.erase(&items[i]));
+  EXPECT_EQ(items.size() / 2, table.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    auto interned = table.insert(&duplicates[i]);
+    EXPECT_EQ(i % 2 == 0, interned.second);
+    EXPECT_EQ(i % 2 == 0 ? &duplicates[i] : &items[i], interned.first);
+  }
+
+  size_t cleared = 0;
+  table.clear([&cleared](InternedItem *) { ++cleared; });
+  EXPECT_EQ(items.size(), cleared);
+  EXPECT_TRUE(table.empty());
+}
+
+} // namespace
@@ -0,0 +1,170 @@
+//===-- MemoryTest.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "Core/AddressBounds.h"
+#include "Core/Memory.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> size(uint64_t n) { return ConstantExpr::create(n, Expr::Int64); }
+
+ref<Expr> symbolicAddress() {
+  const Array *array =
+      Array::create(size(8), SourceBuilder::makeSymbolic("address", 0));
+  return Expr::createTempRead(array, Expr::Int64);
+}
+
+TEST(MemoryTest, AllocationSiteProfile) {
+  AllocationSiteProfile profile;
+
+  // Until the site has been seen enough, objects are kept in dense arrays
+  profile.allocated(size(1024));
+  EXPECT_EQ(profile.choose(size(1024)), MemoryType::Fixed);
+  EXPECT_FALSE(profile.isWarm());
+  for (unsigned i = 1; i < 8; ++i)
+    profile.allocated(size(1024));
+  EXPECT_TRUE(profile.isWarm());
+
+  // Objects which were mostly written stay dense
+  for (unsigned i = 0; i < 8 * 1024; ++i)
+    profile.written(false);
+  EXPECT_EQ(profile.choose(size(1024)), MemoryType::Fixed);
+  EXPECT_EQ(profile.choose(size(16)), MemoryType::Fixed);
+
+  // Dense objects copied by forked states share their pages
+  profile.copies = 8;
+  profile.copiedEntries = 1024;
+  profile.copiedBytes = 2048;
+  EXPECT_EQ(profile.choose(size(1024)), MemoryType::Paged);
+
+  // Sparse ones move to persistent maps
+  profile.copiedBytes = 8 * 1024;
+  EXPECT_EQ(profile.choose(size(1024)), MemoryType::Persistent);
+  profile.copies = 0;
+  EXPECT_EQ(profile.choose(size(1024)), MemoryType::Dynamic);
+
+  // Symbolic sizes always use maps
+  const Array *array =
+      Array::create(size(8), SourceBuilder::makeSymbolic("size", 0));
+  ref<Expr> symbolicSize = Expr::createTempRead(array, Expr::Int64);
+  EXPECT_EQ(profile.choose(symbolicSize), MemoryType::Dynamic);
+}
+
+TEST(MemoryTest, MixedMemoryType) {
+  EXPECT_EQ(mixedMemoryType(MaxFixedSizeStructureSize), MemoryType::Fixed);
+  EXPECT_EQ(mixedMemoryType(MaxFixedSizeStructureSize + 1), MemoryType::Paged);
+  EXPECT_EQ(mixedMemoryType(MaxPagedStructureSize), MemoryType::Paged);
+  // Large objects are not paged, copying their page tables would cost more
+  // than sharing a persistent map
+  EXPECT_EQ(mixedMemoryType(MaxPagedStructureSize + 1),
+            MemoryType::Persistent);
+}
+
+TEST(MemoryTest, SetMemoryType) {
+  ObjectStage stage(size(256), nullptr, true, Expr::Int8, MemoryType::Fixed);
+  stage.initializeToZero();
+  for (unsigned i = 0; i < 256; i += 16)
+    stage.writeWidth(i, static_cast<uint64_t>(i + 1));
+  EXPECT_EQ(stage.getKnownBytes(), 16u);
+
+  for (MemoryType type : {MemoryType::Persistent, MemoryType::Paged,
+                          MemoryType::Dynamic, MemoryType::Fixed}) {
+    stage.setMemoryType(type);
+    EXPECT_EQ(stage.getMemoryType(), type);
+    EXPECT_EQ(stage.getKnownBytes(), 16u);
+    for (unsigned i = 0; i < 256; i += 16) {
+      auto byte = dyn_cast<ConstantExpr>(stage.readWidth(i));
+      ASSERT_TRUE(byte);
+      EXPECT_EQ(byte->getZExtValue(), i + 1);
+    }
+  }
+}
+
+TEST(MemoryTest, AddressBoundsOverlapping) {
+  ref<Expr> address = symbolicAddress();
+  AddressBounds bounds(Expr::Int64);
+  bounds.constrain(UleExpr::alloc(size(10), address), address, true);
+  bounds.constrain(UleExpr::alloc(address, size(20)), address, true);
+  bounds.constrain(UltExpr::alloc(address, size(15)), address, true);
+  EXPECT_EQ(10u, bounds.min);
+  EXPECT_EQ(14u, bounds.max);
+  EXPECT_TRUE(bounds.contains(10));
+  EXPECT_TRUE(bounds.contains(14));
+  EXPECT_FALSE(bounds.contains(9));
+  EXPECT_FALSE(bounds.contains(15));
+
+  // A constraint which does not hold bounds the address the other way
+  bounds.constrain(UltExpr::alloc(address, size(11)), address, false);
+  EXPECT_EQ(11u, bounds.min);
+  bounds.constrain(NotExpr::alloc(UltExpr::alloc(address, size(12))), address,
+                   true);
+  EXPECT_EQ(12u, bounds.min);
+  EXPECT_EQ(14u, bounds.max);
+
+  // Disequalities and comparisons of other expressions leave the bounds alone
+  bounds.constrain(
+      UltExpr::alloc(AddExpr::alloc(address, size(1)), size(12)), address,
+      true);
+  bounds.constrain(EqExpr::alloc(address, size(13)), address, false);
+  EXPECT_EQ(12u, bounds.min);
+  EXPECT_EQ(14u, bounds.max);
+  EXPECT_FALSE(bounds.empty());
+
+  // Known values are filtered by the bounds
+  AddressBounds values(Expr::Int64);
+  values.values = {4, 8, 16};
+  values.min = 4;
+  values.max = 16;
+  values.exact = true;
+  values.constrain(UltExpr::alloc(size(4), address), address, true);
+  values.constrain(UltExpr::alloc(address, size(16)), address, true);
+  EXPECT_FALSE(values.contains(4));
+  EXPECT_TRUE(values.contains(8));
+  EXPECT_FALSE(values.contains(12));
+  EXPECT_FALSE(values.contains(16));
+}
+
+TEST(MemoryTest, AddressBoundsDisjoint) {
+  ref<Expr> address = symbolicAddress();
+  AddressBounds bounds(Expr::Int64);
+  bounds.constrain(UltExpr::alloc(address, size(10)), address, true);
+  bounds.constrain(UltExpr::alloc(size(20), address), address, true);
+  EXPECT_TRUE(bounds.empty());
+  EXPECT_FALSE(bounds.contains(5));
+  EXPECT_FALSE(bounds.contains(25));
+
+  AddressBounds equal(Expr::Int64);
+  equal.constrain(EqExpr::alloc(address, size(5)), address, true);
+  EXPECT_FALSE(equal.empty());
+  EXPECT_TRUE(equal.contains(5));
+  equal.constrain(EqExpr::alloc(address, size(7)), address, true);
+  EXPECT_TRUE(equal.empty());
+}
+
+TEST(MemoryTest, AddressBoundsEmpty) {
+  ref<Expr> address = symbolicAddress();
+  AddressBounds below(Expr::Int64);
+  EXPECT_FALSE(below.empty());
+  below.constrain(UltExpr::alloc(address, size(0)), address, true);
+  EXPECT_TRUE(below.empty());
+  EXPECT_FALSE(below.contains(0));
+
+  AddressBounds above(Expr::Int64);
+  above.constrain(UltExpr::alloc(size(UINT64_MAX), address), address, true);
+  EXPECT_TRUE(above.empty());
+  EXPECT_FALSE(above.contains(UINT64_MAX));
+}
+
+} // namespace
@@ -0,0 +1,76 @@
+#include "klee/ADT/PrefixTrie.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace klee;
+
+TEST(PrefixTrieTest, Find) {
+  PrefixTrie<int, int> trie;
+  int value;
+  bool isPrefix;
+  std::vector<int> query{1, 2, 3, 4};
+  ASSERT_FALSE(trie.find(query.begin(), query.end(), value, isPrefix));
+
+  std::vector<int> a{1, 2}, b{1, 2, 5, 6, 7}, c{1, 2, 5}, d{9};
+  trie.insert(b.begin(), b.end(), 2);
+  trie.insert(c.begin(), c.end(), 3);
+  trie.insert(d.begin(), d.end(), 4);
+  ASSERT_EQ(3u, trie.size());
+
+  // No sequence is a prefix, [1, 2, 5] is the shortest below [1, 2]
+  ASSERT_TRUE(trie.find(query.begin(), query.end(), value, isPrefix));
+  EXPECT_FALSE(isPrefix);
+  EXPECT_EQ(3, value);
+
+  trie.insert(a.begin(), a.end(), 1);
+  ASSERT_TRUE(trie.find(query.begin(), query.end(), value, isPrefix));
+  EXPECT_TRUE(isPrefix);
+  EXPECT_EQ(1, value);
+
+  trie.erase(1);
+  trie.erase(3);
+  ASSERT_TRUE(trie.find(query.begin(), query.end(), value, isPrefix));
+  EXPECT_FALSE(isPrefix);
+  EXPECT_EQ(2, value);
+
+  // Longest prefix wins over shorter ones
+  std::vector<int> longQuery{1, 2, 5, 6, 7, 8};
+  trie.insert(c.begin(), c.end(), 3);
+  ASSERT_TRUE(trie.find(longQuery.begin(), longQuery.end(), value, isPrefix));
+  EXPECT_TRUE(isPrefix);
+  EXPECT_EQ(2, value);
+
+  trie.erase(2);
+  trie.erase(3);
+  trie.erase(4);
+  ASSERT_TRUE(trie.empty());
+  ASSERT_FALSE(trie.find(query.begin(), query.end(), value, isPrefix));
+}
+
+TEST(PrefixTrieTest, Candidates) {
+  PrefixTrie<int, int> trie;
+  std::vector<int> query{1, 2, 3, 4}, result;
+  trie.candidates(query.begin(), query.end(), result);
+  ASSERT_TRUE(result.empty());
+
+  std::vector<int> a{1}, b{1, 2, 5, 6, 7, 8}, c{1, 2, 3, 9}, d{9, 9};
+  trie.insert(a.begin(), a.end(), 1);
+  trie.insert(b.begin(), b.end(), 2);
+  trie.insert(c.begin(), c.end(), 3);
+  trie.insert(d.begin(), d.end(), 4);
+
+  // [1] is a prefix and [1, 2, 3, 9] shares the longest prefix; the others
+  // are never the closest value of a node on the shared prefix
+  trie.candidates(query.begin(), query.end(), result);
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ((std::vector<int>{1, 3}), result);
+
+  // Without [1], [9, 9] is the shortest sequence below the root
+  trie.erase(1);
+  result.clear();
+  trie.candidates(query.begin(), query.end(), result);
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ((std::vector<int>{3, 4}), result);
+}
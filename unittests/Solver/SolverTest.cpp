@@ -9,12 +9,27 @@
 
 #include "gtest/gtest.h"
 
+#include "klee/Config/config.h"
 #include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/SourceBuilder.h"
+#include "klee/Solver/QueryLog.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverCmdLine.h"
+#include "klee/Solver/SolverStats.h"
+#ifdef HAVE_ZLIB_H
+#include "klee/Support/CompressionStream.h"
+#endif
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unistd.h>
 
 using namespace klee;
 
@@ -158,4 +173,728 @@ TEST(SolverTest, Evaluation) {
   testOpcode<SgeExpr>(*solver);
 }
 
+TEST(SolverTest, QueryLogRoundTrip) {
+  const Array *array =
+      Array::create(ConstantExpr::create(4, Expr::Int64),
+                    SourceBuilder::makeSymbolic("logged", 0));
+  SparseStorageImpl<ref<ConstantExpr>> contents(
+      ConstantExpr::create(0, Expr::Int8));
+  contents.store(1, ConstantExpr::create(7, Expr::Int8));
+  const Array *table =
+      Array::create(ConstantExpr::create(2, Expr::Int64),
+                    SourceBuilder::constant(contents.clone()));
+
+  ref<Expr> x = Expr::createTempRead(array, Expr::Int32);
+  ref<Expr> index = ExtractExpr::create(x, 0, Expr::Int32);
+  UpdateList updates(array, nullptr);
+  updates.extend(index, ConstantExpr::create(3, Expr::Int8));
+  ref<Expr> written = ReadExpr::create(updates, ConstantExpr::create(1, 32));
+  ref<Expr> looked = ReadExpr::create(UpdateList(table, nullptr), index);
+
+  constraints_ty constraints;
+  constraints.insert(UltExpr::create(x, ConstantExpr::create(2, Expr::Int32)));
+  ref<Expr> first = EqExpr::create(ZExtExpr::create(written, Expr::Int32),
+                                   ZExtExpr::create(looked, Expr::Int32));
+  ref<Expr> second = UltExpr::create(looked, written);
+
+  std::string log;
+  llvm::raw_string_ostream os(log);
+  QueryLogWriter writer(os);
+  QueryLogOutcome outcome;
+  outcome.success = true;
+  outcome.hasAnswer = true;
+  outcome.answer = -1;
+  outcome.elapsed = time::microseconds(1500);
+  writer.write(QueryLogOperation::Validity, Query(constraints, first), {}, {},
+               outcome);
+  size_t firstSize = os.str().size();
+  writer.write(QueryLogOperation::InitialValues, Query(constraints, second),
+               {}, {array}, QueryLogOutcome());
+  // The second query only adds its own expression
+  EXPECT_LT(os.str().size() - firstSize, firstSize / 2);
+
+  QueryLogReader reader(os.str());
+  LoggedQuery logged;
+  ASSERT_TRUE(reader.next(logged));
+  EXPECT_EQ(QueryLogOperation::Validity, logged.operation);
+  EXPECT_EQ(constraints, logged.constraints);
+  EXPECT_EQ(first, logged.expr);
+  EXPECT_TRUE(logged.outcome.success);
+  EXPECT_EQ(-1, logged.outcome.answer);
+  EXPECT_EQ(1500u, logged.outcome.elapsed.toMicroseconds());
+
+  ASSERT_TRUE(reader.next(logged));
+  EXPECT_EQ(QueryLogOperation::InitialValues, logged.operation);
+  EXPECT_EQ(second, logged.expr);
+  ASSERT_EQ(1u, logged.objects.size());
+  EXPECT_EQ(array, logged.objects[0]);
+  EXPECT_FALSE(logged.outcome.success);
+
+  EXPECT_FALSE(reader.next(logged));
+  EXPECT_TRUE(reader.getError().empty());
+  EXPECT_EQ(0u, reader.getUnreadable());
+}
+
+/// A symbolic byte array of the given size
+const Array *makeArray(const std::string &name, uint64_t size = 1) {
+  return Array::create(ConstantExpr::create(size, sizeof(uint64_t) * CHAR_BIT),
+                       SourceBuilder::makeSymbolic(name, 0));
+}
+
+ref<Expr> byteIs(ref<Expr> byte, uint64_t value) {
+  return EqExpr::create(byte, ConstantExpr::create(value, Expr::Int8));
+}
+
+std::unique_ptr<Solver> createTestSolver(CoreSolverType type) {
+  std::unique_ptr<Solver> solver = createCoreSolver(type);
+  solver->setCoreSolverTimeout(time::Span("10s"));
+  return solver;
+}
+
+std::unique_ptr<Solver> createTestSolver() {
+  return createTestSolver(CoreSolverToUse);
+}
+
+/// Whether the configured core solver keeps translated terms and pools
+/// tree-incremental solvers
+bool hasIncrementalBackend() {
+  return CoreSolverToUse == Z3_SOLVER || CoreSolverToUse == Z3_TREE_SOLVER ||
+         CoreSolverToUse == BITWUZLA_SOLVER ||
+         CoreSolverToUse == BITWUZLA_TREE_SOLVER;
+}
+
+/// A unique temporary file name, the file itself does not exist
+std::string makeTemporaryPath(const char *prefix) {
+  std::string path = std::string("/tmp/") + prefix + "-XXXXXX";
+  int fd = mkstemp(&path[0]);
+  EXPECT_NE(-1, fd);
+  close(fd);
+  unlink(path.c_str());
+  return path;
+}
+
+#ifdef HAVE_ZLIB_H
+TEST(SolverTest, QueryLogSyncedCompressed) {
+  std::string path = makeTemporaryPath("klee-query-log");
+  ref<Expr> byte = Expr::createTempRead(makeArray("synced"), Expr::Int8);
+  std::string error;
+  compressed_fd_ostream os(path, error);
+  ASSERT_TRUE(error.empty());
+  QueryLogWriter writer(os);
+  writer.write(QueryLogOperation::Truth,
+               Query(constraints_ty{}, byteIs(byte, 1)), {}, {},
+               QueryLogOutcome());
+  os.sync();
+
+  // The compressed stream is not finished, as if KLEE had crashed
+  std::ifstream in(path, std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  QueryLogReader reader(contents);
+  LoggedQuery logged;
+  ASSERT_TRUE(reader.next(logged));
+  EXPECT_EQ(QueryLogOperation::Truth, logged.operation);
+  EXPECT_EQ(byteIs(byte, 1), logged.expr);
+  EXPECT_FALSE(reader.next(logged));
+
+  unlink(path.c_str());
+}
+#endif
+
+TEST(SolverTest, PersistentCachingSolver) {
+  std::string path = makeTemporaryPath("klee-query-cache");
+  const Array *array = makeArray("cached");
+  ref<Expr> isFive = byteIs(Expr::createTempRead(array, Expr::Int8), 5);
+  constraints_ty fixed{isFive};
+  std::vector<const Array *> objects{array};
+  PartialValidity validity;
+  std::vector<SparseStorageImpl<unsigned char>> values;
+
+  {
+    std::unique_ptr<Solver> solver =
+        createPersistentCachingSolver(createTestSolver(), path);
+    ASSERT_TRUE(solver->evaluate(Query(fixed, isFive), validity));
+    ASSERT_TRUE(solver->getInitialValues(
+        Query(fixed, ConstantExpr::alloc(0, Expr::Bool)), objects, values));
+  }
+
+  // A warm cache answers without consulting the (failing) underlying solver
+  uint64_t hits = stats::queryPersistentCacheHits;
+  std::unique_ptr<Solver> solver =
+      createPersistentCachingSolver(createDummySolver(), path);
+  ASSERT_TRUE(solver->evaluate(Query(fixed, isFive), validity));
+  EXPECT_EQ(PValidity::MustBeTrue, validity);
+  values.clear();
+  ASSERT_TRUE(solver->getInitialValues(
+      Query(fixed, ConstantExpr::alloc(0, Expr::Bool)), objects, values));
+  ASSERT_EQ(1u, values.size());
+  EXPECT_EQ(5, values[0].load(0));
+  EXPECT_EQ(hits + 2, stats::queryPersistentCacheHits.getValue());
+
+  // A record torn by a failed writer is dropped before the next one is
+  // appended, and a lost index is rebuilt from the file
+  ref<Expr> isSix = byteIs(Expr::createTempRead(array, Expr::Int8), 6);
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    const char torn[28] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                           15, 16, 100, 0, 0, 0, 0, 0, 0, 0, 42};
+    file.write(torn, sizeof(torn));
+  }
+  solver = createPersistentCachingSolver(createTestSolver(), path);
+  ASSERT_TRUE(solver->evaluate(Query(fixed, isSix), validity));
+  unlink((path + ".index").c_str());
+  solver = createPersistentCachingSolver(createDummySolver(), path);
+  ASSERT_TRUE(solver->evaluate(Query(fixed, isSix), validity));
+  EXPECT_EQ(PValidity::MustBeFalse, validity);
+  ASSERT_TRUE(solver->evaluate(Query(fixed, isFive), validity));
+  EXPECT_EQ(PValidity::MustBeTrue, validity);
+
+  // A record with a garbage size ends the usable part of the file, but the
+  // answers before it are still served
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    const char garbage[28] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                              15, 16, -1, -1, -1, -1, 0, 0, 0, 0, 42};
+    file.write(garbage, sizeof(garbage));
+  }
+  solver = createPersistentCachingSolver(createDummySolver(), path);
+  ASSERT_TRUE(solver->evaluate(Query(fixed, isFive), validity));
+  EXPECT_EQ(PValidity::MustBeTrue, validity);
+  unlink(path.c_str());
+  unlink((path + ".index").c_str());
+
+  // A file without the cache header is not used
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "not a query cache";
+  }
+  solver = createPersistentCachingSolver(createDummySolver(), path);
+  EXPECT_FALSE(solver->evaluate(Query(fixed, isFive), validity));
+  unlink(path.c_str());
+}
+
+TEST(SolverTest, TreeSolverPool) {
+  CoreSolverType type = CoreSolverToUse == BITWUZLA_SOLVER ||
+                                CoreSolverToUse == BITWUZLA_TREE_SOLVER
+                            ? BITWUZLA_TREE_SOLVER
+                            : Z3_TREE_SOLVER;
+  if (!hasIncrementalBackend())
+    GTEST_SKIP() << "no tree-incremental core solver";
+  MaxSolversApproxTreeInc = 2;
+  std::unique_ptr<Solver> solver = createTestSolver(type);
+  MaxSolversApproxTreeInc = 0;
+
+  ref<Expr> byte = Expr::createTempRead(makeArray("pooled"), Expr::Int8);
+  ref<Expr> isFive = byteIs(byte, 5);
+  ref<Expr> isSmall =
+      UltExpr::create(byte, ConstantExpr::create(10, Expr::Int8));
+  ref<Expr> isLarge =
+      UgtExpr::create(byte, ConstantExpr::create(20, Expr::Int8));
+
+  constraints_ty small{isSmall}, smallFive{isSmall, isFive}, large{isLarge};
+  PartialValidity validity;
+  uint64_t reused = stats::queryReusedSolvers;
+  // Alternate between diverging paths, so pooled solvers get reused
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_TRUE(solver->evaluate(Query(small, isFive), validity));
+    EXPECT_EQ(PValidity::TrueOrFalse, validity);
+    ASSERT_TRUE(solver->evaluate(Query(smallFive, isFive), validity));
+    EXPECT_EQ(PValidity::MustBeTrue, validity);
+    ASSERT_TRUE(solver->evaluate(Query(large, isFive), validity));
+    EXPECT_EQ(PValidity::MustBeFalse, validity);
+  }
+  // Once both solvers are pooled, every query is answered by one of them
+  EXPECT_LE(reused + 7, stats::queryReusedSolvers.getValue());
+}
+
+TEST(SolverTest, IndependentFactorCache) {
+  std::unique_ptr<Solver> solver = createIndependentSolver(createTestSolver());
+  solver->setCoreSolverTimeout(time::Span("10s"));
+
+  const Array *a = makeArray("factorA");
+  const Array *b = makeArray("factorB");
+  constraints_ty constraints{byteIs(Expr::createTempRead(a, Expr::Int8), 5),
+                             byteIs(Expr::createTempRead(b, Expr::Int8), 7)};
+  std::vector<const Array *> objects{a, b};
+  auto solve = [&]() {
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    ASSERT_TRUE(solver->getInitialValues(
+        Query(ConstraintSet(constraints), ConstantExpr::alloc(0, Expr::Bool),
+              /*id=*/1),
+        objects, values));
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ(5, values[0].load(0));
+    EXPECT_EQ(7, values[1].load(0));
+  };
+
+  uint64_t hits = 0, queries = 0;
+  for (unsigned i = 0; i < 2; ++i) {
+    hits = stats::queryFactorCacheHits;
+    queries = stats::solverQueries;
+    solve();
+  }
+  // Both factors of the second query were answered from the cache, without
+  // asking the core solver again
+  EXPECT_EQ(hits + 2, stats::queryFactorCacheHits.getValue());
+  EXPECT_EQ(queries, stats::solverQueries.getValue());
+
+  // Models outlive the state which stored them, other states reuse them
+  solver->notifyStateTermination(1);
+  hits = stats::queryFactorCacheHits;
+  solve();
+  EXPECT_EQ(hits + 2, stats::queryFactorCacheHits.getValue());
+
+  // Only the most recently used models are kept
+  IndependentFactorCacheSize = 1;
+  auto solveOne = [&](const Array *array, unsigned char value) {
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    ASSERT_TRUE(solver->getInitialValues(
+        Query(constraints_ty{byteIs(Expr::createTempRead(array, Expr::Int8),
+                                    value)},
+              ConstantExpr::alloc(0, Expr::Bool)),
+        {array}, values));
+    ASSERT_EQ(1u, values.size());
+    EXPECT_EQ(value, values[0].load(0));
+  };
+  const Array *c = makeArray("factorC");
+  hits = stats::queryFactorCacheHits;
+  solveOne(c, 3);
+  EXPECT_EQ(hits, stats::queryFactorCacheHits.getValue());
+  solveOne(c, 3);
+  EXPECT_EQ(hits + 1, stats::queryFactorCacheHits.getValue());
+  solveOne(a, 5);
+  EXPECT_EQ(hits + 1, stats::queryFactorCacheHits.getValue());
+  solveOne(a, 5);
+  EXPECT_EQ(hits + 2, stats::queryFactorCacheHits.getValue());
+  IndependentFactorCacheSize = 1 << 14;
+}
+
+TEST(SolverTest, PortfolioSolver) {
+  // The dummy solver fails every query, so the core solver wins every race
+  // and soon answers on its own
+  std::vector<std::unique_ptr<Solver>> solvers;
+  solvers.push_back(createDummySolver());
+  solvers.push_back(createTestSolver());
+  std::unique_ptr<Solver> solver = createPortfolioSolver(std::move(solvers));
+  solver->setCoreSolverTimeout(time::Span("10s"));
+
+  const Array *array = makeArray("raced");
+  ref<Expr> byte = Expr::createTempRead(array, Expr::Int8);
+  std::vector<const Array *> objects{array};
+
+  for (unsigned i = 0; i < 20; ++i) {
+    ref<Expr> isI = byteIs(byte, i);
+    constraints_ty fixed{isI};
+    PartialValidity validity;
+    ASSERT_TRUE(solver->evaluate(Query(fixed, isI), validity));
+    EXPECT_EQ(PValidity::MustBeTrue, validity);
+
+    // Both sides of a branch are decided by one race
+    ref<SolverResponse> isResponse, isNotResponse;
+    ASSERT_TRUE(solver->evaluate(Query(fixed, isI), isResponse, isNotResponse));
+    EXPECT_TRUE(isa<ValidResponse>(isResponse));
+    ASSERT_TRUE(isa<InvalidResponse>(isNotResponse));
+    std::vector<SparseStorageImpl<unsigned char>> model;
+    ASSERT_TRUE(isNotResponse->tryGetInitialValuesFor(objects, model));
+    EXPECT_EQ(i, model[0].load(0));
+
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    ASSERT_TRUE(solver->getInitialValues(
+        Query(fixed, ConstantExpr::alloc(0, Expr::Bool)), objects, values));
+    ASSERT_EQ(1u, values.size());
+    EXPECT_EQ(i, values[0].load(0));
+  }
+
+  if (!hasIncrementalBackend())
+    return;
+  // Cores are the ones of the member which answered, not the whole path
+  ref<Expr> other = Expr::createTempRead(makeArray("raced-other"), Expr::Int8);
+  ref<Expr> below5 = UltExpr::create(byte, ConstantExpr::create(5, Expr::Int8));
+  ref<Expr> below10 =
+      UltExpr::create(byte, ConstantExpr::create(10, Expr::Int8));
+  constraints_ty path{below5, byteIs(other, 3)};
+  ValidityCore core;
+  bool isValid;
+  ASSERT_TRUE(solver->getValidityCore(Query(path, below10), core, isValid));
+  EXPECT_TRUE(isValid);
+  EXPECT_EQ(below10, core.expr);
+  EXPECT_EQ(ValidityCore::constraints_typ{below5}, core.constraints);
+
+  ref<SolverResponse> response;
+  ASSERT_TRUE(solver->check(Query(path, below10), response));
+  ASSERT_TRUE(isa<ValidResponse>(response));
+  EXPECT_EQ(ValidityCore::constraints_typ{below5},
+            cast<ValidResponse>(response)->validityCore().constraints);
+
+  ASSERT_TRUE(solver->check(
+      Query(path, UltExpr::create(byte, ConstantExpr::create(3, Expr::Int8))),
+      response));
+  ASSERT_TRUE(isa<InvalidResponse>(response));
+  std::vector<SparseStorageImpl<unsigned char>> model;
+  ASSERT_TRUE(response->tryGetInitialValuesFor({array}, model));
+  EXPECT_LE(3, model[0].load(0));
+  EXPECT_GT(5, model[0].load(0));
+}
+
+TEST(SolverTest, TimeoutPredictingSolver) {
+  std::string path = makeTemporaryPath("klee-solver-timing");
+  ref<Expr> byte = Expr::createTempRead(makeArray("timed"), Expr::Int8);
+
+  {
+    std::unique_ptr<Solver> solver =
+        createTimeoutPredictingSolver(createTestSolver(), true, path);
+    solver->setCoreSolverTimeout(time::Span("10s"));
+    for (unsigned i = 0; i < 4; ++i) {
+      ref<Expr> isI = byteIs(byte, i);
+      constraints_ty fixed{isI};
+      PartialValidity validity;
+      ASSERT_TRUE(solver->evaluate(Query(fixed, isI), validity));
+      EXPECT_EQ(PValidity::MustBeTrue, validity);
+    }
+  }
+
+  // A version, a header naming the columns and one row per query, giving
+  // its status by name
+  std::ifstream log(path);
+  std::string line;
+  ASSERT_TRUE(static_cast<bool>(std::getline(log, line)));
+  EXPECT_EQ("# klee solver timing log, version 2", line);
+  ASSERT_TRUE(static_cast<bool>(std::getline(log, line)));
+  EXPECT_EQ(0u, line.find("shape,nodes,"));
+  unsigned rows = 0;
+  while (std::getline(log, line)) {
+    std::string status = line.substr(line.rfind(',') + 1);
+    EXPECT_TRUE(status == "solvable" || status == "unsolvable") << status;
+    ++rows;
+  }
+  EXPECT_EQ(4u, rows);
+  log.close();
+
+  // Files which are not timing logs of this version are left alone
+  {
+    std::ofstream old(path);
+    old << "shape,nodes\n1,2\n";
+  }
+  {
+    std::unique_ptr<Solver> solver =
+        createTimeoutPredictingSolver(createTestSolver(), true, path);
+    PartialValidity validity;
+    ASSERT_TRUE(
+        solver->evaluate(Query(constraints_ty{}, byteIs(byte, 0)), validity));
+  }
+  std::ifstream unchanged(path);
+  std::string contents((std::istreambuf_iterator<char>(unchanged)),
+                       std::istreambuf_iterator<char>());
+  EXPECT_EQ("shape,nodes\n1,2\n", contents);
+
+  unlink(path.c_str());
+}
+
+TEST(SolverTest, BatchedFeasibility) {
+  ref<Expr> byte = Expr::createTempRead(makeArray("batched"), Expr::Int8);
+  constraints_ty constraints{
+      UltExpr::create(byte, ConstantExpr::create(3, Expr::Int8))};
+
+  std::vector<ref<Expr>> conditions;
+  for (unsigned i = 0; i < 5; ++i)
+    conditions.push_back(byteIs(byte, i));
+  conditions.push_back(Expr::createTrue());
+  const std::vector<bool> expected{true, true, true, false, false, true};
+
+  // Directly on the core solver, every condition is checked again
+  std::unique_ptr<Solver> core = createTestSolver();
+  for (unsigned round = 0; round < 2; ++round) {
+    std::vector<bool> feasible;
+    ASSERT_TRUE(core->mayBeTrue(
+        Query(constraints, ConstantExpr::alloc(0, Expr::Bool)), conditions,
+        feasible));
+    EXPECT_EQ(expected, feasible);
+  }
+
+  // Through the caches, the second time without reaching the core solver
+  std::unique_ptr<Solver> cached = createCexCachingSolver(
+      createCachingSolver(createIndependentSolver(createTestSolver())));
+  for (unsigned round = 0; round < 2; ++round) {
+    uint64_t queries = stats::solverQueries;
+    std::vector<bool> feasible;
+    ASSERT_TRUE(cached->mayBeTrue(
+        Query(constraints, ConstantExpr::alloc(0, Expr::Bool)), conditions,
+        feasible));
+    EXPECT_EQ(expected, feasible);
+    if (round) {
+      EXPECT_EQ(queries, stats::solverQueries.getValue());
+    }
+  }
+
+  // Only the infeasibility was memorized, so truth is answered from the
+  // cache, while a validity core still comes from the solver
+  uint64_t queries = stats::solverQueries;
+  ref<Expr> notThree = Expr::createIsZero(conditions[3]);
+  bool result;
+  ASSERT_TRUE(cached->mustBeTrue(Query(constraints, notThree), result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(queries, stats::solverQueries.getValue());
+  if (!hasIncrementalBackend())
+    return;
+  ValidityCore validityCore;
+  ASSERT_TRUE(cached->getValidityCore(Query(constraints, notThree),
+                                      validityCore, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(notThree, validityCore.expr);
+  EXPECT_EQ(ValidityCore::constraints_typ(constraints.begin(),
+                                          constraints.end()),
+            validityCore.constraints);
+}
+
+TEST(SolverTest, TermCacheAcrossQueries) {
+  if (!hasIncrementalBackend())
+    GTEST_SKIP() << "the core solver does not keep translated terms";
+  std::unique_ptr<Solver> solver = createTestSolver();
+  ref<Expr> byte = Expr::createTempRead(makeArray("translated"), Expr::Int8);
+  constraints_ty constraints{
+      UltExpr::create(byte, ConstantExpr::create(10, Expr::Int8))};
+
+  bool result;
+  ASSERT_TRUE(solver->mustBeTrue(
+      Query(constraints,
+            UltExpr::create(byte, ConstantExpr::create(20, Expr::Int8))),
+      result));
+  EXPECT_TRUE(result);
+
+  // The constraint and the read were translated by the first query
+  uint64_t hits = stats::queryTermCacheHits;
+  ASSERT_TRUE(solver->mustBeTrue(
+      Query(constraints,
+            UltExpr::create(byte, ConstantExpr::create(5, Expr::Int8))),
+      result));
+  EXPECT_FALSE(result);
+  EXPECT_LE(hits + 2, stats::queryTermCacheHits.getValue());
+}
+
+TEST(SolverTest, ReadOverWriteSolver) {
+  const Array *buffer = makeArray("buffer", 64);
+  ref<Expr> offset = Expr::createTempRead(makeArray("offset"), Expr::Int8);
+  ref<Expr> index = ZExtExpr::create(offset, Expr::Int32);
+  constraints_ty constraints{
+      UltExpr::create(offset, ConstantExpr::create(10, Expr::Int8))};
+
+  UpdateList updates(buffer, nullptr);
+  updates.extend(index, ConstantExpr::create(0xAA, Expr::Int8));
+  updates.extend(ConstantExpr::create(40, Expr::Int32),
+                 ConstantExpr::create(0xBB, Expr::Int8));
+  updates.extend(AddExpr::create(ConstantExpr::create(1, Expr::Int32), index),
+                 ConstantExpr::create(0xCC, Expr::Int8));
+  UpdateList initial(buffer, nullptr);
+  auto unchanged = [&](unsigned at) {
+    ref<Expr> i = ConstantExpr::create(at, Expr::Int32);
+    return EqExpr::create(ReadExpr::create(updates, i),
+                          ReadExpr::create(initial, i));
+  };
+
+  std::unique_ptr<Solver> solver =
+      createReadOverWriteSolver(createTestSolver());
+  solver->setCoreSolverTimeout(time::Span("10s"));
+
+  // None of the writes can reach index 50
+  uint64_t pruned = stats::queryPrunedWrites;
+  bool result;
+  ASSERT_TRUE(solver->mustBeTrue(Query(constraints, unchanged(50)), result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(pruned + 3, stats::queryPrunedWrites.getValue());
+
+  // Index 5 may be written by either symbolic write
+  ASSERT_TRUE(solver->mustBeTrue(Query(constraints, unchanged(5)), result));
+  EXPECT_FALSE(result);
+
+  // Cores of pruned queries keep the constraints the pruning relied on, so
+  // each is unsatisfiable together with the negated query
+  ref<Expr> bound = *constraints.begin();
+  ref<Expr> other = Expr::createTempRead(makeArray("unrelated"), Expr::Int8);
+  constraints_ty path{bound, byteIs(other, 1),
+                      EqExpr::create(ReadExpr::create(
+                                         updates, ConstantExpr::create(60, 32)),
+                                     other)};
+  std::unique_ptr<Solver> checker = createTestSolver();
+  for (unsigned at : {50u, 60u}) {
+    ValidityCore core;
+    ASSERT_TRUE(solver->getValidityCore(Query(path, unchanged(at)), core,
+                                        result));
+    EXPECT_TRUE(result);
+    EXPECT_EQ(unchanged(at), core.expr);
+    EXPECT_TRUE(core.constraints.count(bound));
+    ASSERT_TRUE(
+        checker->mustBeTrue(Query(core.constraints, core.expr), result));
+    EXPECT_TRUE(result);
+  }
+}
+
+TEST(SolverTest, ConflictCachingSolver) {
+  const Array *array = makeArray("conflicting", 2);
+  ref<Expr> first = Expr::createTempRead(array, Expr::Int8);
+  ref<Expr> second = ReadExpr::create(UpdateList(array, nullptr),
+                                      ConstantExpr::create(1, Expr::Int32));
+  ref<Expr> bounded =
+      UltExpr::create(first, ConstantExpr::create(5, Expr::Int8));
+  ref<Expr> unrelated =
+      UltExpr::create(second, ConstantExpr::create(7, Expr::Int8));
+  ref<Expr> below10 =
+      UltExpr::create(first, ConstantExpr::create(10, Expr::Int8));
+
+  std::unique_ptr<Solver> solver =
+      createConflictCachingSolver(createTestSolver());
+  solver->setCoreSolverTimeout(time::Span("10s"));
+
+  // Truth alone comes without a core, so nothing is learned from it
+  uint64_t hits = stats::queryConflictCacheHits;
+  bool result;
+  for (unsigned round = 0; round < 2; ++round) {
+    ASSERT_TRUE(solver->mustBeTrue(
+        Query(constraints_ty{bounded, unrelated}, below10), result));
+    EXPECT_TRUE(result);
+  }
+  EXPECT_EQ(hits, stats::queryConflictCacheHits.getValue());
+
+  ValidityCore core;
+  ASSERT_TRUE(solver->getValidityCore(
+      Query(constraints_ty{bounded, unrelated}, below10), core, result));
+  EXPECT_TRUE(result);
+
+  // A longer path carrying the same constraints hits the conflict
+  constraints_ty longer{bounded, unrelated, byteIs(second, 3)};
+  ASSERT_TRUE(solver->getValidityCore(Query(longer, below10), core, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(hits + 1, stats::queryConflictCacheHits.getValue());
+  EXPECT_EQ(below10, core.expr);
+  for (const auto &constraint : core.constraints)
+    EXPECT_TRUE(longer.count(constraint));
+
+  // Conflicts are only used for the queries containing them
+  ASSERT_TRUE(solver->mustBeTrue(
+      Query(longer,
+            UltExpr::create(first, ConstantExpr::create(3, Expr::Int8))),
+      result));
+  EXPECT_FALSE(result);
+  EXPECT_EQ(hits + 1, stats::queryConflictCacheHits.getValue());
+
+  // Infeasible branch conditions come without cores either
+  std::vector<ref<Expr>> conditions{byteIs(first, 7), byteIs(first, 1)};
+  for (unsigned round = 0; round < 2; ++round) {
+    std::vector<bool> feasible;
+    ASSERT_TRUE(solver->mayBeTrue(Query(longer, Expr::createFalse()),
+                                  conditions, feasible));
+    EXPECT_EQ(std::vector<bool>({false, true}), feasible);
+  }
+  EXPECT_EQ(hits + 1, stats::queryConflictCacheHits.getValue());
+
+  if (hasIncrementalBackend()) {
+    // The conflict is the core, not every constraint of the query
+    ASSERT_TRUE(solver->mustBeTrue(
+        Query(constraints_ty{bounded, byteIs(second, 3)}, below10), result));
+    EXPECT_TRUE(result);
+    EXPECT_EQ(hits + 2, stats::queryConflictCacheHits.getValue());
+  }
+
+  // The least recently used conflicts are dropped
+  ConflictCacheSize = 1;
+  std::unique_ptr<Solver> small =
+      createConflictCachingSolver(createTestSolver());
+  small->setCoreSolverTimeout(time::Span("10s"));
+  ref<Expr> below20 =
+      UltExpr::create(first, ConstantExpr::create(20, Expr::Int8));
+  hits = stats::queryConflictCacheHits;
+  for (ref<Expr> expr : {below10, below20, below10}) {
+    ASSERT_TRUE(small->getValidityCore(Query(constraints_ty{bounded}, expr),
+                                       core, result));
+    EXPECT_TRUE(result);
+  }
+  EXPECT_EQ(hits, stats::queryConflictCacheHits.getValue());
+  ConflictCacheSize = 1 << 14;
+}
+
+TEST(SolverTest, TracingSolver) {
+  std::string path = makeTemporaryPath("klee-solver-trace");
+  ref<Expr> byte = Expr::createTempRead(makeArray("traced"), Expr::Int8);
+  constraints_ty constraints{
+      UltExpr::create(byte, ConstantExpr::create(10, Expr::Int8))};
+  ref<Expr> below20 =
+      UltExpr::create(byte, ConstantExpr::create(20, Expr::Int8));
+
+  {
+    std::shared_ptr<SolverTracer> tracer = createSolverTracer(path, 2, 1);
+    std::unique_ptr<Solver> solver =
+        createTracingSolver(createTestSolver(), tracer, "Core");
+    solver = createTracingSolver(createCachingSolver(std::move(solver)),
+                                 tracer, "BranchCache");
+    bool result;
+    for (unsigned round = 0; round < 2; ++round) {
+      ASSERT_TRUE(solver->mustBeTrue(Query(constraints, below20), result));
+      EXPECT_TRUE(result);
+    }
+  }
+
+  std::ifstream in(path);
+  std::string trace((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  unlink(path.c_str());
+
+  // Only the latest two of three events are kept: the first query passed the
+  // cache and was answered by the core solver (whose event was dropped), the
+  // second one was answered by the cache
+  EXPECT_NE(std::string::npos, trace.find("\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, trace.find("\"recordedEvents\":3"));
+  EXPECT_EQ(std::string::npos, trace.find("\"name\":\"Core\""));
+  std::size_t missed = trace.find("\"name\":\"BranchCache\"");
+  std::size_t hit = trace.find("\"name\":\"BranchCache\"", missed + 1);
+  ASSERT_NE(std::string::npos, hit);
+  EXPECT_EQ(trace.find("\"answered\":false", missed),
+            trace.find("\"answered\":", missed));
+  EXPECT_EQ(trace.find("\"answered\":true", hit),
+            trace.find("\"answered\":", hit));
+}
+
+TEST(SolverTest, TracingSolverPortfolio) {
+  std::string path = makeTemporaryPath("klee-solver-trace");
+  ref<Expr> byte =
+      Expr::createTempRead(makeArray("portfolioTraced"), Expr::Int8);
+  constraints_ty constraints{
+      UltExpr::create(byte, ConstantExpr::create(10, Expr::Int8))};
+  ref<Expr> below20 =
+      UltExpr::create(byte, ConstantExpr::create(20, Expr::Int8));
+
+  {
+    std::shared_ptr<SolverTracer> tracer = createSolverTracer(path, 16, 1);
+    std::vector<std::unique_ptr<Solver>> solvers;
+    solvers.push_back(createTracingSolver(createTestSolver(), tracer, "Core"));
+    solvers.push_back(createTracingSolver(createTestSolver(), tracer, "Core"));
+    std::unique_ptr<Solver> solver = createTracingSolver(
+        createPortfolioSolver(std::move(solvers)), tracer, "Portfolio");
+    bool result;
+    ASSERT_TRUE(solver->mustBeTrue(Query(constraints, below20), result));
+    EXPECT_TRUE(result);
+  }
+
+  std::ifstream in(path);
+  std::string trace((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  unlink(path.c_str());
+
+  // The core solvers raced in workers, and the winner sent its span back
+  // along with the answer
+  EXPECT_NE(std::string::npos, trace.find("\"recordedEvents\":2"));
+  std::size_t core = trace.find("\"name\":\"Core\"");
+  std::size_t portfolio = trace.find("\"name\":\"Portfolio\"");
+  ASSERT_NE(std::string::npos, core);
+  ASSERT_NE(std::string::npos, portfolio);
+  EXPECT_NE(trace.find("\"instance\":3", core),
+            trace.find("\"instance\":", core));
+  EXPECT_EQ(trace.find("\"instance\":3", portfolio),
+            trace.find("\"instance\":", portfolio));
+  std::string parent = "\"pid\":" + std::to_string(getpid()) + ",";
+  EXPECT_NE(trace.find(parent, core), trace.find("\"pid\":", core));
+  EXPECT_EQ(trace.find(parent, portfolio),
+            trace.find("\"pid\":", portfolio));
+  EXPECT_EQ(trace.find("\"answered\":false", portfolio),
+            trace.find("\"answered\":", portfolio));
+}
+
 } // namespace
@@ -56,3 +56,37 @@ TEST(StorageTest, FixedSizeStorageAdapter) {
   }
   ASSERT_EQ(sum, 3);
 }
+
+TEST(StorageTest, PagedArrayAdapter) {
+  using Adapter = PagedArrayAdapter<unsigned char>;
+  Adapter a(0, 3 * Adapter::PageSize + 7);
+  ASSERT_TRUE(a.empty());
+  a.set(1, 1);
+  a.set(2 * Adapter::PageSize, 2);
+  a.set(3 * Adapter::PageSize + 6, 3);
+  ASSERT_EQ(a.size(), 3u);
+
+  Adapter b(a);
+  b.set(1, 4);
+  b.remove(2 * Adapter::PageSize);
+  ASSERT_EQ(a.at(1), 1);
+  ASSERT_EQ(a.at(2 * Adapter::PageSize), 2);
+  ASSERT_EQ(b.at(1), 4);
+  ASSERT_EQ(b.at(2 * Adapter::PageSize), 0);
+  ASSERT_EQ(b.lookup(2 * Adapter::PageSize), nullptr);
+  ASSERT_EQ(a.size(), 3u);
+  ASSERT_EQ(b.size(), 2u);
+
+  size_t keys = 0;
+  int sum = 0;
+  for (const auto &val : b) {
+    keys += val.first;
+    sum += val.second;
+  }
+  ASSERT_EQ(keys, 3 * Adapter::PageSize + 7);
+  ASSERT_EQ(sum, 7);
+
+  a.clear();
+  ASSERT_TRUE(a.empty());
+  ASSERT_EQ(b.at(3 * Adapter::PageSize + 6), 3);
+}